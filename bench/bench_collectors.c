@@ -0,0 +1,142 @@
+#define _GNU_SOURCE
+#include "bench_common.h"
+#include "collectors.h"
+#include "dev_stats.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Microbenchmark: ns per sample for each /proc collector, comparing the original
+// fopen/fgets/sscanf readers against the persistent-fd proc_file_t readers.
+
+// ---- Legacy stdio collectors (as shipped before the proc_file_t layer) ----
+
+static int legacy_cpu(cpu_times_t *t) {
+    char line[512];
+    FILE *f = fopen("/proc/stat", "r");
+    if (!f) return -1;
+    if (!fgets(line, sizeof(line), f)) { fclose(f); return -1; }
+    fclose(f);
+    int n = sscanf(line, "cpu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                   &t->user, &t->nice, &t->system, &t->idle, &t->iowait,
+                   &t->irq, &t->softirq, &t->steal, &t->guest, &t->guest_nice);
+    return (n >= 4) ? 0 : -1;
+}
+
+static double legacy_mem(void) {
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (!f) return -1.0;
+    char key[64]; unsigned long long val; char unit[16];
+    unsigned long long memTotal=0, memAvailable=0;
+    while (fscanf(f, "%63s %llu %15s", key, &val, unit) == 3) {
+        if (strcmp(key, "MemTotal:") == 0) memTotal = val;
+        else if (strcmp(key, "MemAvailable:") == 0) { memAvailable = val; break; }
+    }
+    fclose(f);
+    if (memTotal == 0) return -1.0;
+    return 100.0 * (double)(memTotal - memAvailable) / (double)memTotal;
+}
+
+static int legacy_disk(unsigned long long *reads, unsigned long long *writes) {
+    FILE *f = fopen("/proc/diskstats", "r");
+    if (!f) return -1;
+    unsigned long long r=0,w=0; char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned int major, minor; char name[64];
+        unsigned long long rd_ios, rd_merges, rd_sectors, rd_ticks;
+        unsigned long long wr_ios, wr_merges, wr_sectors, wr_ticks;
+        int n = sscanf(line, "%u %u %63s %llu %llu %llu %llu %llu %llu %llu %llu",
+                       &major, &minor, name,
+                       &rd_ios, &rd_merges, &rd_sectors, &rd_ticks,
+                       &wr_ios, &wr_merges, &wr_sectors, &wr_ticks);
+        if (n >= 11) { r += rd_sectors; w += wr_sectors; }
+    }
+    fclose(f);
+    *reads = r; *writes = w;
+    return 0;
+}
+
+static int legacy_net(unsigned long long *rx, unsigned long long *tx) {
+    FILE *f = fopen("/proc/net/dev", "r");
+    if (!f) return -1;
+    char line[512]; int lineNo=0;
+    unsigned long long r=0,t=0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        if (lineNo <= 2) continue;
+        char iface[64]; unsigned long long rbytes, others[7], tbytes, others2[7];
+        int n = sscanf(line, " %63[^:]: %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu",
+                       iface,
+                       &rbytes, &others[0], &others[1], &others[2], &others[3], &others[4], &others[5], &others[6],
+                       &tbytes, &others2[0], &others2[1], &others2[2], &others2[3], &others2[4]);
+        if (n >= 10) { r += rbytes; t += tbytes; }
+    }
+    fclose(f);
+    *rx = r; *tx = t;
+    return 0;
+}
+
+// ---- Harness ----
+
+static volatile unsigned long long g_sink;
+
+static void report(const char *name, uint64_t legacy_ns, uint64_t fast_ns, int iters) {
+    double l = (double)legacy_ns / iters, f = (double)fast_ns / iters;
+    printf("%-10s legacy %9.0f ns/sample   proc_file %9.0f ns/sample   speedup %5.2fx\n",
+           name, l, f, f > 0 ? l / f : 0.0);
+}
+
+int main(int argc, char **argv) {
+    int iters = (argc > 1) ? atoi(argv[1]) : 20000;
+    if (iters <= 0) iters = 20000;
+    proc_file_t stat, mem, disk, net;
+    if (pf_open(&stat, "/proc/stat", 4096) || pf_open(&mem, "/proc/meminfo", 4096) ||
+        pf_open(&disk, "/proc/diskstats", 4096) || pf_open(&net, "/proc/net/dev", 4096)) {
+        perror("pf_open");
+        return 1;
+    }
+    cpu_times_t ct; unsigned long long a = 0, b = 0; uint64_t t0, t1, t2, sa, sb;
+    dev_table_t disks, ifaces;
+    dev_table_init(&disks, DEV_DISK, NULL); dev_table_init(&ifaces, DEV_NET, NULL);
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) { legacy_cpu(&ct); g_sink += ct.user; }
+    t1 = now_ns();
+    for (int i = 0; i < iters; i++) { read_cpu_times(&stat, &ct); g_sink += ct.user; }
+    t2 = now_ns();
+    report("cpu", t1 - t0, t2 - t1, iters);
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) g_sink += (unsigned long long)legacy_mem();
+    t1 = now_ns();
+    for (int i = 0; i < iters; i++) g_sink += (unsigned long long)read_mem_usage_percent(&mem);
+    t2 = now_ns();
+    report("mem", t1 - t0, t2 - t1, iters);
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) { legacy_disk(&a, &b); g_sink += a + b; }
+    t1 = now_ns();
+    for (int i = 0; i < iters; i++) {
+        if (pf_read(&disk) >= 0) dev_parse_diskstats(&disks, disk.buf);
+        dev_table_sum(&disks, &sa, &sb); g_sink += sa + sb;
+    }
+    t2 = now_ns();
+    report("disk", t1 - t0, t2 - t1, iters);
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) { legacy_net(&a, &b); g_sink += a + b; }
+    t1 = now_ns();
+    for (int i = 0; i < iters; i++) {
+        if (pf_read(&net) >= 0) dev_parse_net_dev(&ifaces, net.buf);
+        dev_table_sum(&ifaces, &sa, &sb); g_sink += sa + sb;
+    }
+    t2 = now_ns();
+    report("net", t1 - t0, t2 - t1, iters);
+
+    dev_table_free(&disks); dev_table_free(&ifaces);
+    pf_close(&stat); pf_close(&mem); pf_close(&disk); pf_close(&net);
+    return 0;
+}
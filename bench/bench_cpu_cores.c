@@ -0,0 +1,57 @@
+#define _GNU_SOURCE
+#include "bench_common.h"
+#include "cpu_cores.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Per-tick cost of the per-core CPU collector as the core count grows: parsing a
+// synthetic /proc/stat with N cpuN lines, then the delta kernel (scalar vs dispatched).
+
+static char *synth_stat(int ncores, unsigned long long base) {
+    size_t cap = (size_t)(ncores + 2) * 128 + 4096;
+    char *buf = malloc(cap);
+    size_t off = (size_t)snprintf(buf, cap, "cpu  %llu 0 %llu %llu 0 0 0 0 0 0\n",
+                                  base * ncores, base * ncores / 2, base * ncores * 3);
+    for (int i = 0; i < ncores; i++) {
+        unsigned long long b = base + (unsigned long long)i * 7;
+        off += (size_t)snprintf(buf + off, cap - off, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu 0 0\n",
+                                i, b, b / 9, b / 2, b * 3, b / 20, b / 50, b / 40, b / 100);
+    }
+    snprintf(buf + off, cap - off, "intr 123456 0 0 0 0 0 0 0 0 0 0 0\nctxt 987654\n");
+    return buf;
+}
+
+static volatile double g_sink;
+
+int main(int argc, char **argv) {
+    int iters = (argc > 1) ? atoi(argv[1]) : 2000;
+    if (iters <= 0) iters = 2000;
+    printf("kernel: %s\n", cpu_cores_kernel_name());
+    printf("%6s %14s %14s %14s %14s\n", "cores", "parse ns/tick", "scalar ns/tick", "simd ns/tick", "total ns/core");
+    for (int n = 1; n <= 1024; n *= 2) {
+        char *a = synth_stat(n, 1000000), *b = synth_stat(n, 1000450);
+        cpu_cores_t prev, cur; cpu_core_pct_t pct;
+        cpu_cores_init(&prev); cpu_cores_init(&cur); cpu_core_pct_init(&pct);
+        parse_cpu_cores(a, &prev);
+        parse_cpu_cores(b, &cur);
+        cpu_cores_delta(&prev, &cur, &pct); // sizes the output arrays
+
+        uint64_t t0 = now_ns();
+        for (int i = 0; i < iters; i++) parse_cpu_cores((i & 1) ? a : b, &cur);
+        uint64_t t1 = now_ns();
+        parse_cpu_cores(b, &cur);
+        for (int i = 0; i < iters; i++) { cpu_cores_delta_scalar(&prev, &cur, &pct, n); g_sink += pct.busy[0]; }
+        uint64_t t2 = now_ns();
+        for (int i = 0; i < iters; i++) { cpu_cores_delta(&prev, &cur, &pct); g_sink += pct.busy[0]; }
+        uint64_t t3 = now_ns();
+
+        double parse = (double)(t1 - t0) / iters, scalar = (double)(t2 - t1) / iters, simd = (double)(t3 - t2) / iters;
+        printf("%6d %14.0f %14.0f %14.0f %14.1f\n", n, parse, scalar, simd, (parse + simd) / n);
+        cpu_cores_free(&prev); cpu_cores_free(&cur); cpu_core_pct_free(&pct);
+        free(a); free(b);
+    }
+    return 0;
+}
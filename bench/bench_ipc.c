@@ -0,0 +1,163 @@
+#define _GNU_SOURCE
+#include "bench_common.h"
+#include "shm_metrics.h"
+
+#include <fcntl.h>
+#include <mqueue.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Latency benchmark for the live metrics channel: a writer thread publishes N samples
+// stamped with CLOCK_MONOTONIC, a reader thread records publish-to-read latency.
+// Compares the shared-memory region (futex wake) with the POSIX mqueue text summary
+// the monitor used before, and measures how long the writer stalls when the reader is
+// slow (mqueue blocks once its 10 slots fill; shm never does).
+
+#define BENCH_SHM_NAME "/sysmon_bench_shm"
+#define BENCH_MQ_NAME "/sysmon_bench_mq"
+
+static void sleep_ns(long ns) {
+    struct timespec ts = { 0, ns };
+    nanosleep(&ts, NULL);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    int n;
+    long gap_ns;        // writer pause between samples
+    long reader_ns;     // extra work per sample in the reader (simulates a slow consumer)
+    uint64_t *lat;      // per-sample publish-to-read latency, filled by the reader
+    int got;
+    _Atomic int done;   // writer finished; the shm reader may have lost samples on the ring
+    uint64_t *stall;    // per-sample writer publish time
+    shm_metrics_t *shm;
+    mqd_t mq;
+} bench_t;
+
+// ---- Shared memory ----
+
+static void *shm_reader(void *arg) {
+    bench_t *b = arg;
+    const shm_metrics_t *shm = shm_metrics_attach(BENCH_SHM_NAME);
+    if (!shm) return NULL;
+    uint64_t cursor = 0;
+    uint32_t gen = 0;
+    shm_sample_t batch[64];
+    while (b->got < b->n) {
+        int done = atomic_load(&b->done);
+        size_t k = shm_metrics_read(shm, METRIC_CPU, &cursor, batch, 64);
+        uint64_t t = now_ns();
+        for (size_t i = 0; i < k && b->got < b->n; i++) {
+            b->lat[b->got++] = t - (uint64_t)batch[i].v2;
+            if (b->reader_ns) sleep_ns(b->reader_ns);
+        }
+        if (k == 0) {
+            if (done) break;
+            gen = shm_metrics_wait(shm, gen, 10);
+        }
+    }
+    shm_metrics_detach(shm);
+    return NULL;
+}
+
+static void shm_writer(bench_t *b) {
+    for (int i = 0; i < b->n; i++) {
+        uint64_t t0 = now_ns();
+        metric_t m = { METRIC_CPU, 0, 42.0, (double)t0, t0 / 1000000ULL, 0 };
+        shm_metrics_publish(b->shm, &m);
+        shm_metrics_notify(b->shm);
+        b->stall[i] = now_ns() - t0;
+        if (b->gap_ns) sleep_ns(b->gap_ns);
+    }
+}
+
+// ---- POSIX mqueue (legacy summary path) ----
+
+static void *mq_reader(void *arg) {
+    bench_t *b = arg;
+    mqd_t q = mq_open(BENCH_MQ_NAME, O_RDONLY);
+    if (q == (mqd_t)-1) return NULL;
+    char buf[128];
+    while (b->got < b->n) {
+        if (mq_receive(q, buf, sizeof(buf), NULL) < 0) break;
+        uint64_t t = now_ns();
+        double cpu, mem;
+        unsigned long long sent;
+        if (sscanf(buf, "CPU=%lf%% MEM=%lf%% T=%llu", &cpu, &mem, &sent) == 3)
+            b->lat[b->got++] = t - sent;
+        if (b->reader_ns) sleep_ns(b->reader_ns);
+    }
+    mq_close(q);
+    return NULL;
+}
+
+static void mq_writer(bench_t *b) {
+    for (int i = 0; i < b->n; i++) {
+        uint64_t t0 = now_ns();
+        char msg[128];
+        snprintf(msg, sizeof(msg), "CPU=%.1f%% MEM=%.1f%% T=%llu", 42.0, 58.0, (unsigned long long)t0);
+        mq_send(b->mq, msg, strlen(msg) + 1, 0);
+        b->stall[i] = now_ns() - t0;
+        if (b->gap_ns) sleep_ns(b->gap_ns);
+    }
+}
+
+static void report(const char *name, const char *mode, bench_t *b) {
+    qsort(b->lat, (size_t)b->got, sizeof(uint64_t), cmp_u64);
+    qsort(b->stall, (size_t)b->n, sizeof(uint64_t), cmp_u64);
+    if (b->got == 0) { printf("%-5s %-10s no samples received\n", name, mode); return; }
+    printf("%-5s %-10s recv=%-6d latency p50=%8llu ns p99=%9llu ns   writer p50=%6llu ns max=%9llu ns\n",
+           name, mode, b->got,
+           (unsigned long long)b->lat[b->got / 2], (unsigned long long)b->lat[(size_t)(b->got * 0.99)],
+           (unsigned long long)b->stall[b->n / 2], (unsigned long long)b->stall[b->n - 1]);
+}
+
+static void run(const char *mode, int n, long gap_ns, long reader_ns) {
+    bench_t b = { .n = n, .gap_ns = gap_ns, .reader_ns = reader_ns };
+    b.lat = calloc((size_t)n, sizeof(uint64_t));
+    b.stall = calloc((size_t)n, sizeof(uint64_t));
+    pthread_t th;
+
+    b.shm = shm_metrics_create(BENCH_SHM_NAME);
+    if (!b.shm) { perror("shm_metrics_create"); exit(1); }
+    pthread_create(&th, NULL, shm_reader, &b);
+    sleep_ns(10000000);
+    shm_writer(&b);
+    atomic_store(&b.done, 1);
+    pthread_join(th, NULL);
+    shm_metrics_destroy(b.shm, BENCH_SHM_NAME);
+    report("shm", mode, &b);
+
+    b.got = 0;
+    struct mq_attr attr = { .mq_maxmsg = 10, .mq_msgsize = 128 };
+    b.mq = mq_open(BENCH_MQ_NAME, O_CREAT | O_WRONLY, 0644, &attr);
+    if (b.mq == (mqd_t)-1) { perror("mq_open"); exit(1); }
+    pthread_create(&th, NULL, mq_reader, &b);
+    mq_writer(&b);
+    pthread_join(th, NULL);
+    mq_close(b.mq);
+    mq_unlink(BENCH_MQ_NAME);
+    report("mq", mode, &b);
+
+    free(b.lat);
+    free(b.stall);
+}
+
+int main(int argc, char **argv) {
+    int n = (argc > 1) ? atoi(argv[1]) : 2000;
+    if (n < 10) n = 10;
+    printf("bench_ipc: %d samples per run\n", n);
+    run("paced", n, 100000, 0);       // one sample per 100us, reader keeps up
+    run("burst", n, 0, 0);            // back-to-back publishes
+    run("slow-rdr", n / 10, 0, 200000); // reader spends 200us per sample
+    return 0;
+}
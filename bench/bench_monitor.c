@@ -0,0 +1,512 @@
+#define _GNU_SOURCE
+#include "bench_common.h"
+#include "monitor.h"
+#include "collectors.h"
+#include "cpu_cores.h"
+#include "dev_stats.h"
+#include "log_sink.h"
+#include "metric_format.h"
+#include "shm_metrics.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Monitor benchmark suite on libsysmon.a, reproducible from build to build:
+//   parse    ns per parse of each /proc file, replaying the snapshot pairs in
+//            bench/fixtures/host64 (a synthetic 64-CPU host: 17 block devices, 8
+//            interfaces) instead of the live /proc of whatever machine runs it, plus
+//            a generated /proc/net/dev with 4096 veths, steady and with one veth
+//            replaced per tick (a device table rebuild every parse)
+//   queue    mq_push/mq_pop throughput and push latency with 1..8 producers
+//   logger   log_sink write + flush throughput for each log format
+//   format   ns per CSV line, metric_format_csv against the snprintf formatter it
+//            replaced, and a check that both print the same bytes
+//   drain    the logger loop fed through the ring by a producer paced at 100k
+//            metrics/s (logger CPU time per metric), then unpaced (metrics/s): the
+//            batched mq_pop_batch + log_sink loop against the per-metric mq_pop +
+//            snprintf + fflush loop it replaced
+//   e2e      sample-to-IPC latency through a running monitor_run: a probe thread
+//            reads and parses /proc/stat, pushes a metric stamped at the start of the
+//            read, and a shm reader measures when it shows up in the live region
+// Human-readable lines go to stdout. `-o FILE` also writes one "suite<TAB>name<TAB>
+// value<TAB>unit" line per figure; scripts/bench_compare.sh diffs two such files.
+// The logger and e2e runs work in a temporary directory.
+
+#define FIXTURE_DIR "bench/fixtures/host64"
+#define E2E_SHM_NAME "/sysmon_bench_e2e"
+
+static FILE *g_out;
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void result(const char *suite, const char *name, double value, const char *unit) {
+    if (g_out) fprintf(g_out, "%s\t%s\t%.3f\t%s\n", suite, name, value, unit);
+}
+
+static char *slurp(const char *dir, const char *name) {
+    char path[PATH_MAX + 32];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return NULL; }
+    char *buf = malloc(1 << 16);
+    size_t n = buf ? fread(buf, 1, (1 << 16) - 1, f) : 0;
+    fclose(f);
+    if (buf) buf[n] = 0;
+    return buf;
+}
+
+// ---- parse ----
+
+static volatile double g_sink;
+
+static void parse_report(const char *name, uint64_t ns, int iters) {
+    double per = (double)ns / iters;
+    printf("  %-12s %9.0f ns/parse\n", name, per);
+    result("parse", name, per, "ns");
+}
+
+// /proc/net/dev with lo, eth0 and n veths; every 16th interface moves each generation
+// and, with `churn`, veth number gen % n is replaced by a new one.
+static char *veth_net_dev(int n, unsigned gen, bool churn) {
+    size_t cap = 256 + (size_t)(n + 2) * 160, len = 0;
+    char *buf = malloc(cap);
+    if (!buf) return NULL;
+    len += (size_t)snprintf(buf, cap, "Inter-|   Receive                                                |  Transmit\n"
+                            " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n");
+    for (int i = -2; i < n; i++) {
+        char name[24];
+        if (i == -2) snprintf(name, sizeof(name), "lo");
+        else if (i == -1) snprintf(name, sizeof(name), "eth0");
+        else snprintf(name, sizeof(name), "veth%x%s", (unsigned)i, churn && (unsigned)i == gen % (unsigned)n ? "n" : "");
+        unsigned long long rx = 1000000ULL * (unsigned)(i + 3) + ((i & 15) == 0 ? gen * 1500ULL : 0), tx = rx / 2;
+        len += (size_t)snprintf(buf + len, cap - len, "%*s: %llu %llu 0 0 0 0 0 0 %llu %llu 0 0 0 0 0 0\n",
+                                10, name, rx, rx / 1000, tx, tx / 1000);
+    }
+    return buf;
+}
+
+static void parse_veths(const char *name, int n, bool churn, int iters) {
+    char *buf[2] = { veth_net_dev(n, 0, churn), veth_net_dev(n, 1, churn) };
+    dev_table_t t;
+    dev_table_init(&t, DEV_NET, NULL);
+    if (buf[0] && buf[1]) {
+        dev_parse_net_dev(&t, buf[0]);
+        uint64_t a, b, t0 = now_ns();
+        for (int i = 0; i < iters; i++) { dev_parse_net_dev(&t, buf[(i + 1) & 1]); dev_table_sum(&t, &a, &b); g_sink += (double)(a + b); }
+        parse_report(name, now_ns() - t0, iters);
+    }
+    dev_table_free(&t);
+    free(buf[0]); free(buf[1]);
+}
+
+static int bench_parse(const char *dir, int iters) {
+    const char *files[] = { "stat", "stat.1", "meminfo", "diskstats", "diskstats.1", "net_dev", "net_dev.1" };
+    char *buf[7];
+    for (int i = 0; i < 7; i++) if (!(buf[i] = slurp(dir, files[i]))) return -1;
+    printf("parse (%s)\n", dir);
+    cpu_times_t ct[2];
+    cpu_cores_t cores[2];
+    cpu_core_pct_t pct;
+    cpu_cores_init(&cores[0]); cpu_cores_init(&cores[1]); cpu_core_pct_init(&pct);
+    dev_table_t disks, ifaces;
+    dev_table_init(&disks, DEV_DISK, NULL); dev_table_init(&ifaces, DEV_NET, NULL);
+    uint64_t a, b, t0;
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) {
+        parse_cpu_times(buf[i & 1], &ct[i & 1]);
+        if (i) g_sink += cpu_busy_percent(&ct[(i - 1) & 1], &ct[i & 1]);
+    }
+    parse_report("cpu", now_ns() - t0, iters);
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) {
+        parse_cpu_cores(buf[i & 1], &cores[i & 1]);
+        if (i && cpu_cores_delta(&cores[(i - 1) & 1], &cores[i & 1], &pct) == 0) g_sink += pct.busy[0];
+    }
+    parse_report("cpu_cores", now_ns() - t0, iters);
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) g_sink += parse_mem_usage_percent(buf[2]);
+    parse_report("mem", now_ns() - t0, iters);
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) { dev_parse_diskstats(&disks, buf[3 + (i & 1)]); dev_table_sum(&disks, &a, &b); g_sink += (double)(a + b); }
+    parse_report("disk", now_ns() - t0, iters);
+
+    t0 = now_ns();
+    for (int i = 0; i < iters; i++) { dev_parse_net_dev(&ifaces, buf[5 + (i & 1)]); dev_table_sum(&ifaces, &a, &b); g_sink += (double)(a + b); }
+    parse_report("net", now_ns() - t0, iters);
+
+    parse_veths("net_4k_veth", 4096, false, iters / 100 + 1);
+    parse_veths("net_4k_churn", 4096, true, iters / 100 + 1);
+
+    cpu_cores_free(&cores[0]); cpu_cores_free(&cores[1]); cpu_core_pct_free(&pct);
+    dev_table_free(&disks); dev_table_free(&ifaces);
+    for (int i = 0; i < 7; i++) free(buf[i]);
+    return 0;
+}
+
+// ---- queue ----
+
+typedef struct { metric_queue_t *q; long msgs; uint64_t *lat; } producer_arg_t;
+
+static void *producer(void *arg) {
+    producer_arg_t *a = arg;
+    metric_t m = { .kind = METRIC_CPU, .v1 = 1.0 };
+    for (long i = 0; i < a->msgs; i++) {
+        uint64_t t0 = now_ns();
+        mq_push(a->q, &m);
+        a->lat[i] = now_ns() - t0;
+    }
+    return NULL;
+}
+
+static void bench_queue(long msgs) {
+    printf("queue\n");
+    metric_queue_t *q = aligned_alloc(MQ_CACHELINE, sizeof(*q));
+    uint64_t *lat = malloc(sizeof(uint64_t) * (size_t)msgs);
+    if (!q || !lat) { free(q); free(lat); return; }
+    for (int p = 1; p <= 8; p *= 2) {
+        mq_init(q);
+        long per = msgs / p, total = per * p;
+        pthread_t th[8];
+        producer_arg_t args[8];
+        uint64_t t0 = now_ns();
+        for (int i = 0; i < p; i++) {
+            args[i] = (producer_arg_t){ q, per, lat + i * per };
+            pthread_create(&th[i], NULL, producer, &args[i]);
+        }
+        metric_t m;
+        for (long got = 0; got < total; got++) mq_pop(q, &m);
+        uint64_t elapsed = now_ns() - t0;
+        for (int i = 0; i < p; i++) pthread_join(th[i], NULL);
+        qsort(lat, (size_t)total, sizeof(uint64_t), cmp_u64);
+        double rate = (double)total * 1e9 / (double)elapsed;
+        uint64_t p99 = lat[(size_t)(total * 0.99)];
+        printf("  producers=%d %12.0f msg/s   push p50=%llu ns p99=%llu ns\n", p, rate,
+               (unsigned long long)lat[total / 2], (unsigned long long)p99);
+        char name[32];
+        snprintf(name, sizeof(name), "p%d.rate", p);
+        result("queue", name, rate, "msg/s");
+        snprintf(name, sizeof(name), "p%d.push_p99", p);
+        result("queue", name, (double)p99, "ns");
+        mq_destroy(q);
+    }
+    free(lat);
+    free(q);
+}
+
+// ---- logger ----
+
+// A monitor tick on the fixture host: CPU, MEM, DISK, NET, then a user/system and an
+// iowait/steal row per core.
+static size_t tick_mix(metric_t *out, uint64_t ts) {
+    size_t n = 0;
+    out[n++] = (metric_t){ .kind = METRIC_CPU, .v1 = 37.5, .ts_ms = ts };
+    out[n++] = (metric_t){ .kind = METRIC_MEM, .v1 = 61.2, .ts_ms = ts };
+    out[n++] = (metric_t){ .kind = METRIC_DISK, .v1 = 128, .v2 = 64, .ts_ms = ts };
+    out[n++] = (metric_t){ .kind = METRIC_NET, .v1 = 125000, .v2 = 98000, .ts_ms = ts };
+    for (uint32_t c = 0; c < 64; c++) {
+        out[n++] = (metric_t){ .kind = METRIC_CPU_CORE, .id = c, .v1 = 20 + c % 7, .v2 = 5 + c % 3, .ts_ms = ts };
+        out[n++] = (metric_t){ .kind = METRIC_CPU_CORE_WAIT, .id = c, .v1 = c % 2, .v2 = 0, .ts_ms = ts };
+    }
+    return n;
+}
+
+static void bench_logger(long msgs) {
+    static const struct { log_format_t f; const char *name; } fmts[] = {
+        { LOG_TEXT, "text" }, { LOG_BINARY, "binary" }, { LOG_TSDB, "tsdb" },
+    };
+    printf("logger\n");
+    metric_t mix[132];
+    for (size_t i = 0; i < sizeof(fmts) / sizeof(fmts[0]); i++) {
+        monitor_config_t cfg = { .log_format = fmts[i].f, .log_flush_ms = 1000 };
+        log_sink_t s;
+        if (log_sink_open(&s, &cfg) != 0) continue;
+        uint64_t ts = now_ms(), t0 = now_ns();
+        size_t n = 0;
+        for (long k = 0; k < msgs; k++) {
+            if (k % 132 == 0) { n = tick_mix(mix, ts); ts += 500; }
+            log_sink_metric(&s, &mix[k % n]);
+            log_sink_flush(&s);
+        }
+        log_sink_close(&s);
+        double rate = (double)msgs * 1e9 / (double)(now_ns() - t0);
+        printf("  %-8s %12.0f metrics/s\n", fmts[i].name, rate);
+        result("logger", fmts[i].name, rate, "metrics/s");
+    }
+}
+
+// ---- format ----
+
+// The text logger's formatter before metric_format_csv was hand-rolled, for the
+// kinds in tick_mix.
+static int legacy_format(char *buf, size_t cap, const metric_t *m) {
+    unsigned long long ts = (unsigned long long)m->ts_ms;
+    int n = 0;
+    switch (m->kind) {
+        case METRIC_CPU:
+        case METRIC_MEM:
+            n = snprintf(buf, cap, "%llu,%s,%.2f\n", ts, metric_kind_name(m->kind), m->v1);
+            break;
+        case METRIC_DISK:
+        case METRIC_NET:
+            n = snprintf(buf, cap, "%llu,%s,%.0f,%.0f\n", ts, metric_kind_name(m->kind), m->v1, m->v2);
+            break;
+        case METRIC_CPU_CORE:
+        case METRIC_CPU_CORE_WAIT:
+            n = snprintf(buf, cap, "%llu,%s,%u,%.2f,%.2f\n", ts, metric_kind_name(m->kind), m->id, m->v1, m->v2);
+            break;
+        default: return 0;
+    }
+    return (n < 0 || (size_t)n >= cap) ? 0 : n;
+}
+
+static void bench_format(long lines) {
+    printf("format\n");
+    metric_t mix[132];
+    size_t n = tick_mix(mix, now_ms());
+    // Realistic fractions (with ties and negative zero) for the equality check.
+    long mismatches = 0;
+    unsigned seed = 1;
+    for (long k = 0; k < 200000; k++) {
+        metric_t m = mix[k % n];
+        m.v1 = (double)rand_r(&seed) / RAND_MAX * (k % 3 ? 100.0 : 1e12) * (k % 97 ? 1 : -1);
+        m.v2 = k % 5 ? m.v1 / 3 : floor(m.v1 * 8) / 8;
+        if (k % 1001 == 0) m.v1 = -0.0;
+        char a[METRIC_LINE_MAX], b[METRIC_LINE_MAX];
+        int la = legacy_format(a, sizeof(a), &m), lb = metric_format_csv(b, sizeof(b), &m);
+        if (la != lb || memcmp(a, b, (size_t)la) != 0) {
+            if (mismatches++ < 3) printf("  mismatch: %.*s  vs %.*s", la, a, lb, b);
+        }
+    }
+    printf("  identical output: %s\n", mismatches ? "NO" : "yes");
+    char line[METRIC_LINE_MAX];
+    size_t bytes = 0;
+    uint64_t t0 = now_ns();
+    for (long k = 0; k < lines; k++) bytes += (size_t)legacy_format(line, sizeof(line), &mix[k % n]);
+    double legacy = (double)(now_ns() - t0) / lines;
+    t0 = now_ns();
+    for (long k = 0; k < lines; k++) bytes += (size_t)metric_format_csv(line, sizeof(line), &mix[k % n]);
+    double fast = (double)(now_ns() - t0) / lines;
+    g_sink = (double)bytes;
+    printf("  snprintf %6.1f ns/line   metric_format_csv %6.1f ns/line  (%.1fx)\n", legacy, fast, legacy / fast);
+    result("format", "snprintf", legacy, "ns");
+    result("format", "fast", fast, "ns");
+    result("format", "mismatches", (double)mismatches, "lines");
+}
+
+// ---- drain ----
+
+#define DRAIN_RATE 100000 // metrics/s for the paced runs
+
+typedef struct { metric_queue_t *q; long msgs; long rate; } feeder_arg_t;
+
+// Pushes tick_mix metrics, rate per second in 1 ms bursts (0 = as fast as possible),
+// then shuts the ring down so the consumer ends once it has drained it.
+static void *feeder(void *arg) {
+    feeder_arg_t *a = arg;
+    metric_t mix[132];
+    size_t n = tick_mix(mix, now_ms());
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    long per_ms = a->rate / 1000;
+    for (long k = 0; k < a->msgs; k++) {
+        mq_push(a->q, &mix[k % n]);
+        if (per_ms && (k + 1) % per_ms == 0) {
+            next.tv_nsec += 1000000;
+            if (next.tv_nsec >= 1000000000) { next.tv_sec++; next.tv_nsec -= 1000000000; }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+    }
+    mq_shutdown(a->q);
+    return NULL;
+}
+
+static uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// One consumer run; returns logger CPU ns per metric and sets *rate to metrics/s.
+static double drain_run(metric_queue_t *q, bool batched, long msgs, long pace, double *rate) {
+    mq_init(q);
+    unlink(TEXT_LOG_PATH);
+    monitor_config_t cfg = { .log_format = LOG_TEXT };
+    log_sink_t s;
+    FILE *f = NULL;
+    if (batched ? log_sink_open(&s, &cfg) != 0 : !(f = fopen(TEXT_LOG_PATH, "a"))) return NAN;
+    feeder_arg_t fa = { q, msgs, pace };
+    pthread_t th;
+    uint64_t t0 = now_ns(), c0 = thread_cpu_ns(), last = 0;
+    pthread_create(&th, NULL, feeder, &fa);
+    long got = 0;
+    if (batched) {
+        metric_t batch[256];
+        size_t n;
+        while ((n = mq_pop_batch(q, batch, 256)) > 0) {
+            for (size_t b = 0; b < n; b++) log_sink_metric(&s, &batch[b]);
+            log_sink_flush(&s);
+            last = now_ms(); // the loop's once-per-batch clock read
+            got += (long)n;
+        }
+        log_sink_close(&s);
+    } else {
+        metric_t m;
+        char line[METRIC_LINE_MAX];
+        while (mq_pop(q, &m)) {
+            int len = legacy_format(line, sizeof(line), &m);
+            if (len > 0) fwrite(line, 1, (size_t)len, f);
+            fflush(f);
+            last = now_ms(); // the old loop read the clock twice per metric
+            last = now_ms();
+            got++;
+        }
+        fclose(f);
+    }
+    uint64_t cpu = thread_cpu_ns() - c0, elapsed = now_ns() - t0;
+    pthread_join(th, NULL);
+    g_sink = (double)last;
+    *rate = (double)got * 1e9 / (double)elapsed;
+    return got ? (double)cpu / (double)got : NAN;
+}
+
+static void bench_drain(long msgs) {
+    printf("drain\n");
+    metric_queue_t *q = aligned_alloc(MQ_CACHELINE, sizeof(*q));
+    if (!q) return;
+    static const char *names[] = { "per_metric", "batched" };
+    double cpu[2], max[2], rate;
+    for (int b = 0; b < 2; b++) {
+        cpu[b] = drain_run(q, b, msgs, DRAIN_RATE, &rate);
+        drain_run(q, b, msgs, 0, &max[b]);
+        printf("  %-10s at %dk/s: %6.0f ns CPU/metric (%4.1f%% of a core)   unpaced %10.0f metrics/s\n", names[b],
+               DRAIN_RATE / 1000, cpu[b], cpu[b] * DRAIN_RATE / 1e7, max[b]);
+        char name[32];
+        snprintf(name, sizeof(name), "%s.cpu", names[b]);
+        result("drain", name, cpu[b], "ns");
+        snprintf(name, sizeof(name), "%s.max", names[b]);
+        result("drain", name, max[b], "metrics/s");
+    }
+    printf("  batched: %.1fx less logger CPU at %dk/s, %.1fx the unpaced rate\n", cpu[0] / cpu[1], DRAIN_RATE / 1000,
+           max[1] / max[0]);
+    free(q);
+}
+
+// ---- e2e ----
+
+static monitor_ctx_t g_ctx;
+
+static void *monitor_thread(void *arg) {
+    (void)arg;
+    monitor_run(&g_ctx);
+    return NULL;
+}
+
+static void bench_e2e(int samples) {
+    printf("e2e\n");
+    g_ctx.cfg = (monitor_config_t){ .cpu_alert_threshold = 101, .mem_alert_threshold = 101, .sample_interval_ms = 500,
+                                    .summary_interval_s = 3, .log_format = LOG_TSDB, .log_flush_ms = 1000,
+                                    .shm_name = E2E_SHM_NAME };
+    snprintf(g_ctx.mq_name, sizeof(g_ctx.mq_name), "/sysmon_bench_e2e_mq");
+    pthread_t th;
+    pthread_create(&th, NULL, monitor_thread, NULL);
+    const shm_metrics_t *shm = NULL;
+    for (int i = 0; i < 200 && !shm; i++) {
+        shm = shm_metrics_attach(E2E_SHM_NAME);
+        if (!shm) usleep(10000);
+    }
+    proc_file_t pf;
+    uint64_t *lat = malloc(sizeof(uint64_t) * (size_t)samples);
+    if (!shm || !lat || pf_open(&pf, "/proc/stat", 4096) != 0) {
+        fprintf(stderr, "e2e: monitor did not come up\n");
+        free(lat);
+        monitor_stop();
+        pthread_join(th, NULL);
+        return;
+    }
+    // METRIC_SUMMARY carries the probes: no collector produces it.
+    uint64_t cursor = 0;
+    shm_sample_t got[16];
+    int n = 0;
+    shm_metrics_read(shm, METRIC_SUMMARY, &cursor, got, 16);
+    for (int i = 0; i < samples; i++) {
+        uint64_t t0 = now_ns();
+        cpu_times_t ct;
+        read_cpu_times(&pf, &ct);
+        metric_t m = { .kind = METRIC_SUMMARY, .v1 = (double)t0, .v2 = (double)ct.user, .ts_ms = now_ms() };
+        mq_push(&g_ctx.queue, &m);
+        uint32_t gen = 0;
+        for (int waits = 0; waits < 100; waits++) {
+            size_t k = shm_metrics_read(shm, METRIC_SUMMARY, &cursor, got, 16);
+            if (k > 0) { lat[n++] = now_ns() - (uint64_t)got[k - 1].v1; break; }
+            gen = shm_metrics_wait(shm, gen, 10);
+        }
+        usleep(1000);
+    }
+    pf_close(&pf);
+    shm_metrics_detach(shm);
+    monitor_stop();
+    pthread_join(th, NULL);
+    if (n > 0) {
+        qsort(lat, (size_t)n, sizeof(uint64_t), cmp_u64);
+        uint64_t p50 = lat[n / 2], p99 = lat[(size_t)(n * 0.99)];
+        printf("  sample->shm  n=%d p50=%.1f us p99=%.1f us max=%.1f us\n", n, p50 / 1e3, p99 / 1e3, lat[n - 1] / 1e3);
+        result("e2e", "p50", p50 / 1e3, "us");
+        result("e2e", "p99", p99 / 1e3, "us");
+    }
+    free(lat);
+}
+
+int main(int argc, char **argv) {
+    const char *out = NULL;
+    long scale = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strncmp(argv[i], "--scale=", 8) == 0) scale = atol(argv[i] + 8);
+        else {
+            fprintf(stderr, "usage: %s [-o RESULTS.tsv] [--scale=N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (scale <= 0) scale = 1;
+    if (out && !(g_out = fopen(out, "w"))) { perror(out); return 1; }
+
+    setvbuf(stdout, NULL, _IOLBF, 0); // keep our lines in order with monitor_run's stderr
+    char fixtures[PATH_MAX];
+    if (!realpath(FIXTURE_DIR, fixtures)) { perror(FIXTURE_DIR " (run from the repository root)"); return 1; }
+    const char *tmp = getenv("TMPDIR");
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s/bench_monitor.XXXXXX", tmp && *tmp ? tmp : "/tmp");
+    if (!mkdtemp(dir)) { perror(dir); return 1; }
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd)) || chdir(dir) != 0) { perror(dir); return 1; }
+    mkdir("data", 0755);
+    mkdir("data/logs", 0755);
+
+    if (bench_parse(fixtures, (int)(20000 * scale)) != 0) return 1;
+    bench_queue(1000000 * scale);
+    bench_logger(500000 * scale);
+    bench_format(2000000 * scale);
+    bench_drain(200000 * scale);
+    bench_e2e((int)(500 * scale));
+
+    if (chdir(cwd) != 0) perror(cwd);
+    char cmd[PATH_MAX + 16];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", dir);
+    if (system(cmd) != 0) fprintf(stderr, "could not remove %s\n", dir);
+    if (g_out) { fclose(g_out); printf("results: %s\n", out); }
+    return 0;
+}
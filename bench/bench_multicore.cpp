@@ -0,0 +1,44 @@
+#include "bench_common.h"
+#include "scheduler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Multi-core simulation throughput: argv[1] processes (default 1000000) on argv[2] CPUs
+// (default 64), arriving about six per time unit so the CPUs stay close to saturated.
+// Each policy runs with work stealing, periodic balancing and pinned affinity.
+
+template <class F>
+static void timeRun(const char* name, const char* mode, size_t n, F run) {
+    auto t0 = std::chrono::steady_clock::now();
+    ScheduleReport r = run();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double util = 0;
+    for (auto& c : r.cores) util += c.utilisation;
+    if (!r.cores.empty()) util /= r.cores.size();
+    std::printf("  %-18s %-8s n=%-8zu %8.1f ms  %6.2f M events/s  util=%5.1f%%  migrations=%-8llu avgW=%.1f\n",
+                name, mode, n, s * 1e3, r.dispatches / s / 1e6, util * 100, (unsigned long long)r.migrations,
+                r.avgWaiting);
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int cores = argc > 2 ? std::atoi(argv[2]) : 64;
+    std::vector<Process> procs = makeWorkload(n, 42, true);
+    std::printf("workload: %zu processes on %d CPUs\n", n, cores);
+    struct Mode { const char* name; Balance balance; Affinity affinity; };
+    for (Mode m : {Mode{"steal", Balance::Steal, Affinity::Free}, Mode{"periodic", Balance::Periodic, Affinity::Free},
+                   Mode{"pinned", Balance::None, Affinity::Pinned}}) {
+        SchedOptions opt;
+        opt.gantt = GanttMode::None;
+        opt.cores = cores;
+        opt.balance = m.balance;
+        opt.affinity = m.affinity;
+        timeRun("FCFS", m.name, n, [&]{ return runFCFS(procs, opt); });
+        timeRun("RoundRobin(q=2)", m.name, n, [&]{ return runRoundRobin(procs, 2, opt); });
+        timeRun("SRTF", m.name, n, [&]{ return runSRTF(procs, opt); });
+        timeRun("Fair", m.name, n, [&]{ return runFair(procs, opt); });
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+#define _GNU_SOURCE
+#include "bench_common.h"
+#include "monitor.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Stress benchmark for metric_queue_t: N producers push into one queue drained by a
+// single consumer. Reports messages per second and enqueue latency percentiles for the
+// lock-free ring and for the original mutex/condvar ring.
+
+// ---- Legacy mutex/condvar ring (as shipped before the lock-free queue) ----
+
+typedef struct {
+    metric_t buf[QUEUE_CAP];
+    int head, tail, size;
+    bool closed;
+    pthread_mutex_t mtx;
+    pthread_cond_t not_empty, not_full;
+} legacy_queue_t;
+
+static void lq_init(legacy_queue_t *q) {
+    q->head = q->tail = q->size = 0; q->closed = false;
+    pthread_mutex_init(&q->mtx, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+}
+
+static bool lq_push(legacy_queue_t *q, const metric_t *m) {
+    pthread_mutex_lock(&q->mtx);
+    while (q->size == QUEUE_CAP && !q->closed) pthread_cond_wait(&q->not_full, &q->mtx);
+    if (q->closed) { pthread_mutex_unlock(&q->mtx); return false; }
+    q->buf[q->head] = *m;
+    q->head = (q->head + 1) % QUEUE_CAP;
+    q->size++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->mtx);
+    return true;
+}
+
+static bool lq_pop(legacy_queue_t *q, metric_t *out) {
+    pthread_mutex_lock(&q->mtx);
+    while (q->size == 0 && !q->closed) pthread_cond_wait(&q->not_empty, &q->mtx);
+    if (q->size == 0) { pthread_mutex_unlock(&q->mtx); return false; }
+    *out = q->buf[q->tail];
+    q->tail = (q->tail + 1) % QUEUE_CAP;
+    q->size--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->mtx);
+    return true;
+}
+
+// ---- Harness ----
+
+typedef struct {
+    bool legacy;
+    void *q;
+    long msgs;
+    uint64_t *lat; // per-push latency in ns
+} producer_arg_t;
+
+static void *producer(void *arg) {
+    producer_arg_t *a = arg;
+    metric_t m = { .kind = METRIC_CPU, .v1 = 1.0, .v2 = 0, .ts_ms = 0 };
+    for (long i = 0; i < a->msgs; i++) {
+        uint64_t t0 = now_ns();
+        if (a->legacy) lq_push(a->q, &m); else mq_push(a->q, &m);
+        a->lat[i] = now_ns() - t0;
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void run(bool legacy, int producers, long per_producer) {
+    metric_queue_t *mq = NULL; legacy_queue_t *lq = NULL;
+    if (legacy) { lq = malloc(sizeof(*lq)); lq_init(lq); }
+    else { mq = aligned_alloc(MQ_CACHELINE, sizeof(*mq)); mq_init(mq); }
+    long total = per_producer * producers;
+    uint64_t *lat = malloc(sizeof(uint64_t) * (size_t)total);
+    pthread_t *th = malloc(sizeof(pthread_t) * (size_t)producers);
+    producer_arg_t *args = malloc(sizeof(producer_arg_t) * (size_t)producers);
+
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < producers; i++) {
+        args[i] = (producer_arg_t){ legacy, legacy ? (void *)lq : (void *)mq, per_producer, lat + i * per_producer };
+        pthread_create(&th[i], NULL, producer, &args[i]);
+    }
+    metric_t m; double sink = 0;
+    for (long got = 0; got < total; got++) {
+        if (legacy) lq_pop(lq, &m); else mq_pop(mq, &m);
+        sink += m.v1;
+    }
+    uint64_t elapsed = now_ns() - t0;
+    for (int i = 0; i < producers; i++) pthread_join(th[i], NULL);
+
+    qsort(lat, (size_t)total, sizeof(uint64_t), cmp_u64);
+    printf("%-9s producers=%-3d msgs=%-9ld %12.0f msg/s   enqueue p50=%6llu ns p99=%7llu ns max=%9llu ns%s\n",
+           legacy ? "mutex" : "lockfree", producers, total,
+           (double)total * 1e9 / (double)elapsed,
+           (unsigned long long)lat[total / 2], (unsigned long long)lat[(size_t)(total * 0.99)],
+           (unsigned long long)lat[total - 1], sink == (double)total ? "" : " (MISMATCH)");
+
+    if (legacy) free(lq); else { mq_destroy(mq); free(mq); }
+    free(lat); free(th); free(args);
+}
+
+int main(int argc, char **argv) {
+    int maxp = (argc > 1) ? atoi(argv[1]) : 8;
+    long msgs = (argc > 2) ? atol(argv[2]) : 2000000;
+    if (maxp <= 0) maxp = 8;
+    if (msgs <= 0) msgs = 2000000;
+    for (int p = 1; p <= maxp; p *= 2) {
+        run(true, p, msgs / p);
+        run(false, p, msgs / p);
+    }
+    return 0;
+}
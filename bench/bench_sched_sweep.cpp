@@ -0,0 +1,52 @@
+#include "bench_common.h"
+#include "sched_sweep.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// Scaling of the sweep runner: the same job list (4 traces x (FCFS, SJF, Priority,
+// RR q=1..16, MLQ cutoff 0..4 x quantum 1..8)) is run with 1, 2, 4 ... threads up to
+// argv[2] (default: 2x hardware concurrency, at least 4). argv[1] is processes per
+// trace (default 100000). Speedup is relative to the single-thread run.
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned maxThreads = argc > 2 ? (unsigned)std::atoi(argv[2]) : std::max(4u, 2 * hw);
+
+    std::vector<TracePtr> traces;
+    for (unsigned s = 0; s < 4; s++) {
+        auto tr = std::make_shared<Trace>();
+        tr->name = "synthetic-" + std::to_string(s);
+        tr->procs = makeWorkload(n, 42 + s);
+        traces.push_back(std::move(tr));
+    }
+    SweepSpec spec;
+    spec.rrQuanta.clear();
+    for (int q = 1; q <= 16; q++) spec.rrQuanta.push_back(q);
+    spec.mlqCutoffs = {0, 1, 2, 3, 4};
+    spec.mlqQuanta = {1, 2, 3, 4, 5, 6, 7, 8};
+    std::vector<SweepJob> jobs = expandSweep(spec, traces.size());
+
+    std::printf("sweep: %zu jobs over %zu traces x %zu processes, %u hardware threads\n",
+                jobs.size(), traces.size(), n, hw);
+    double base = 0;
+    std::uint64_t checksum0 = 0;
+    for (unsigned t = 1; t <= maxThreads; t *= 2) {
+        std::uint64_t checksum = 0; // integer, so completion order does not matter
+        size_t done = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        SweepStats st = runSweep(traces, jobs, t, [&](const SweepResult& r){
+            checksum += r.report.dispatches;
+            done++;
+        });
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (t == 1) { base = s; checksum0 = checksum; }
+        std::printf("  threads=%-3u %8.1f ms  %7.1f jobs/s  speedup=%5.2fx  efficiency=%5.1f%%  stolen=%llu%s\n",
+                    st.threads, s * 1e3, done / s, base / s, 100.0 * base / s / st.threads,
+                    (unsigned long long)st.steals, checksum == checksum0 ? "" : "  RESULT MISMATCH");
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "bench_common.h"
+#include "scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <queue>
+
+// Simulated dispatches per second for each scheduling algorithm on synthetic workloads
+// of 10^3 .. 10^N processes (N = argv[1], default 6). The Gantt mode is argv[2]
+// (none|merged|full, default none). Round Robin is also timed against the original
+// std::map/std::queue implementation up to 10^5 processes.
+
+// ---- Original map-based Round Robin (as shipped before the flat rewrite) ----
+static ScheduleReport legacyRoundRobin(const std::vector<Process>& procs, int quantum){
+    std::vector<Process> p = procs; ScheduleReport rep; rep.algorithm = "RoundRobin";
+    std::sort(p.begin(), p.end(), [](auto&a, auto&b){return a.arrival<b.arrival;});
+    std::queue<Process> q; int time=0, i=0; std::map<int,int> remaining;
+    for (auto &pr: p) remaining[pr.pid]=pr.burst;
+    std::map<int,int> firstStart;
+    std::map<int,int> finish;
+    while (i<(int)p.size() || !q.empty()) {
+        while (i<(int)p.size() && p[i].arrival<=time) q.push(p[i++]);
+        if (q.empty()) { time = p[i].arrival; continue; }
+        Process cur = q.front(); q.pop();
+        int run = std::min(quantum, remaining[cur.pid]);
+        int start = time; time += run; remaining[cur.pid]-=run;
+        if (!firstStart.count(cur.pid)) firstStart[cur.pid]=start;
+        rep.gantt.push_back({cur.pid, start, time});
+        rep.dispatches++;
+        while (i<(int)p.size() && p[i].arrival<=time) q.push(p[i++]);
+        if (remaining[cur.pid]>0) { q.push(cur); }
+        else { finish[cur.pid]=time; }
+    }
+    double sumW = 0;
+    for (auto &pr : p) {
+        int tat = finish[pr.pid]-pr.arrival;
+        rep.rows.push_back({pr.pid, tat - pr.burst, tat});
+        sumW += tat - pr.burst;
+    }
+    if (!p.empty()) rep.avgWaiting = sumW / p.size();
+    return rep;
+}
+
+template <class F>
+static void timeRun(const char* name, size_t n, F run) {
+    auto t0 = std::chrono::steady_clock::now();
+    ScheduleReport r = run();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("  %-18s n=%-9zu %9.1f ms  dispatches=%-10llu %7.2f M events/s  avgW=%.1f gantt=%zu\n",
+                name, n, s * 1e3, (unsigned long long)r.dispatches, r.dispatches / s / 1e6, r.avgWaiting, r.gantt.size());
+}
+
+int main(int argc, char** argv) {
+    int maxExp = argc > 1 ? std::atoi(argv[1]) : 6;
+    SchedOptions opt;
+    opt.gantt = GanttMode::None;
+    if (argc > 2 && std::strcmp(argv[2], "merged") == 0) opt.gantt = GanttMode::Merged;
+    if (argc > 2 && std::strcmp(argv[2], "full") == 0) opt.gantt = GanttMode::Full;
+    for (int e = 3; e <= maxExp; e++) {
+        size_t n = 1;
+        for (int k = 0; k < e; k++) n *= 10;
+        std::vector<Process> procs = makeWorkload(n, 42);
+        std::printf("workload 10^%d\n", e);
+        timeRun("FCFS", n, [&]{ return runFCFS(procs, opt); });
+        timeRun("SJF", n, [&]{ return runSJF(procs, opt); });
+        timeRun("RoundRobin(q=2)", n, [&]{ return runRoundRobin(procs, 2, opt); });
+        if (e <= 5) timeRun("RR legacy (map)", n, [&]{ return legacyRoundRobin(procs, 2); });
+        timeRun("Priority", n, [&]{ return runPriority(procs, opt); });
+        timeRun("MultilevelQueue", n, [&]{ return runMultilevelQueue(procs, opt); });
+        timeRun("SRTF", n, [&]{ return runSRTF(procs, opt); });
+        timeRun("PreemptivePriority", n, [&]{ return runPreemptivePriority(procs, opt); });
+        timeRun("Fair", n, [&]{ return runFair(procs, opt); });
+    }
+    return 0;
+}
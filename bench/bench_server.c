@@ -0,0 +1,251 @@
+#define _GNU_SOURCE
+#include "bench_common.h"
+#include "monitor.h"
+#include "metrics_server.h"
+#include "shm_metrics.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Load test for the metrics endpoint (metrics_server.h): N client connections spread
+// over T threads, each in a closed loop (send a request, read the whole response,
+// repeat), for every request type in turn. Reports requests per second and latency
+// percentiles. Without --socket it serves itself: a publisher thread fills a private
+// shm region with a 64-core tick (132 series) ten times a second, so the cached
+// snapshot is rebuilt throughout the run. With --socket=PATH it loads a running
+// `monitor --socket` instead.
+
+#define BENCH_SHM_NAME "/sysmon_bench_server"
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// ---- Publisher (self-served runs) ----
+
+static volatile bool g_publishing = true;
+
+static void *publisher(void *arg) {
+    shm_metrics_t *shm = arg;
+    while (g_publishing) {
+        uint64_t ts = now_ms();
+        metric_t m = { .kind = METRIC_CPU, .v1 = 37.5, .ts_ms = ts, .interval_ms = 100 };
+        shm_metrics_publish(shm, &m);
+        m = (metric_t){ .kind = METRIC_MEM, .v1 = 61.2, .ts_ms = ts, .interval_ms = 100 };
+        shm_metrics_publish(shm, &m);
+        for (uint32_t c = 0; c < 64; c++) {
+            m = (metric_t){ .kind = METRIC_CPU_CORE, .id = c, .v1 = 20 + c % 7, .v2 = 5 + c % 3, .ts_ms = ts, .interval_ms = 100 };
+            shm_metrics_publish(shm, &m);
+            m = (metric_t){ .kind = METRIC_CPU_CORE_WAIT, .id = c, .v1 = c % 2, .ts_ms = ts, .interval_ms = 100 };
+            shm_metrics_publish(shm, &m);
+        }
+        shm_metrics_notify(shm);
+        usleep(100000);
+    }
+    return NULL;
+}
+
+// ---- Clients ----
+
+typedef enum { REQ_SNAPSHOT, REQ_RANGE, REQ_PROMETHEUS } req_t;
+static const char *req_names[] = { "snapshot", "range", "prometheus" };
+
+typedef struct {
+    int fd;
+    size_t got, want; // response bytes read, and expected (0 = not known yet)
+    uint64_t t0;
+    char head[sizeof(msrv_response_t)];
+} client_t;
+
+typedef struct {
+    const char *path;
+    req_t req;
+    int nconn;
+    uint64_t until_ns;
+    uint64_t *lat;
+    size_t nlat, cap;
+    long errors;
+} worker_t;
+
+static int dial(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) { close(fd); return -1; }
+    return fd;
+}
+
+// Opens the connection if needed (Prometheus: a new one per request) and sends one request.
+static bool client_send(worker_t *w, client_t *c, int ep) {
+    if (c->fd < 0) {
+        if ((c->fd = dial(w->path)) < 0) return false;
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+    }
+    c->got = c->want = 0;
+    c->t0 = now_ns();
+    if (w->req == REQ_PROMETHEUS) {
+        static const char get[] = "GET /metrics HTTP/1.0\r\n\r\n";
+        return send(c->fd, get, sizeof(get) - 1, MSG_NOSIGNAL) == (ssize_t)sizeof(get) - 1;
+    }
+    msrv_request_t rq = { .len = sizeof(rq) - 4, .op = w->req == REQ_RANGE ? MSRV_RANGE : MSRV_SNAPSHOT,
+                          .kind = METRIC_CPU_CORE, .id = 3, .from_ms = 0 };
+    return send(c->fd, &rq, sizeof(rq), MSG_NOSIGNAL) == (ssize_t)sizeof(rq);
+}
+
+static void record(worker_t *w, uint64_t ns) {
+    if (w->nlat == w->cap) {
+        size_t cap = w->cap ? 2 * w->cap : 65536;
+        uint64_t *l = realloc(w->lat, cap * sizeof(*l));
+        if (!l) return;
+        w->lat = l;
+        w->cap = cap;
+    }
+    w->lat[w->nlat++] = ns;
+}
+
+static void client_close(client_t *c) {
+    close(c->fd); // also leaves the epoll set
+    c->fd = -1;
+}
+
+// Reads what is there; true once the whole response is in.
+static bool client_read(worker_t *w, client_t *c) {
+    char buf[65536];
+    for (;;) {
+        ssize_t n = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return false;
+        if (n == 0 && w->req == REQ_PROMETHEUS && c->got > 0) { client_close(c); return true; }
+        if (n <= 0) { client_close(c); w->errors++; return false; }
+        if (c->got < sizeof(c->head)) {
+            size_t h = (size_t)n < sizeof(c->head) - c->got ? (size_t)n : sizeof(c->head) - c->got;
+            memcpy(c->head + c->got, buf, h);
+        }
+        c->got += (size_t)n;
+        if (w->req != REQ_PROMETHEUS && !c->want && c->got >= sizeof(c->head)) {
+            msrv_response_t r;
+            memcpy(&r, c->head, sizeof(r));
+            if (r.op == MSRV_ERROR) { client_close(c); w->errors++; return false; }
+            c->want = r.len + 4;
+        }
+        if (c->want && c->got >= c->want) return true;
+    }
+}
+
+static void *worker(void *arg) {
+    worker_t *w = arg;
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    client_t *cl = calloc((size_t)w->nconn, sizeof(*cl));
+    if (ep < 0 || !cl) { free(cl); return NULL; }
+    for (int i = 0; i < w->nconn; i++) {
+        cl[i].fd = -1;
+        if (!client_send(w, &cl[i], ep)) w->errors++;
+    }
+    struct epoll_event evs[256];
+    while (now_ns() < w->until_ns) {
+        int k = epoll_wait(ep, evs, 256, 100);
+        for (int e = 0; e < k; e++) {
+            client_t *c = evs[e].data.ptr;
+            if (c->fd < 0 || !client_read(w, c)) {
+                if (c->fd < 0 && !client_send(w, c, ep)) w->errors++;
+                continue;
+            }
+            record(w, now_ns() - c->t0);
+            if (!client_send(w, c, ep)) w->errors++;
+        }
+    }
+    for (int i = 0; i < w->nconn; i++) if (cl[i].fd >= 0) close(cl[i].fd);
+    free(cl);
+    close(ep);
+    return NULL;
+}
+
+static void run(const char *path, req_t req, int clients, int threads, double seconds) {
+    worker_t *ws = calloc((size_t)threads, sizeof(*ws));
+    pthread_t *th = calloc((size_t)threads, sizeof(*th));
+    if (!ws || !th) { free(ws); free(th); return; }
+    uint64_t t0 = now_ns(), until = t0 + (uint64_t)(seconds * 1e9);
+    for (int t = 0; t < threads; t++) {
+        ws[t] = (worker_t){ .path = path, .req = req, .nconn = clients / threads + (t < clients % threads), .until_ns = until };
+        pthread_create(&th[t], NULL, worker, &ws[t]);
+    }
+    size_t n = 0;
+    long errors = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(th[t], NULL);
+        n += ws[t].nlat;
+        errors += ws[t].errors;
+    }
+    double elapsed = (double)(now_ns() - t0) / 1e9;
+    uint64_t *all = malloc((n ? n : 1) * sizeof(*all));
+    size_t k = 0;
+    for (int t = 0; t < threads; t++) {
+        if (all) memcpy(all + k, ws[t].lat, ws[t].nlat * sizeof(*all));
+        k += ws[t].nlat;
+        free(ws[t].lat);
+    }
+    if (all && n > 0) {
+        qsort(all, n, sizeof(*all), cmp_u64);
+        printf("  %-10s %9.0f req/s   p50=%7.1f us p99=%7.1f us p99.9=%7.1f us max=%7.1f us   errors=%ld\n",
+               req_names[req], (double)n / elapsed, all[n / 2] / 1e3, all[(size_t)(n * 0.99)] / 1e3,
+               all[(size_t)(n * 0.999)] / 1e3, all[n - 1] / 1e3, errors);
+    } else {
+        printf("  %-10s no responses (errors=%ld)\n", req_names[req], errors);
+    }
+    free(all);
+    free(ws);
+    free(th);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int clients = 256, threads = 4;
+    double seconds = 2;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--socket=", 9) == 0) path = argv[i] + 9;
+        else if (strncmp(argv[i], "--clients=", 10) == 0) clients = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--threads=", 10) == 0) threads = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "--seconds=", 10) == 0) seconds = atof(argv[i] + 10);
+        else {
+            fprintf(stderr, "usage: %s [--socket=PATH] [--clients=N] [--threads=N] [--seconds=S]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (clients < 1 || clients > MSRV_MAX_CLIENTS) clients = 256;
+    if (threads < 1 || threads > clients) threads = 1;
+
+    shm_metrics_t *shm = NULL;
+    metrics_server_t *srv = NULL;
+    pthread_t pub;
+    char own[PATH_MAX];
+    if (!path) {
+        const char *tmp = getenv("TMPDIR");
+        snprintf(own, sizeof(own), "%s/bench_server.%d.sock", tmp && *tmp ? tmp : "/tmp", (int)getpid());
+        path = own;
+        if (!(shm = shm_metrics_create(BENCH_SHM_NAME))) { perror("shm_metrics_create"); return 1; }
+        if (!(srv = metrics_server_start(path, shm))) { perror(path); shm_metrics_destroy(shm, BENCH_SHM_NAME); return 1; }
+        pthread_create(&pub, NULL, publisher, shm);
+        usleep(200000);
+    }
+    printf("metrics server %s: %d clients on %d threads, %.1f s per request type\n", path, clients, threads, seconds);
+    for (int r = REQ_SNAPSHOT; r <= REQ_PROMETHEUS; r++) run(path, (req_t)r, clients, threads, seconds);
+    if (srv) {
+        g_publishing = false;
+        pthread_join(pub, NULL);
+        metrics_server_stop(srv);
+        shm_metrics_destroy(shm, BENCH_SHM_NAME);
+    }
+    return 0;
+}
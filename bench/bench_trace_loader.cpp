@@ -0,0 +1,100 @@
+#include "trace_loader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+// Trace loading throughput: writes a synthetic CSV of argv[1] rows (default 2000000)
+// to $TMPDIR, then times the original getline/stringstream/stoi loader against
+// loadTrace with 1 and N threads, the binary format and the streaming TraceReader
+// (1 MiB buffer). Every result is checked against the original loader's output.
+
+// ---- Original loader (as shipped in scheduler_simulator.cpp) ----
+static std::vector<Process> legacyLoadCsv(const std::string& path) {
+    std::vector<Process> out; std::ifstream f(path);
+    if (!f) return out;
+    std::string line; bool header=true;
+    while (std::getline(f,line)) {
+        if (line.empty()) continue;
+        if (header) { header=false; if (line.find("PID")!=std::string::npos) continue; }
+        std::replace(line.begin(), line.end(), ';', ',');
+        std::stringstream ss(line); std::string tok; std::vector<int> vals;
+        while (std::getline(ss,tok,',')) { if (!tok.empty()) vals.push_back(std::stoi(tok)); }
+        if (vals.size()>=4) out.push_back({vals[0],vals[1],vals[2],vals[3]});
+    }
+    return out;
+}
+
+static bool same(const std::vector<Process>& a, const std::vector<Process>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const Process& x, const Process& y){
+        return x.pid == y.pid && x.arrival == y.arrival && x.burst == y.burst && x.priority == y.priority;
+    });
+}
+
+template <class F>
+static void timeLoad(const char* name, size_t bytes, const std::vector<Process>& ref, F load) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Process> p = load();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("  %-22s %8.1f ms  %8.1f MB/s  %6.2f M rows/s%s\n", name, s * 1e3, bytes / s / 1e6,
+                p.size() / s / 1e6, same(p, ref) ? "" : "  MISMATCH");
+}
+
+static size_t fileSize(const std::string& path) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    return f ? (size_t)f.tellg() : 0;
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    const char* tmp = std::getenv("TMPDIR");
+    std::string dir = tmp && *tmp ? tmp : "/tmp";
+    std::string csv = dir + "/bench_trace_" + std::to_string(getpid()) + ".csv";
+    std::string bin = dir + "/bench_trace_" + std::to_string(getpid()) + ".trc";
+
+    {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> gap(0, 20), burst(1, 200), prio(0, 9);
+        FILE* f = std::fopen(csv.c_str(), "w");
+        if (!f) { std::perror(csv.c_str()); return 1; }
+        std::fprintf(f, "PID,Arrival,Burst,Priority\n");
+        long t = 0;
+        for (size_t i = 0; i < rows; i++) {
+            t += gap(rng);
+            // Mix both separators as real traces do.
+            std::fprintf(f, i % 5 ? "%zu,%ld,%d,%d\n" : "%zu;%ld;%d;%d\n", i + 1, t, burst(rng), prio(rng));
+        }
+        std::fclose(f);
+    }
+    size_t bytes = fileSize(csv);
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("trace: %zu rows, %.1f MB, %u hardware threads\n", rows, bytes / 1e6, hw);
+
+    std::vector<Process> ref = legacyLoadCsv(csv);
+    timeLoad("legacy getline/stoi", bytes, ref, [&]{ return legacyLoadCsv(csv); });
+    timeLoad("mmap+from_chars x1", bytes, ref, [&]{ return loadTrace(csv, 1); });
+    unsigned n = std::max(4u, hw);
+    char name[32];
+    std::snprintf(name, sizeof(name), "mmap+from_chars x%u", n);
+    timeLoad(name, bytes, ref, [&]{ return loadTrace(csv, n); });
+    timeLoad("TraceReader (stream)", bytes, ref, [&]{
+        std::vector<Process> out;
+        TraceReader in(csv);
+        Process p;
+        while (in.next(p)) out.push_back(p);
+        return out;
+    });
+    if (saveBinaryTrace(bin, ref)) {
+        timeLoad("binary trace", fileSize(bin), ref, [&]{ return loadTrace(bin); });
+        std::printf("  (binary file is %.1f MB)\n", fileSize(bin) / 1e6);
+    }
+    std::remove(csv.c_str());
+    std::remove(bin.c_str());
+    return 0;
+}
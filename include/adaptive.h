@@ -0,0 +1,37 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <stdbool.h>
+
+// Adaptive sampling interval for one collector (cfg.adaptive).
+//
+// After each tick the collector's headline value (CPU busy %, memory %, disk or network
+// rate) is compared with an EWMA of its mean and variance. A jump larger than
+// ADAPT_SIGMAS standard deviations, ADAPT_REL_STEP of the mean and the signal's own
+// min_step (its measurement granularity, e.g. one jiffy of CPU time at the floor)
+// drops the interval straight to the floor so the spike is sampled finely; a value
+// within `near` of the alert threshold halves it each tick. Otherwise every
+// ADAPT_CALM_TICKS quiet ticks double it, up to the ceiling, so a flat signal is
+// sampled rarely.
+
+#define ADAPT_SIGMAS 3.0
+#define ADAPT_REL_STEP 0.10 // jumps under 10% of the mean are noise
+#define ADAPT_ALPHA 0.2     // EWMA weight of the newest value
+#define ADAPT_CALM_TICKS 3
+
+typedef struct {
+    unsigned int floor_ms, base_ms, ceil_ms;
+    double threshold; // alert threshold of this signal, NAN if none
+    double near;      // how far below the threshold counts as near
+    double min_step;  // smallest change that is not noise
+    double mean, var, last;
+    unsigned int calm;
+    bool primed;
+} adapt_t;
+
+void adapt_init(adapt_t *a, unsigned int floor_ms, unsigned int base_ms, unsigned int ceil_ms,
+                double threshold, double near, double min_step);
+// Next interval after a tick that ran at cur_ms and produced `level`.
+unsigned int adapt_next(adapt_t *a, unsigned int cur_ms, double level);
+
+#endif // ADAPTIVE_H
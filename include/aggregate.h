@@ -0,0 +1,92 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "monitor.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Streaming aggregation over the metric stream.
+//
+// For every metric kind the aggregator keeps rolling 1s/10s/1m/5m windows, an EWMA and
+// a DDSketch per window bucket. Each window is a ring of AGG_BUCKETS time buckets
+// holding count/sum/min/max and a sketch, so adding a sample is O(1) per window and a
+// query combines AGG_BUCKETS buckets. Per-entity kinds (CPU_CORE, PROC_*) are
+// aggregated across all ids. Only v1 is aggregated.
+//
+// Means and quantiles weigh each sample by the interval it covers (metric_t.interval_ms,
+// in AGG_WEIGHT_MS units), so adaptive sampling, which takes many samples around a
+// spike and few while flat, still yields time averages. Counts are sample counts.
+
+// ---- DDSketch ----
+// Relative-error quantile sketch: bin k counts values in (gamma^(k-1), gamma^k]. A
+// sketch holds DD_BINS consecutive bins; when values span more than that, the lowest
+// bins are collapsed, so high quantiles keep their accuracy. Sketches merge exactly.
+
+#define DD_ALPHA 0.02 // relative accuracy
+#define DD_BINS 1024
+#define DD_MIN_VALUE 1e-9 // values at or below this go to the zero bin
+
+typedef struct {
+    int32_t base;   // bin index of bins[0]
+    uint32_t zero;
+    uint64_t count;
+    uint32_t bins[DD_BINS];
+} dd_sketch_t;
+
+void dd_init(dd_sketch_t *s);
+void dd_add(dd_sketch_t *s, double x);
+void dd_add_n(dd_sketch_t *s, double x, uint32_t n); // x seen n times
+void dd_merge(dd_sketch_t *dst, const dd_sketch_t *src);
+double dd_quantile(const dd_sketch_t *s, double q); // q in [0,1]; 0 if empty
+
+// ---- Windows ----
+
+typedef enum { AGG_1S, AGG_10S, AGG_1M, AGG_5M, AGG_WINDOWS } agg_window_t;
+#define AGG_BUCKETS 10
+#define AGG_EWMA_TAU_MS 10000
+#define AGG_WEIGHT_MS 50 // sketch weight unit; samples without an interval weigh one unit
+
+typedef struct {
+    uint64_t count;
+    double min, max, mean;
+    double p50, p95, p99;
+} agg_stats_t;
+
+typedef struct {
+    uint64_t ts_ms; // newest sample
+    double last;
+    double ewma;
+    agg_stats_t win[AGG_WINDOWS];
+} agg_summary_t;
+
+typedef struct agg agg_t;
+
+agg_t *agg_create(void);
+void agg_destroy(agg_t *g);
+void agg_add(agg_t *g, const metric_t *m);
+// Window statistics as of `now_ms`; quantiles are only computed when with_quantiles.
+bool agg_window(const agg_t *g, metric_kind_t kind, agg_window_t w, uint64_t now_ms,
+                bool with_quantiles, agg_stats_t *out);
+// Everything for one kind; false if the kind has no samples yet.
+bool agg_summary(const agg_t *g, metric_kind_t kind, uint64_t now_ms, agg_summary_t *out);
+unsigned int agg_window_ms(agg_window_t w);
+const char *agg_window_name(agg_window_t w);
+int agg_window_from_seconds(unsigned int s); // 1, 10, 60 or 300; -1 otherwise
+
+// ---- Threshold alerts with hysteresis ----
+// Raised when the window mean reaches `threshold`, cleared once it drops below
+// threshold - hysteresis. Each transition produces one METRIC_ALERT
+// (v2 = 0 raised, 1 cleared).
+
+typedef struct {
+    metric_kind_t kind;
+    double threshold;
+    double hysteresis;
+    agg_window_t window;
+    bool active;
+} agg_alert_t;
+
+bool agg_alert_eval(agg_alert_t *a, const agg_t *g, uint64_t now_ms, metric_t *out);
+
+#endif // AGGREGATE_H
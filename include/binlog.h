@@ -0,0 +1,59 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include "monitor.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Compact binary log backend.
+//
+// The file is a sequence of fixed-size blocks. Each block starts with a header and a
+// column directory, followed by one bit-packed column per metric kind present in the
+// block. Within a column, timestamps are delta-of-delta encoded, ids are coded relative
+// to the previous id, v1/v2 are Gorilla XOR-compressed against the previous value, and
+// interval_ms takes one bit when it repeats the previous sample's (else 1 + 32 bits).
+// Version 1 blocks, written before intervals were kept, still decode (interval_ms 0).
+// The block being filled is rewritten in place on every flush, so files are always a
+// whole number of blocks and a flush is a single pwrite (optionally O_DIRECT).
+
+#define BINLOG_BLOCK_SIZE 4096
+#define BINLOG_MAGIC 0x314C4D53u // "SML1"
+#define BINLOG_VERSION 2
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t ncols;
+    uint32_t count;   // samples in the block
+    uint32_t reserved;
+    uint64_t min_ts;
+    uint64_t max_ts;
+} binlog_block_hdr_t;
+
+typedef struct {
+    uint16_t kind;
+    uint16_t reserved;
+    uint32_t count;  // samples in this column
+    uint32_t offset; // byte offset of the bitstream from the block start
+    uint32_t nbits;
+} binlog_col_t;
+
+typedef struct binlog binlog_t;
+
+// Opens (appending) or creates path. flush_ms is the cadence used by binlog_tick;
+// 0 flushes after every append. direct requests O_DIRECT and falls back silently.
+binlog_t *binlog_open(const char *path, unsigned int flush_ms, bool direct);
+int binlog_append(binlog_t *bl, const metric_t *m);
+int binlog_tick(binlog_t *bl, uint64_t now_ms); // flushes if the cadence has elapsed
+int binlog_flush(binlog_t *bl);
+int binlog_close(binlog_t *bl);
+uint64_t binlog_size(const binlog_t *bl); // file size once the open block is written
+
+// Decodes one block into out (samples grouped by column); returns the count or -1.
+#define BINLOG_MAX_PER_BLOCK (BINLOG_BLOCK_SIZE * 2)
+int binlog_decode_block(const uint8_t *block, metric_t *out, size_t cap);
+
+#endif // BINLOG_H
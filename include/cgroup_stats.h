@@ -0,0 +1,45 @@
+#ifndef CGROUP_STATS_H
+#define CGROUP_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-cgroup accounting on a cgroup v2 hierarchy.
+//
+// The tree is walked once; after that inotify keeps it current. One watch per cgroup
+// directory reports child cgroups created and removed, and IN_MODIFY of the cgroup's
+// cgroup.events reports when it gains its first or loses its last task. Only
+// populated cgroups are sampled, each through persistent fds on cpu.stat,
+// memory.current and io.stat that are opened when it becomes populated and closed
+// once it empties. Idle cgroups cost neither reads nor fds, and keeping the tree
+// current costs O(changed), not a rescan. The fds count against RLIMIT_NOFILE, which
+// is the caller's to raise (bin/monitor raises it to the hard limit).
+
+#define CGROUP_DEFAULT_ROOT "/sys/fs/cgroup"
+#define CGROUP_MAX_TRACKED 16384 // beyond this, new cgroups are ignored (one warning)
+
+typedef struct {
+    uint32_t id;                      // directory inode number, the kernel's cgroup id
+    const char *path;                 // relative to the root
+    double cpu_pct;                   // usage_usec over the interval, % of one CPU
+    double throttled_pct;             // throttled_usec over the interval (cpu.max), %
+    uint64_t mem_bytes;               // memory.current
+    uint64_t read_bytes, write_bytes; // io.stat rbytes/wbytes over the interval, all devices
+    bool has_mem, has_io;             // the memory / io controller is enabled for it
+} cgroup_sample_t;
+
+typedef struct cgroup_tree cgroup_tree_t;
+
+// NULL with errno = ENOTSUP if root is not a cgroup v2 hierarchy.
+cgroup_tree_t *cgroup_tree_open(const char *root, unsigned int max_cgroups);
+void cgroup_tree_close(cgroup_tree_t *t);
+
+// Applies pending tree changes, reads every populated cgroup and calls fn for each
+// one whose counters moved since the previous call (and once more after they stop).
+// fn may be NULL to only take a baseline. Returns the number of populated cgroups.
+typedef void (*cgroup_fn)(const cgroup_sample_t *s, void *arg);
+int cgroup_tree_sample(cgroup_tree_t *t, cgroup_fn fn, void *arg);
+
+unsigned int cgroup_tree_count(const cgroup_tree_t *t); // tracked, populated or not
+
+#endif // CGROUP_STATS_H
@@ -0,0 +1,57 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include "monitor.h"
+#include "adaptive.h"
+
+// A periodic sampler. Collectors are driven either by one thread each (the default)
+// or all together by the single-threaded timerfd/epoll loop (cfg.event_loop).
+typedef struct collector collector_t;
+#define COLLECTOR_EVENT_FDS 4
+struct collector {
+    const char *name;
+    unsigned int interval_ms; // current interval; moves within adapt's bounds when `adaptive`
+    int  (*init)(collector_t *c, monitor_ctx_t *ctx);   // open files and take the baseline
+    void (*sample)(collector_t *c, monitor_ctx_t *ctx); // one tick: read, compute, push
+    void (*fini)(collector_t *c);
+    void *state;
+    int event_fds[COLLECTOR_EVENT_FDS]; // set by init: also tick as soon as one of these
+    int nevent_fds;
+    short event_mask;                   // ...polls any of these (POLLPRI for PSI triggers),
+    uint32_t events;                    // with bit j set here if event_fds[j] fired
+    uint64_t ticks;  // samples taken
+    uint64_t missed; // timer expirations skipped because a tick overran (event loop only)
+    unsigned int tick_ms;  // time since the previous tick; samples stamp it as metric_t.interval_ms
+    uint64_t last_tick_ns;
+    double level;          // headline value of the last tick, set by sample (NAN = none)
+    bool adaptive;
+    adapt_t adapt;
+    int reg;               // registry index (monitor_collectors)
+    unsigned int cfg_gen;  // ctx->cfg_gen the interval settings were last taken at
+};
+
+#define MAX_COLLECTORS 16
+
+// Prepares c->tick_ms, runs one sample and, for adaptive collectors, picks the next
+// interval. Both drivers call it; `idx` is the collector's position (selfstat.h).
+// After a config reload it first re-takes the interval settings (collector_configure).
+void collector_tick(collector_t *c, int idx, monitor_ctx_t *ctx);
+
+// Instantiates the registry's collectors: cpu, mem, disk, net, psi with cfg->psi,
+// cgroup with cfg->cgroup_root, procs when cfg->proc_top_k or cfg->trace_path is set,
+// and self in SELFSTAT builds, narrowed to cfg->collectors when that is set. Nothing
+// else is opened or scheduled. Returns the count.
+int monitor_collectors(collector_t *out, int max, const monitor_config_t *cfg);
+
+// Sets c->interval_ms from cfg: the base, proc or per-collector (cfg->intervals)
+// interval, and with cfg->adaptive the adaptive bounds of cpu, mem, disk and net. An
+// adaptive collector whose bounds and threshold are unchanged keeps its current state.
+void collector_configure(collector_t *c, const monitor_config_t *cfg);
+
+int collector_find(const char *name); // registry index, or -1
+
+// Runs every collector from the calling thread until ctx->running clears or stop_fd
+// becomes readable. Each collector gets its own timerfd armed on absolute deadlines.
+int collector_loop_run(collector_t *cols, int n, monitor_ctx_t *ctx, int stop_fd);
+
+#endif // COLLECTOR_H
@@ -0,0 +1,20 @@
+#ifndef COLLECTORS_H
+#define COLLECTORS_H
+
+#include "proc_reader.h"
+
+// Raw /proc parsers used by the monitor's collector threads.
+// The parse_* functions work on an in-memory buffer (so they can be fed fixtures);
+// the read_* wrappers re-read a persistent proc_file_t and parse it. Disk and network
+// counters are per device, see dev_stats.h.
+
+typedef struct { unsigned long long user,nice,system,idle,iowait,irq,softirq,steal,guest,guest_nice; } cpu_times_t;
+
+int parse_cpu_times(const char *buf, cpu_times_t *t);
+double cpu_busy_percent(const cpu_times_t *prev, const cpu_times_t *cur); // busy share of the interval
+double parse_mem_usage_percent(const char *buf);
+
+int read_cpu_times(proc_file_t *pf, cpu_times_t *t);
+double read_mem_usage_percent(proc_file_t *pf);
+
+#endif // COLLECTORS_H
@@ -0,0 +1,42 @@
+#ifndef CPU_CORES_H
+#define CPU_CORES_H
+
+#include <stddef.h>
+
+// Per-core /proc/stat counters in structure-of-arrays layout, one array per CPU state,
+// indexed by core number. Arrays are 32-byte aligned and padded to a multiple of 4
+// cores so the delta kernel can run full AVX2 lanes.
+typedef struct {
+    int ncores; // highest cpuN seen + 1
+    int cap;
+    unsigned long long *user, *nice, *system, *idle, *iowait, *irq, *softirq, *steal;
+} cpu_cores_t;
+
+// Per-core percentages of the interval between two snapshots.
+typedef struct {
+    int ncores;
+    int cap;
+    double *busy;   // everything but idle and iowait
+    double *user;   // user + nice
+    double *system; // system + irq + softirq
+    double *iowait;
+    double *steal;
+} cpu_core_pct_t;
+
+void cpu_cores_init(cpu_cores_t *c);
+void cpu_cores_free(cpu_cores_t *c);
+void cpu_core_pct_init(cpu_core_pct_t *p);
+void cpu_core_pct_free(cpu_core_pct_t *p);
+
+// Parses every "cpuN" line of a /proc/stat buffer. Only allocates when the core count grows.
+int parse_cpu_cores(const char *buf, cpu_cores_t *c);
+
+// Computes per-core percentages for cur - prev. Dispatches at runtime to AVX2 on x86-64
+// CPUs that have it and to scalar code everywhere else.
+int cpu_cores_delta(const cpu_cores_t *prev, const cpu_cores_t *cur, cpu_core_pct_t *out);
+
+// Fixed implementations, exposed for benchmarking.
+void cpu_cores_delta_scalar(const cpu_cores_t *prev, const cpu_cores_t *cur, cpu_core_pct_t *out, int n);
+const char *cpu_cores_kernel_name(void);
+
+#endif // CPU_CORES_H
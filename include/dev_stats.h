@@ -0,0 +1,75 @@
+#ifndef DEV_STATS_H
+#define DEV_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-device disk and per-interface network counters.
+//
+// A dev_table_t caches the device set of /proc/diskstats, /proc/net/dev or a netlink
+// stats dump: one row per device, keyed by major:minor or ifindex, with its name and
+// whether it counts (the include/exclude filter, and never a partition, whose I/O is
+// already in its disk's line). Counters live in fixed-width arrays indexed by row,
+// like cpu_cores.h. A parse walks the source in order and only checks each line
+// against the cached row at the same position, so a steady tick does no lookups,
+// allocations or pattern matches; the table is rebuilt only when a device appears,
+// disappears or moves, and then only rows that are new pay for a name or ifindex lookup.
+
+#define DEV_NAME_MAX 32
+
+// Disk keys use the kernel's dev_t layout.
+#define DEV_KEY(major, minor) ((uint32_t)(major) << 20 | (uint32_t)(minor))
+#define DEV_MAJOR(key) ((key) >> 20)
+#define DEV_MINOR(key) ((key) & 0xFFFFFu)
+
+// Used when no filter is given: loop and ram disks are not real I/O, lo is not traffic.
+#define DEV_DISK_DEFAULT_FILTER "!loop*,!ram*"
+#define DEV_NET_DEFAULT_FILTER "!lo"
+
+typedef enum { DEV_DISK, DEV_NET } dev_class_t;
+
+typedef struct {
+    dev_class_t cls;
+    const char *filter;         // see dev_filter_match; not copied
+    int n, cap;
+    uint32_t *key;              // DEV_KEY(major, minor) or ifindex
+    char (*name)[DEV_NAME_MAX];
+    uint8_t *use;               // counted: passes the filter and is not a partition
+    uint8_t *moved;             // caller's per-row flag, kept across rebuilds
+    uint64_t *a, *b;            // cumulative sectors read / written, or rx / tx bytes
+    uint64_t *a0, *b0;          // caller's previous snapshot, kept across rebuilds
+    uint64_t rebuilds;
+    // Parse scratch: rows from the first line that did not match the cache onwards.
+    int seen, first, staged, scap;
+    bool dirty, by_name;
+    uint32_t *skey;
+    char (*sname)[DEV_NAME_MAX];
+    uint64_t *sa, *sb;
+} dev_table_t;
+
+void dev_table_init(dev_table_t *t, dev_class_t cls, const char *filter); // NULL = default filter
+void dev_table_free(dev_table_t *t);
+
+// Update t from a /proc/diskstats or /proc/net/dev buffer. New rows start with
+// a0/b0 = a/b, so their first delta is zero.
+int dev_parse_diskstats(dev_table_t *t, const char *buf);
+int dev_parse_net_dev(dev_table_t *t, const char *buf);
+
+// Sum of a and b over the rows in use.
+void dev_table_sum(const dev_table_t *t, uint64_t *a, uint64_t *b);
+
+// Comma-separated fnmatch patterns; "!pat" excludes. A name matches when it matches no
+// exclusion and, if there are any inclusions, at least one of them.
+bool dev_filter_match(const char *filter, const char *name);
+
+// Interface counters over rtnetlink instead of /proc/net/dev: an RTM_GETSTATS dump
+// of IFLA_STATS_LINK_64 per tick (binary, ~200 bytes per interface, no text to parse),
+// plus an RTM_GETLINK dump for the names of new interfaces when the table is rebuilt.
+// dev_netlink_open returns NULL if the socket cannot be opened.
+typedef struct dev_netlink dev_netlink_t;
+dev_netlink_t *dev_netlink_open(void);
+int dev_netlink_read(dev_netlink_t *nl, dev_table_t *t); // -1 if the kernel lacks RTM_GETSTATS
+void dev_netlink_close(dev_netlink_t *nl);
+
+#endif // DEV_STATS_H
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// D-ary min-heap of ids with a position index, so a queued id's key can be changed
+// (decrease or increase) or the id removed in O(log_D n). Keys live in the heap entries
+// and compare with Less; equal keys come out in no particular order, so callers that
+// need a stable order put a sequence number in the key. D = 4 keeps the tree shallow
+// and a node's children in one or two cache lines.
+//
+// The position index is indexed by id. Heaps that never hold the same id at the same
+// time (per-CPU run queues over one process table) can share one index, so each heap
+// costs memory for what it holds rather than for every possible id.
+template <class Key, unsigned D = 4, class Less = std::less<Key>>
+class IndexedHeap {
+public:
+    using PosIndex = std::vector<std::uint32_t>;
+    static constexpr std::uint32_t kAbsent = UINT32_MAX;
+
+    explicit IndexedHeap(size_t capacity = 0) : pos_(&own_) { reset(capacity); }
+    explicit IndexedHeap(PosIndex& shared) : pos_(&shared) {}
+    IndexedHeap(const IndexedHeap&) = delete;
+    IndexedHeap& operator=(const IndexedHeap&) = delete;
+    IndexedHeap(IndexedHeap&& o) noexcept : heap_(std::move(o.heap_)), own_(std::move(o.own_)),
+        pos_(o.pos_ == &o.own_ ? &own_ : o.pos_) {}
+
+    // Own index only: empties the heap and sizes the index for ids 0..capacity-1.
+    void reset(size_t capacity) {
+        heap_.clear();
+        heap_.reserve(capacity);
+        own_.assign(capacity, kAbsent);
+    }
+    void reserve(size_t n) { heap_.reserve(n); }
+
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+    // With a shared index: queued in one of the heaps sharing it.
+    bool contains(int id) const { return (*pos_)[id] != kAbsent; }
+    int top() const { return heap_[0].id; }
+    const Key& topKey() const { return heap_[0].key; }
+    const Key& key(int id) const { return heap_[(*pos_)[id]].key; }
+
+    void push(int id, const Key& k) {
+        heap_.push_back({k, id});
+        siftUp(heap_.size() - 1);
+    }
+
+    int pop() {
+        int id = heap_[0].id;
+        removeAt(0);
+        return id;
+    }
+
+    // Inserts the id if it is not queued.
+    void update(int id, const Key& k) {
+        if (!contains(id)) { push(id, k); return; }
+        size_t i = (*pos_)[id];
+        bool up = less_(k, heap_[i].key);
+        heap_[i].key = k;
+        if (up) siftUp(i); else siftDown(i);
+    }
+
+    void erase(int id) {
+        if (contains(id)) removeAt((*pos_)[id]);
+    }
+
+private:
+    struct Entry { Key key; int id; };
+
+    void place(size_t i, Entry&& e) {
+        (*pos_)[e.id] = (std::uint32_t)i;
+        heap_[i] = std::move(e);
+    }
+
+    void removeAt(size_t i) {
+        (*pos_)[heap_[i].id] = kAbsent;
+        Entry last = std::move(heap_.back());
+        heap_.pop_back();
+        if (i == heap_.size()) return;
+        bool up = i > 0 && less_(last.key, heap_[(i - 1) / D].key);
+        place(i, std::move(last));
+        if (up) siftUp(i); else siftDown(i);
+    }
+
+    void siftUp(size_t i) {
+        Entry e = std::move(heap_[i]);
+        while (i > 0) {
+            size_t parent = (i - 1) / D;
+            if (!less_(e.key, heap_[parent].key)) break;
+            place(i, std::move(heap_[parent]));
+            i = parent;
+        }
+        place(i, std::move(e));
+    }
+
+    void siftDown(size_t i) {
+        Entry e = std::move(heap_[i]);
+        const size_t n = heap_.size();
+        for (;;) {
+            size_t first = i * D + 1;
+            if (first >= n) break;
+            size_t best = first, end = first + D < n ? first + D : n;
+            for (size_t c = first + 1; c < end; c++)
+                if (less_(heap_[c].key, heap_[best].key)) best = c;
+            if (!less_(heap_[best].key, e.key)) break;
+            place(i, std::move(heap_[best]));
+            i = best;
+        }
+        place(i, std::move(e));
+    }
+
+    std::vector<Entry> heap_;
+    PosIndex own_;
+    PosIndex* pos_;
+    Less less_;
+};
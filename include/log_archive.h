@@ -0,0 +1,50 @@
+#ifndef LOG_ARCHIVE_H
+#define LOG_ARCHIVE_H
+
+#include "monitor.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Log upkeep on one background thread at the lowest CPU and I/O priority (SCHED_IDLE,
+// idle I/O class), so it only runs on time the machine has spare.
+//
+// The logger rotates the text and binary logs itself (log_sink.c) once they reach
+// cfg.log_rotate_mb or cfg.log_rotate_s: log_archive_rotate renames the live file to
+// NAME-YYYYmmdd-HHMMSS-mmm.EXT (UTC) with one rename(2), and the logger reopens NAME
+// before its next batch, so no sample is dropped. The archiver then compresses each
+// closed segment with zlib (gzip, streamed through ARCHIVE_BUF buffers) into
+// NAME-....EXT.gz, written under a temporary name and renamed into place. The newest
+// cfg.log_keep compressed segments stay as they are; older ones are rolled up into the
+// 1m tier of a store beside the log (tsdb_rollup into PATH.tsdb) and deleted, so old
+// data stays queryable (tsq -d PATH.tsdb) at a coarser resolution while disk use stays
+// bounded. Each segment's rollup commits as a whole: one that fails partway is undone
+// (tsdb_tier_rewind) before the segment is rolled again. The segment store itself is
+// kept to cfg.log_segments raw segments, and each store's tiers to
+// TSDB_TIER_MAX_SEGMENTS, by tsdb_compact.
+//
+// A pass holds an flock on each directory it works in, so a running monitor and
+// `monitor --compact` never process the same file twice. Whatever a pass leaves
+// (a stop mid-file, segments from an earlier run) is picked up by the next one.
+
+#define ARCHIVE_PERIOD_S 60      // pass interval when nothing was rotated
+#define ARCHIVE_LEVEL 3          // zlib level: about twice as fast as the default (6) for ~25% more bytes
+#define ARCHIVE_BUF (64 * 1024)
+
+typedef struct log_archive log_archive_t;
+
+log_archive_t *log_archive_start(const monitor_config_t *cfg); // NULL with errno on failure
+void log_archive_notify(log_archive_t *a); // a segment was rotated: run a pass now
+// Takes log_keep and log_segments from a reloaded config, from the next pass on.
+void log_archive_configure(log_archive_t *a, const monitor_config_t *cfg);
+void log_archive_stop(log_archive_t *a);   // abandons the file in progress
+
+// Renames the live log at path to its rotated name (written to out). 0, or -1 with errno.
+int log_archive_rotate(const char *path, char *out, size_t cap);
+
+// One pass from the calling thread (monitor --compact). With rotate_live it first
+// rotates live logs over cfg.log_rotate_mb, which is only safe when no monitor is
+// writing them. Returns the number of files compressed, rolled up or retired.
+int log_archive_run(const monitor_config_t *cfg, bool rotate_live);
+
+#endif // LOG_ARCHIVE_H
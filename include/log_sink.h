@@ -0,0 +1,48 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include "monitor.h"
+
+// The logger's backend: the CSV text file, the binary columnar log or the segment
+// store, picked by cfg->log_format, at cfg->log_path or the format's default path
+// below. Paths are relative to the working directory.
+// The logger hands it metrics a batch at a time (mq_pop_batch) and flushes once per
+// batch; text lines collect in a buffer that each flush writes with one write(2).
+// The text and binary logs are rotated after a flush once they pass cfg->log_rotate_mb
+// or cfg->log_rotate_s (log_archive.h), and the archiver is told to take them.
+
+#define TEXT_LOG_PATH "data/logs/resource_log.txt"
+#define BINARY_LOG_PATH "data/logs/resource_log.bin"
+#define TEXT_LOG_BUF (64 * 1024) // a full buffer is written out mid-batch
+
+struct binlog;
+struct tsdb;
+struct log_archive;
+
+typedef struct {
+    int text_fd;     // -1 unless LOG_TEXT
+    char *text_buf;
+    size_t text_len;
+    struct binlog *bin;
+    struct tsdb *tsdb;
+    unsigned int sync_ms;
+    uint64_t last_sync;
+    const char *path;     // live text or binary log
+    uint64_t text_bytes;  // size of the text log
+    uint64_t opened_ms;   // when the live log was started
+    uint64_t rotate_bytes, rotate_ms; // 0: no limit
+    unsigned int flush_ms;
+    bool direct;
+    struct log_archive *archive; // NULL unless cfg->log_archive
+} log_sink_t;
+
+int log_sink_open(log_sink_t *s, const monitor_config_t *cfg); // 0, or -1 with errno reported
+void log_sink_metric(log_sink_t *s, const metric_t *m);
+// Alerts are derived from the aggregates, so the binary log does not store them.
+void log_sink_alert(log_sink_t *s, const metric_t *alert);
+// After each batch: write out the text buffer, tick the binary log, sync the store
+// every sync_ms.
+void log_sink_flush(log_sink_t *s);
+void log_sink_close(log_sink_t *s);
+
+#endif // LOG_SINK_H
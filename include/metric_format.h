@@ -0,0 +1,26 @@
+#ifndef METRIC_FORMAT_H
+#define METRIC_FORMAT_H
+
+#include "monitor.h"
+#include <stddef.h>
+
+// Text form of a metric as written to resource_log.txt, e.g. "1697654321000,CPU,42.35\n"
+// or, for METRIC_ALERT, "1697654323000,ALERT,CPU_HIGH,91.75\n" (CPU_CLEAR once it clears). Per-process kinds carry the
+// pid: "1697654323000,PROC_IO,812,4096,0\n". A sample that records the interval it
+// covers ends with it in ms: "1697654321000,CPU,42.35,500\n".
+// Numbers read as printf's "%.2f"/"%.0f" would print them, in the C locale.
+// Returns the line length, or 0 for kinds that are not logged (or if cap is too small).
+int metric_format_csv(char *buf, size_t cap, const metric_t *m);
+#define METRIC_LINE_MAX 160 // line buffer size; a metric whose numbers do not fit is not logged
+
+// Inverse of metric_format_csv for one line (the trailing newline is optional), up to
+// the rounding of the printed numbers; interval_ms is 0 for lines without one (logs
+// written before it was kept). Returns 0, or -1 if the line is not a metric.
+int metric_parse_csv(const char *line, metric_t *out);
+
+// Short column name used in the log ("CPU", "CPU_CORE", ...), or NULL.
+const char *metric_kind_name(metric_kind_t kind);
+// Inverse of metric_kind_name (case-insensitive); returns -1 if unknown.
+int metric_kind_from_name(const char *name);
+
+#endif // METRIC_FORMAT_H
@@ -0,0 +1,77 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "shm_metrics.h"
+
+#include <stdint.h>
+
+// Pull endpoint on a Unix stream socket, served by one epoll thread.
+//
+// The server is just another reader of the shared-memory region (shm_metrics.h): it
+// never talks to the collectors or the logger. It keeps the latest sample of every
+// series (kind + id) and serializes them once per update of the region (a new shm
+// `gen`); that one buffer is sent to every client asking until the next update, so
+// hundreds of scrapers cost one serialization per logger batch, not one per request.
+//
+// Binary protocol, native byte order (the socket is local). Every message starts with
+// a uint32 byte count of what follows. A client sends msrv_request_t and gets one
+// msrv_response_t followed by `count` msrv_record_t, and may then send the next
+// request on the same connection:
+//   MSRV_SNAPSHOT  the latest sample of every series seen in the last MSRV_SERIES_TTL_MS
+//   MSRV_RANGE     the kind's samples still in the shm ring (the last SHM_RING_LEN)
+//                  with ts_ms >= from_ms, only series `id` unless MSRV_ANY_ID
+// A connection that starts with "GET " instead gets the snapshot in the Prometheus
+// text exposition format over HTTP/1.0 and is closed, so
+//   curl --unix-socket data/monitor.sock http://localhost/metrics
+// works; it is built on first request after each update and shared the same way.
+
+#define MSRV_DEFAULT_PATH "data/monitor.sock"
+#define MSRV_VERSION 1
+#define MSRV_MAX_CLIENTS 1024
+#define MSRV_SERIES_TTL_MS 300000 // a series that has not been published for this long is dropped
+#define MSRV_ANY_ID UINT32_MAX
+
+typedef enum { MSRV_SNAPSHOT = 1, MSRV_RANGE = 2, MSRV_ERROR = 255 } msrv_op_t;
+
+typedef struct {
+    uint32_t len;      // sizeof(msrv_request_t) - 4
+    uint8_t op;        // msrv_op_t
+    uint8_t kind;      // MSRV_RANGE: metric_kind_t
+    uint16_t reserved;
+    uint32_t id;       // MSRV_RANGE: series id or MSRV_ANY_ID
+    uint32_t reserved2;
+    uint64_t from_ms;  // MSRV_RANGE: oldest ts_ms wanted
+} msrv_request_t;
+
+typedef struct {
+    uint32_t len;        // bytes after this field: 20 + count * sizeof(msrv_record_t)
+    uint8_t op;          // the request's op, or MSRV_ERROR for a bad request
+    uint8_t version;     // MSRV_VERSION
+    uint16_t reserved;
+    uint32_t count;
+    uint32_t gen;        // shm gen the data was taken at
+    uint64_t updated_ms; // when the monitor last published
+} msrv_response_t;
+
+typedef struct {
+    uint8_t kind;        // metric_kind_t
+    uint8_t reserved[3];
+    uint32_t id;
+    uint64_t ts_ms;
+    uint32_t interval_ms;
+    uint32_t reserved2;
+    double v1, v2;
+} msrv_record_t;
+
+_Static_assert(sizeof(msrv_request_t) == 24, "msrv_request_t layout");
+_Static_assert(sizeof(msrv_response_t) == 24, "msrv_response_t layout");
+_Static_assert(sizeof(msrv_record_t) == 40, "msrv_record_t layout");
+
+typedef struct metrics_server metrics_server_t;
+
+// Binds `path` (replacing a stale socket) and starts the server thread; NULL with
+// errno set on failure. Stop unlinks the socket.
+metrics_server_t *metrics_server_start(const char *path, const shm_metrics_t *shm);
+void metrics_server_stop(metrics_server_t *srv);
+
+#endif // METRICS_SERVER_H
@@ -2,16 +2,59 @@
 #define MONITOR_H
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <mqueue.h>
 
-// Configuration thresholds and sampling interval
+typedef enum {
+    LOG_TEXT,   // data/logs/resource_log.txt, one CSV line per metric
+    LOG_BINARY, // data/logs/resource_log.bin, see binlog.h
+    LOG_TSDB    // data/tsdb/ segment store, see tsdb.h
+} log_format_t;
+
+// Configuration thresholds and sampling interval. monitor_config.h sets it by name
+// from the command line or a config file; fields marked "live" follow SIGHUP reloads.
 typedef struct {
-    double cpu_alert_threshold;     // percent
-    double mem_alert_threshold;     // percent
-    unsigned int sample_interval_ms; // sampling interval for producers
-    unsigned int summary_interval_s; // how often to emit IPC summary
+    double cpu_alert_threshold;     // percent (live)
+    double mem_alert_threshold;     // percent (live)
+    unsigned int alert_window;      // agg_window_t whose mean is compared to the thresholds (live)
+    double alert_hysteresis;        // percent points below the threshold before an alert clears (live)
+    unsigned int sample_interval_ms; // sampling interval for producers (live)
+    bool adaptive;                   // cpu/mem/disk/net intervals follow the signal (adaptive.h, live)
+    unsigned int sample_min_ms;      // adaptive floor (live)
+    unsigned int sample_max_ms;      // adaptive ceiling (live)
+    const char *intervals;           // per-collector overrides, "name=ms,..." (NULL = none, live)
+    const char *collectors;          // only run these registry names, "name,..." (NULL = all enabled)
+    unsigned int summary_interval_s; // how often to emit IPC summary (live)
+    bool per_core_cpu;               // also emit per-core CPU state breakdowns
+    bool per_device;                 // also emit per-disk / per-interface metrics (dev_stats.h)
+    const char *disk_filter;         // disks counted, dev_filter_match patterns (NULL = default)
+    const char *net_filter;          // interfaces counted (NULL = default)
+    bool net_netlink;                // interface counters over rtnetlink instead of /proc/net/dev
+    bool psi;                        // pressure stall collector (pressure.h)
+    unsigned int psi_stall_ms;       // PSI trigger: alert as soon as "some" stall exceeds this...
+    unsigned int psi_window_ms;      // ...within this window (0 = no triggers, alerts from ticks only)
+    const char *cgroup_root;         // per-cgroup collector on this cgroup v2 root (NULL = off)
+    bool event_loop;                 // run all collectors from one timerfd/epoll thread
+    log_format_t log_format;
+    const char *log_path;            // text/binary log file or tsdb directory (NULL = the format's default)
+    unsigned int log_flush_ms;       // binary log: how often the open block is written out
+    bool log_direct;                 // binary log: write blocks with O_DIRECT
+    bool log_archive;                // rotate, compress and roll up old logs (log_archive.h)
+    unsigned int log_rotate_mb;      // text/binary log: rotate once it reaches this size (0 = never)...
+    unsigned int log_rotate_s;       // ...or this age (0 = never)
+    unsigned int log_keep;           // compressed log segments kept before they are rolled up (live)
+    unsigned int log_segments;       // tsdb: raw segments kept before they are rolled up (live with the archiver)
+    bool mq_summary;                 // also send the legacy text summary over POSIX mq
+    const char *metrics_socket;      // serve metrics on this Unix socket (metrics_server.h), NULL = off
+    unsigned int proc_top_k;         // per-process collector: report the top K pids (0 = off)
+    unsigned int proc_interval_ms;   // per-process and per-cgroup collector interval (live)
+    unsigned int proc_budget_us;     // per-process collector: max scan time per tick (0 = none)
+    const char *trace_path;          // per-process collector: capture CPU bursts here (proc_trace.h)
+    const char *shm_name;            // live metrics region (NULL = SHM_METRICS_NAME)
+    const char *config_path;         // re-read on SIGHUP (NULL = SIGHUP keeps its default action)
 } monitor_config_t;
 
 // Metric kinds
@@ -20,44 +63,88 @@ typedef enum {
     METRIC_MEM,
     METRIC_DISK,
     METRIC_NET,
-    METRIC_SUMMARY
+    METRIC_SUMMARY,
+    METRIC_CPU_CORE,      // id = core, v1 = user%, v2 = system%
+    METRIC_CPU_CORE_WAIT, // id = core, v1 = iowait%, v2 = steal%
+    METRIC_ALERT,         // id = metric kind that crossed its threshold, v1 = value, v2 = 1 when cleared
+    METRIC_PROC_CPU,      // id = pid, v1 = CPU% (top-K by CPU)
+    METRIC_PROC_RSS,      // id = pid, v1 = resident bytes (top-K by RSS)
+    METRIC_PROC_IO,       // id = pid, v1 = read B/s, v2 = write B/s (top-K by I/O)
+    METRIC_SELF,          // SELFSTAT builds: id = selfstat.h stat, v1/v2 = p50/p99 us or delta/total count
+    METRIC_DISK_DEV,      // id = DEV_KEY(major, minor), v1/v2 = sectors read/written
+    METRIC_NET_DEV,       // id = ifindex, v1/v2 = bytes received/sent
+    METRIC_PSI_CPU,       // v1/v2 = "some"/"full" stall time, % of the interval
+    METRIC_PSI_MEM,
+    METRIC_PSI_IO,
+    METRIC_CGROUP_CPU,    // id = cgroup id, v1 = CPU % of one CPU, v2 = throttled %
+    METRIC_CGROUP_MEM,    // id = cgroup id, v1 = memory.current bytes
+    METRIC_CGROUP_IO,     // id = cgroup id, v1/v2 = bytes read/written
+    METRIC_KIND_COUNT
 } metric_kind_t;
 
 typedef struct {
     metric_kind_t kind;
+    uint32_t id; // sub-entity for per-core/per-device kinds, 0 otherwise
     double v1; // usage percent or rate1
     double v2; // rate2 or extra
     uint64_t ts_ms; // epoch milliseconds
+    uint32_t interval_ms; // time the sample covers (since the collector's previous tick), 0 = not sampled
 } metric_t;
 
-// Simple bounded circular buffer for producer-consumer
-#define QUEUE_CAP 256
+// Bounded lock-free multi-producer / single-consumer ring (Vyukov-style per-slot
+// sequence numbers). Producers claim slots with a CAS on head; the single consumer
+// (logger_thread) owns tail. Head and tail live on separate cache lines so producers
+// and the consumer never false-share. Sleeping is done on futex words that are only
+// touched when the other side has actually parked.
+#define QUEUE_CAP 1024 // must be a power of two; sized for one per-core burst on large hosts
+#define MQ_CACHELINE 64
+typedef struct {
+    _Atomic uint64_t seq;
+    metric_t m;
+#ifdef MONITOR_SELFSTAT
+    uint64_t pushed_ns; // SELF_H_QUEUE
+#endif
+} mq_slot_t;
+
 typedef struct {
-    metric_t buf[QUEUE_CAP];
-    int head; // next write
-    int tail; // next read
-    int size; // current items
-    pthread_mutex_t mtx;
-    pthread_cond_t not_empty;
-    pthread_cond_t not_full;
+    _Alignas(MQ_CACHELINE) _Atomic uint64_t head; // next write (producers)
+    _Alignas(MQ_CACHELINE) uint64_t tail;         // next read (consumer only)
+    _Alignas(MQ_CACHELINE) _Atomic uint32_t items_seq;   // futex: bumped when a parked consumer must wake
+    _Atomic uint32_t consumer_parked;  // flag: logger is (about to be) asleep on items_seq
+    _Alignas(MQ_CACHELINE) _Atomic uint32_t space_seq;   // futex: bumped when parked producers must wake
+    _Atomic uint32_t producers_parked; // flag: at least one producer is waiting for space
+    _Atomic bool closed;
+    _Alignas(MQ_CACHELINE) mq_slot_t buf[QUEUE_CAP];
 } metric_queue_t;
 
 typedef struct {
     volatile bool running;
     monitor_config_t cfg;
     metric_queue_t queue;
-    mqd_t mq;              // POSIX message queue for IPC summaries
+    mqd_t mq;              // POSIX message queue for IPC summaries (cfg.mq_summary)
     char mq_name[64];      // e.g., "/sysmon_queue"
+    struct shm_metrics *shm; // live metrics region, see shm_metrics.h
+    pthread_mutex_t cfg_lock;     // held while a reload writes cfg's live fields and while threads read them
+    _Atomic unsigned int cfg_gen; // bumped after each reload; threads re-read when it moves
+    const char *const *overrides; // --KEY[=VALUE] command-line options, applied over the file on reload
+    int noverrides;
 } monitor_ctx_t;
 
 // Queue API
 void mq_init(metric_queue_t *q);
 void mq_destroy(metric_queue_t *q);
-bool mq_push(metric_queue_t *q, const metric_t *m);
-bool mq_pop(metric_queue_t *q, metric_t *out);
+bool mq_push(metric_queue_t *q, const metric_t *m);  // blocks while full; false once shut down
+bool mq_pop(metric_queue_t *q, metric_t *out);       // single consumer; false when shut down and empty
+// Like mq_pop for the first metric, then takes whatever else is already published, up
+// to max, without waiting. Returns the count, 0 when shut down and empty.
+size_t mq_pop_batch(metric_queue_t *q, metric_t *out, size_t max);
+void mq_shutdown(metric_queue_t *q);                 // wake every waiter and refuse further pushes
 
-// Monitor lifecycle
+// Monitor lifecycle. monitor_run blocks until SIGINT or monitor_stop (async-signal-safe),
+// taking up to a second to notice. With cfg.config_path, SIGHUP reloads the live
+// settings (monitor_config_reload).
 int monitor_run(monitor_ctx_t *ctx);
+void monitor_stop(void);
 
 // Utility
 uint64_t now_ms(void);
@@ -0,0 +1,39 @@
+#ifndef MONITOR_CONFIG_H
+#define MONITOR_CONFIG_H
+
+#include "monitor.h"
+
+// monitor_config_t by name. The command line (--KEY[=VALUE]) and the config file
+// (KEY = VALUE per line, # starts a comment) go through one table of keys, so every
+// option can be set in either place. A key without a value is a flag (adaptive,
+// no-psi, socket ...); flags also take true/false.
+//
+// SIGHUP re-reads cfg.config_path on top of the running config and applies only the
+// live keys: alert thresholds, window and hysteresis, the sampling intervals
+// (sample-ms, proc-interval-ms, intervals, adaptive and its bounds) and summary-s.
+// Collectors pick them up on their next tick and the logger on its next batch; no
+// thread is restarted and nothing queued is dropped. Any other key that changed is
+// reported as needing a restart and keeps its running value.
+
+#define MONITOR_CONFIG_DEFAULT_PATH "data/monitor.conf" // read at startup if present
+
+void monitor_config_defaults(monitor_config_t *cfg);
+
+// 0, or -1 with errno ENOENT (unknown key) or EINVAL (bad value). value is NULL for a
+// bare flag; string values are kept by pointer.
+int monitor_config_set(monitor_config_t *cfg, const char *key, const char *value);
+
+// One command-line option, "--KEY" or "--KEY=VALUE"; errors as monitor_config_set.
+int monitor_config_arg(monitor_config_t *cfg, const char *arg);
+
+// Applies the file line by line. String values point into *text, which the caller
+// frees once cfg no longer uses them. 0, or -1 with the error reported on stderr.
+int monitor_config_load(monitor_config_t *cfg, const char *path, char **text);
+
+// SIGHUP: rebuilds the config from the defaults, ctx->cfg.config_path and then
+// ctx->overrides, and publishes the live settings that changed (ctx->cfg_lock,
+// ctx->cfg_gen), so options given on the command line keep overriding the file. On
+// error the running config is kept. 0 or -1.
+int monitor_config_reload(monitor_ctx_t *ctx);
+
+#endif // MONITOR_CONFIG_H
@@ -0,0 +1,30 @@
+#ifndef PRESSURE_H
+#define PRESSURE_H
+
+#include <stdbool.h>
+
+// Pressure stall information, /proc/pressure/{cpu,memory,io} (Linux 4.20+): how long
+// tasks were stalled waiting for each resource. "some" is time at least one task
+// stalled, "full" time all non-idle tasks did.
+//
+//   some avg10=0.00 avg60=1.02 avg300=1.73 total=196542141
+//   full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+
+typedef enum { PSI_CPU, PSI_MEM, PSI_IO, PSI_RESOURCES } psi_resource_t;
+
+typedef struct { unsigned long long some_us, full_us; } psi_totals_t; // cumulative stall time
+
+#define PSI_DIR "/proc/pressure"
+
+const char *psi_file(psi_resource_t r); // "cpu", "memory", "io"
+
+int parse_psi(const char *buf, psi_totals_t *t);
+
+// Registers a trigger on a pressure file: the returned fd polls POLLPRI (EPOLLPRI)
+// once per window in which "some" (or "full") stall time exceeded stall_us. The window
+// must be 500 ms..10 s; unprivileged, the kernel only takes multiples of 2 s, so the
+// window is then rounded up (and *window_us updated) with the stall scaled to match.
+// Returns -1 with errno set if the kernel refuses.
+int psi_trigger_open(const char *path, bool full, unsigned int stall_us, unsigned int *window_us);
+
+#endif // PRESSURE_H
@@ -0,0 +1,57 @@
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// Persistent reader for small /proc text files.
+// The fd stays open for the lifetime of the collector and every sample is a single
+// pread() at offset 0 into a preallocated buffer; the buffer only grows when a file
+// outgrows it, so steady-state sampling does no allocation and no stdio.
+typedef struct {
+    int fd;
+    char *buf;
+    size_t cap;  // buffer capacity in bytes
+    size_t len;  // bytes returned by the last pf_read
+} proc_file_t;
+
+int pf_open(proc_file_t *pf, const char *path, size_t initial_cap);
+ssize_t pf_read(proc_file_t *pf); // re-reads the file, NUL-terminates pf->buf, returns length or -1
+void pf_close(proc_file_t *pf);
+
+// Minimal tokenizer over a NUL-terminated buffer. None of these cross a newline
+// except pr_next_line, so callers walk /proc files line by line.
+static inline const char *pr_skip_blanks(const char *p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+static inline const char *pr_skip_token(const char *p) {
+    p = pr_skip_blanks(p);
+    while (*p && *p != ' ' && *p != '\t' && *p != '\n') p++;
+    return p;
+}
+
+static inline const char *pr_next_line(const char *p) {
+    while (*p && *p != '\n') p++;
+    return *p ? p + 1 : p;
+}
+
+// Parses the next unsigned decimal on the current line; returns false if there is none.
+static inline bool pr_next_u64(const char **pp, unsigned long long *out) {
+    const char *p = pr_skip_blanks(*pp);
+    if (*p < '0' || *p > '9') { *pp = p; return false; }
+    unsigned long long v = 0;
+    while (*p >= '0' && *p <= '9') v = v * 10 + (unsigned long long)(*p++ - '0');
+    *out = v;
+    *pp = p;
+    return true;
+}
+
+static inline bool pr_starts_with(const char *p, const char *prefix) {
+    while (*prefix) { if (*p++ != *prefix++) return false; }
+    return true;
+}
+
+#endif // PROC_READER_H
@@ -0,0 +1,66 @@
+#ifndef PROC_SCAN_H
+#define PROC_SCAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Incremental per-process scanner over /proc/[pid].
+//
+// Every tick lists the root with getdents64 into a reusable buffer and reconciles it
+// against a pid-indexed open-addressing hash of live entries: new pids get an entry (and
+// their stat/io files opened once, while the fd budget lasts), vanished pids are
+// dropped. Entries are then sampled round-robin until the per-tick time budget runs out;
+// the next tick resumes where this one stopped, and rates are computed over each
+// entry's own interval, so a budget-limited scan just samples some pids less often.
+// After sampling, bounded min-heaps pick the top K by CPU, RSS and I/O.
+
+#define PROC_SCAN_DEFAULT_ROOT "/proc"
+
+typedef struct {
+    uint32_t pid;
+    double cpu_pct;     // of one CPU over the entry's last interval
+    uint64_t rss_bytes;
+    double read_bps;    // storage bytes read/written per second (/proc/[pid]/io)
+    double write_bps;
+} proc_top_t;
+
+// CPU a process used since its previous sample, for workload capture.
+typedef struct {
+    uint32_t pid;
+    uint32_t ticks;     // user + system time in clock ticks (proc_scan_hz per second)
+    int32_t nice;
+} proc_burst_t;
+
+typedef enum { PROC_BY_CPU, PROC_BY_RSS, PROC_BY_IO, PROC_RANK_COUNT } proc_rank_t;
+
+typedef struct {
+    size_t npids;         // live entries after the last listing
+    size_t sampled;       // entries read during the last tick
+    size_t cached_fds;    // files kept open across ticks
+    uint64_t list_ns;     // getdents64 + reconcile
+    uint64_t sample_ns;   // reading stat/io
+    uint64_t rank_ns;     // top-K selection
+    bool budget_hit;      // the last tick stopped before visiting every entry
+} proc_scan_stats_t;
+
+typedef struct proc_scan proc_scan_t;
+
+// root is normally PROC_SCAN_DEFAULT_ROOT; benchmarks point it at a synthetic tree.
+// max_fds caps the stat/io files kept open (0 = half of RLIMIT_NOFILE); pids past the
+// cap are opened and closed on every sample instead.
+proc_scan_t *proc_scan_open(const char *root, int top_k, size_t max_fds);
+// One tick. budget_us = 0 samples every entry. Returns the number of entries sampled or -1.
+int proc_scan_tick(proc_scan_t *ps, uint64_t budget_us);
+// Ranked results of the last tick, highest first.
+size_t proc_scan_top(const proc_scan_t *ps, proc_rank_t by, const proc_top_t **out);
+// Burst tracking (off by default): every tick then also lists the sampled pids that
+// used CPU since their previous sample. Processes already running when the scan
+// started only contribute from their second sample on.
+void proc_scan_track_bursts(proc_scan_t *ps, bool on);
+size_t proc_scan_bursts(const proc_scan_t *ps, const proc_burst_t **out);
+long proc_scan_hz(const proc_scan_t *ps);
+void proc_scan_get_stats(const proc_scan_t *ps, proc_scan_stats_t *out);
+void proc_scan_close(proc_scan_t *ps);
+
+#endif // PROC_SCAN_H
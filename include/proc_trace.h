@@ -0,0 +1,35 @@
+#ifndef PROC_TRACE_H
+#define PROC_TRACE_H
+
+#include "proc_scan.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Workload trace capture: the CPU bursts proc_scan observes, appended to a compact file
+// that the scheduler simulator replays (trace_loader.h).
+//
+// Header: PROC_TRACE_MAGIC, then a little-endian uint32 of clock ticks per second.
+// Then one block per capture tick:
+//   varint   ticks since the previous block (the first: since the capture started)
+//   varint   record count
+//   count x  { varint pid, varint CPU ticks, zigzag varint nice }
+// A record is one CPU burst: the process used that much CPU in the interval that ended
+// at the block's time, which the simulator takes as its arrival. Times only grow, so
+// the file is already in arrival order. A typical record is 4-6 bytes. Each block goes
+// out in one write(), so a capture cut short loses at most its last block.
+
+#define PROC_TRACE_MAGIC "SCHTRS01"
+
+typedef struct proc_trace proc_trace_t;
+
+// Creates (truncates) path.
+proc_trace_t *proc_trace_open(const char *path, uint32_t hz);
+// Appends the bursts seen at `ticks` (clock ticks since the capture started). Empty
+// ticks write nothing. Returns 0 or -1 on a write error.
+int proc_trace_append(proc_trace_t *t, uint64_t ticks, const proc_burst_t *b, size_t n);
+uint64_t proc_trace_records(const proc_trace_t *t);
+uint64_t proc_trace_bytes(const proc_trace_t *t);
+int proc_trace_close(proc_trace_t *t);
+
+#endif // PROC_TRACE_H
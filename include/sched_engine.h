@@ -0,0 +1,78 @@
+#pragma once
+#include "scheduler.h"
+#include <climits>
+#include <cstddef>
+#include <functional>
+
+// Discrete-event simulation core shared by all scheduling algorithms.
+//
+// The engine merges four time-ordered event sources (arrivals, the policy timer, the
+// load-balance timer, slice ends) and jumps from one event time to the next. At each
+// event time it admits arrivals, ends slices that expire, lets the policy preempt the
+// running processes, then dispatches from the policy's ready sets. Only CPUs touched by
+// an event are looked at, so a step costs O(affected CPUs), not O(cores).
+//
+// Each CPU has its own run queue inside the policy; the engine decides which queue a
+// process joins (placement, stealing, balancing, affinity) and counts migrations.
+// Policies see processes as dense indices into the arrival-sorted trace and only decide
+// order and slice length; the engine does all time keeping, Gantt output and metrics.
+//
+// At equal times arrivals are admitted before a slice that ends then is requeued, as
+// in the original Round Robin loop.
+
+constexpr int kRunToCompletion = INT_MAX;
+constexpr int kNoTimer = INT_MAX;
+
+// What the engine knows about the process on a CPU at `now`.
+struct RunningView {
+    int idx;
+    int start;      // when this slice began
+    int remaining;  // burst left as of now
+};
+
+// Arrival: first time ready. Requeue: left its CPU with work left (slice end,
+// preemption). Migrate: taken from another CPU's queue by steal().
+enum class EnqueueReason { Arrival, Requeue, Migrate };
+
+class SchedPolicy {
+public:
+    virtual ~SchedPolicy() = default;
+    // p is the process table; every index below refers into it. cores >= 1. In batch
+    // runs it is the whole arrival-sorted trace. In streaming runs it starts empty, grows
+    // (see grow) and reuses the index of a finished process for a later arrival, so
+    // per-process state must be set up again on EnqueueReason::Arrival.
+    virtual void init(const std::vector<Process>& p, int cores) = 0;
+    // Streaming runs: the table grew to n entries.
+    virtual void grow(size_t n) { (void)n; }
+    // idx joins the run queue of `core`.
+    virtual void enqueue(int core, int idx, int now, EnqueueReason why, int remaining) = 0;
+    // Removes and returns the next process for `core`, or -1 when its queue is empty.
+    virtual int pickNext(int core, int now) = 0;
+    // Removes a process from `core`'s queue so it can move to another CPU; -1 if none.
+    virtual int steal(int core, int now) { return pickNext(core, now); }
+    // Longest the picked process may run before it is requeued.
+    virtual int slice(int core, int idx, int now) { (void)core; (void)idx; (void)now; return kRunToCompletion; }
+    // Asked when `core`'s queue changed; true stops the running process now.
+    virtual bool shouldPreempt(int core, const RunningView& run, int now) { (void)core; (void)run; (void)now; return false; }
+    // A slice of idx ran on `core` over [start, end).
+    virtual void ran(int core, int idx, int start, int end, bool finished) {
+        (void)core; (void)idx; (void)start; (void)end; (void)finished;
+    }
+    // Next time onTimer should run (aging and the like), or kNoTimer. Timers may touch
+    // any queue, so every busy CPU gets a preemption check afterwards.
+    virtual int nextTimer() const { return kNoTimer; }
+    virtual void onTimer(int now) { (void)now; }
+};
+
+enum class RowOrder { Arrival, Completion };
+
+ScheduleReport simulate(const std::vector<Process>& procs, SchedPolicy& policy, const char* name,
+                        RowOrder order, const SchedOptions& opt);
+
+// Same simulation over processes pulled from `next` (false = no more) in arrival order.
+// Only live processes are held, so memory follows the peak number of processes that
+// have arrived and not finished, not the trace length. The report has the averages,
+// dispatches and per-CPU figures but no rows or Gantt charts. peakLive, if given,
+// receives that peak.
+ScheduleReport simulateStream(const std::function<bool(Process&)>& next, SchedPolicy& policy, const char* name,
+                              const SchedOptions& opt, size_t* peakLive = nullptr);
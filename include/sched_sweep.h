@@ -0,0 +1,55 @@
+#pragma once
+#include "scheduler.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Parameter sweeps: many independent (algorithm, parameters, trace) jobs run on a
+// work-stealing thread pool. Traces are loaded once and shared read-only between jobs;
+// summaries are handed to a callback as each job finishes.
+
+struct Trace {
+    std::string name;
+    std::vector<Process> procs;
+};
+using TracePtr = std::shared_ptr<const Trace>;
+
+struct SweepJob {
+    Algorithm algo;
+    int quantum = 2;       // RoundRobin
+    int mlqCutoff = 1;     // MultilevelQueue
+    int mlqQuantum = 2;    // MultilevelQueue
+    int cores = 1;
+    size_t trace = 0;      // index into the trace list
+};
+
+struct SweepSpec {
+    std::vector<int> rrQuanta{2};
+    std::vector<int> mlqCutoffs{1};
+    std::vector<int> mlqQuanta{2};
+    std::vector<int> cores{1};
+};
+
+struct SweepResult {
+    const SweepJob* job;
+    const Trace* trace;
+    ScheduleReport report; // Gantt is never recorded in a sweep
+};
+
+// For every trace and CPU count: FCFS, SJF, Priority, SRTF, PreemptivePriority and Fair
+// once, RR once per quantum, MLQ once per (cutoff, quantum) pair.
+std::vector<SweepJob> expandSweep(const SweepSpec& spec, size_t traces);
+
+ScheduleReport runJob(const SweepJob& job, const std::vector<Process>& procs, const SchedOptions& base = {});
+
+struct SweepStats {
+    unsigned threads;
+    std::uint64_t steals; // jobs taken from another worker's deque
+};
+
+// Runs every job on `threads` workers (0 = hardware concurrency). onResult is called
+// from worker threads, one call at a time, in completion order. `base` supplies the
+// options a job does not set itself (balancing, affinity, policy tunables).
+SweepStats runSweep(const std::vector<TracePtr>& traces, const std::vector<SweepJob>& jobs, unsigned threads,
+                    const std::function<void(const SweepResult&)>& onResult, const SchedOptions& base = {});
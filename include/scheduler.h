@@ -1,4 +1,7 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -17,6 +20,40 @@ struct ResultRow {
 
 struct GanttSlice { int pid; int start; int end; };
 
+// Full keeps one slice per dispatch; Merged joins back-to-back slices of the same pid
+// (run-length); None skips the timeline entirely (large traces, benchmarks).
+enum class GanttMode { Full, Merged, None };
+
+// Multi-CPU runs: how work moves between per-CPU run queues.
+// Steal: a CPU that goes idle takes the next process from the longest queue.
+// Periodic: every balanceInterval, processes move from the longest queue to the
+// shortest until they differ by at most one. None: a process stays where it arrived.
+enum class Balance { Steal, Periodic, None };
+// Free: arrivals go to the least loaded CPU. Pinned: process pid runs on CPU pid % cores
+// only (no stealing or balancing).
+enum class Affinity { Free, Pinned };
+
+struct SchedOptions {
+    GanttMode gantt = GanttMode::Full;
+    int mlqCutoff = 1;  // MLQ: priority <= cutoff goes to the high (Round Robin) queue
+    int mlqQuantum = 2; // MLQ: quantum of the high queue
+    int agingInterval = 10;    // PreemptivePriority: waiting time per one-step priority boost
+    int cfsLatency = 6;        // Fair: period in which every runnable process should run once
+    int cfsMinGranularity = 1; // Fair: shortest slice, and the wakeup preemption margin
+    int cores = 1;
+    Balance balance = Balance::Steal;
+    int balanceInterval = 20;
+    Affinity affinity = Affinity::Free;
+};
+
+struct CoreReport {
+    std::vector<GanttSlice> gantt; // per-CPU timeline; only filled when cores > 1
+    std::int64_t busy{};           // time spent running processes
+    std::uint64_t dispatches{};
+    std::uint64_t migrations{};    // dispatches of a process that last ran on another CPU
+    double utilisation{};          // busy / makespan
+};
+
 struct ScheduleReport {
     std::string algorithm;
     std::vector<ResultRow> rows;
@@ -24,10 +61,33 @@ struct ScheduleReport {
     double avgTurnaround{};
     double throughput{}; // processes per unit time
     std::vector<GanttSlice> gantt;
+    std::uint64_t dispatches{}; // times a process was put on the CPU
+    std::vector<CoreReport> cores;
+    std::uint64_t migrations{};
+    std::uint64_t completed{}; // processes behind the averages (streaming runs keep no rows)
 };
 
-ScheduleReport runFCFS(const std::vector<Process>&);
-ScheduleReport runSJF(const std::vector<Process>&);
-ScheduleReport runRoundRobin(const std::vector<Process>&, int quantum);
-ScheduleReport runPriority(const std::vector<Process>&);
-ScheduleReport runMultilevelQueue(const std::vector<Process>&);
+// Every algorithm is a policy on the discrete-event core in sched_engine.h: dense
+// indices into an arrival-sorted copy of the input, time advancing from event to event,
+// output reserved up front.
+ScheduleReport runFCFS(const std::vector<Process>&, const SchedOptions& = {});
+ScheduleReport runSJF(const std::vector<Process>&, const SchedOptions& = {});
+ScheduleReport runRoundRobin(const std::vector<Process>&, int quantum, const SchedOptions& = {});
+ScheduleReport runPriority(const std::vector<Process>&, const SchedOptions& = {});
+ScheduleReport runMultilevelQueue(const std::vector<Process>&, const SchedOptions& = {});
+// Preemptive: shortest remaining time first.
+ScheduleReport runSRTF(const std::vector<Process>&, const SchedOptions& = {});
+// Preemptive priority with aging (SchedOptions::agingInterval).
+ScheduleReport runPreemptivePriority(const std::vector<Process>&, const SchedOptions& = {});
+// CFS-like weighted fair scheduling on vruntime; priority is the nice value.
+ScheduleReport runFair(const std::vector<Process>&, const SchedOptions& = {});
+
+enum class Algorithm { FCFS, SJF, RoundRobin, Priority, MultilevelQueue, SRTF, PreemptivePriority, Fair };
+
+const char* algorithmName(Algorithm a);
+
+// Streaming replay (simulateStream in sched_engine.h): processes come from `next` in
+// arrival order and only live ones are held, so a long captured trace replays in bounded
+// memory. No rows or Gantt chart; quantum is Round Robin's.
+ScheduleReport replayStream(Algorithm a, const std::function<bool(Process&)>& next, int quantum,
+                            const SchedOptions& = {}, size_t* peakLive = nullptr);
@@ -0,0 +1,81 @@
+#ifndef SELFSTAT_H
+#define SELFSTAT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Self-instrumentation: what the monitor itself costs. Built only by `make SELFSTAT=1`
+// (-DMONITOR_SELFSTAT); otherwise every SELF_* macro below expands to nothing, its
+// arguments are not evaluated and selfstat.c is not linked.
+//
+// Each thread records into its own block (counters and log-linear latency histograms),
+// so recording is a plain load and store with no lock prefix and no shared cache line.
+// Blocks are linked into a global list on first use and summed by readers without
+// stopping the writers. Times come from CLOCK_MONOTONIC (vDSO, no syscall).
+
+// Latency histograms. The per-collector sample time includes its mq_push calls.
+typedef enum {
+    SELF_H_PUSH_WAIT, // mq_push waiting for space in a full ring
+    SELF_H_QUEUE,     // a metric's time in the ring, push to pop
+    SELF_H_WRITE,     // logger: one metric formatted into the log backend
+    SELF_H_FLUSH,     // logger: text write / binlog tick / tsdb sync after each batch
+    SELF_H_SAMPLE,    // collector i's tick is SELF_H_SAMPLE + i (monitor_collectors order)
+    SELF_H_COUNT = SELF_H_SAMPLE + 16
+} self_hist_t;
+
+typedef enum {
+    SELF_C_PUSH_BLOCKED,   // mq_push found the ring full
+    SELF_C_PUSH_WAKE,      // producer paid for a futex wake of the logger
+    SELF_C_CONSUMER_PARK,  // logger slept on an empty ring
+    SELF_C_COUNT
+} self_counter_t;
+
+// METRIC_SELF ids: histograms first, then counters.
+#define SELF_COUNTER_ID(c) (SELF_H_COUNT + (c))
+
+// Buckets cover [2^k, 2^(k+1)) ns in 8 linear steps (<= 12.5% error) up to ~68 s.
+#define SELF_SUB_BITS 3
+#define SELF_MAX_BITS 36
+#define SELF_BUCKETS ((SELF_MAX_BITS - SELF_SUB_BITS + 1) << SELF_SUB_BITS)
+
+typedef struct {
+    uint64_t hist[SELF_H_COUNT][SELF_BUCKETS];
+    uint64_t counters[SELF_C_COUNT];
+} self_snapshot_t;
+
+#ifdef MONITOR_SELFSTAT
+
+uint64_t self_now_ns(void);
+void self_thread(const char *name);            // names the calling thread's block in dumps
+void self_name_sampler(int i, const char *name);
+void self_count(self_counter_t c);
+void self_record(self_hist_t h, uint64_t ns);
+
+// Sums every thread's block into *out.
+void self_snapshot(self_snapshot_t *out);
+// Value at quantile q (0..1) of cur - prev (prev may be NULL), in ns; 0 when empty.
+uint64_t self_quantile(const uint64_t *cur, const uint64_t *prev, double q);
+// Writes "name" for a METRIC_SELF id.
+void self_stat_name(int id, char *buf, size_t cap);
+// Counters per thread, then count/p50/p90/p99/p99.9/max per histogram.
+void self_dump(FILE *f);
+
+#define SELF_THREAD(name) self_thread(name)
+#define SELF_NAME_SAMPLER(i, name) self_name_sampler((i), (name))
+#define SELF_COUNT(c) self_count(c)
+#define SELF_TIME_START(t) uint64_t t = self_now_ns()
+#define SELF_STAMP(lv) ((lv) = self_now_ns())
+#define SELF_TIME_END(h, t) self_record((self_hist_t)(h), self_now_ns() - (t))
+
+#else
+
+#define SELF_THREAD(name) ((void)0)
+#define SELF_NAME_SAMPLER(i, name) ((void)0)
+#define SELF_COUNT(c) ((void)0)
+#define SELF_TIME_START(t) ((void)0)
+#define SELF_STAMP(lv) ((void)0)
+#define SELF_TIME_END(h, t) ((void)0)
+
+#endif // MONITOR_SELFSTAT
+
+#endif // SELFSTAT_H
@@ -0,0 +1,80 @@
+#ifndef SHM_METRICS_H
+#define SHM_METRICS_H
+
+#include "monitor.h"
+#include "aggregate.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Shared-memory live metrics channel (shm_open + mmap).
+//
+// One region per monitor holds, for every metric kind, a seqlock-protected latest
+// sample, a ring of the most recent samples and (refreshed about once a second) the
+// rolling-window aggregates from aggregate.h. The monitor is the only writer and
+// never blocks: readers poll, or sleep on the shared `gen` futex which the writer bumps
+// after each batch. Readers map the region read-only, so any number can attach and a
+// slow one cannot stall the monitor; a reader that falls more than a ring behind just
+// skips ahead.
+
+#define SHM_METRICS_NAME "/sysmon_metrics"
+#define SHM_METRICS_MAGIC 0x4D485353u // "SSHM"
+#define SHM_METRICS_VERSION 2
+#define SHM_RING_LEN 256 // samples kept per kind; power of two
+
+typedef struct {
+    uint64_t ts_ms;
+    uint32_t id;
+    uint32_t interval_ms; // metric_t.interval_ms
+    double v1;
+    double v2;
+} shm_sample_t;
+
+typedef struct {
+    _Atomic uint64_t seq; // sample index + 1 once the slot is complete, 0 while being written
+    shm_sample_t s;
+} shm_slot_t;
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t latest_seq; // seqlock: odd while `latest` is being written
+    shm_sample_t latest;
+    _Atomic uint64_t head;                    // samples ever published for this kind
+    shm_slot_t ring[SHM_RING_LEN];
+    _Alignas(64) _Atomic uint32_t agg_seq;    // seqlock for `agg`, 0 until first published
+    agg_summary_t agg;
+} shm_kind_t;
+
+typedef struct shm_metrics {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nkinds;
+    uint32_t ring_len;
+    int32_t writer_pid;
+    _Alignas(64) _Atomic uint32_t gen; // futex word, bumped by shm_metrics_notify
+    _Atomic uint64_t updated_ms;
+    shm_kind_t kinds[METRIC_KIND_COUNT];
+} shm_metrics_t;
+
+// Writer side (monitor)
+shm_metrics_t *shm_metrics_create(const char *name);
+void shm_metrics_publish(shm_metrics_t *shm, const metric_t *m);
+void shm_metrics_publish_agg(shm_metrics_t *shm, metric_kind_t kind, const agg_summary_t *agg);
+void shm_metrics_notify(shm_metrics_t *shm); // wake futex waiters after a batch of publishes
+void shm_metrics_destroy(shm_metrics_t *shm, const char *name);
+
+// Reader side
+const shm_metrics_t *shm_metrics_attach(const char *name);
+void shm_metrics_detach(const shm_metrics_t *shm);
+// False if nothing has been published yet, or the writer has stayed mid-update for
+// about 10 ms (killed inside a publish), rather than spinning on it.
+bool shm_metrics_latest(const shm_metrics_t *shm, metric_kind_t kind, shm_sample_t *out);
+bool shm_metrics_aggregates(const shm_metrics_t *shm, metric_kind_t kind, agg_summary_t *out);
+// Copies samples of `kind` newer than *cursor (a per-kind sample count) into out and
+// advances the cursor. Returns the number copied.
+size_t shm_metrics_read(const shm_metrics_t *shm, metric_kind_t kind, uint64_t *cursor,
+                        shm_sample_t *out, size_t max);
+// Sleeps until gen != seen or timeout_ms passes (<0 waits forever); returns the new gen.
+uint32_t shm_metrics_wait(const shm_metrics_t *shm, uint32_t seen, int timeout_ms);
+
+#endif // SHM_METRICS_H
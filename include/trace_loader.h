@@ -0,0 +1,76 @@
+#pragma once
+#include "scheduler.h"
+#include <climits>
+#include <string>
+#include <vector>
+
+// Scheduler workload loading.
+//
+// CSV traces (PID,Arrival,Burst,Priority; ',' or ';' separated, optional header line)
+// are memory-mapped and parsed in place with std::from_chars. Large files are split at
+// line boundaries into one chunk per thread and the chunks are merged in file order.
+// Rows with fewer than four integers are skipped.
+//
+// Binary traces start with TRACE_MAGIC, then a little-endian uint64 row count and
+// `count` records of four int32 (pid, arrival, burst, priority). They load with a
+// single copy and are meant for repeated runs over the same large workload.
+//
+// Captured traces (PROC_TRACE_MAGIC, written by the monitor with --trace, format in
+// proc_trace.h) hold one record per observed CPU burst: pid, the block time as arrival,
+// CPU clock ticks as burst and nice as priority.
+
+#define TRACE_MAGIC "SCHTRC01"
+
+struct TraceLoadStats {
+    size_t bytes = 0;
+    size_t rows = 0;
+    size_t skipped = 0; // non-empty lines that did not parse
+    unsigned chunks = 0;
+    bool binary = false;
+    bool captured = false;
+    bool truncated = false; // captured trace ends inside a block
+};
+
+// Detects the format from the first bytes. threads = 0 uses hardware concurrency.
+// Returns an empty vector if the file cannot be read.
+std::vector<Process> loadTrace(const std::string& path, unsigned threads = 0, TraceLoadStats* stats = nullptr);
+
+bool saveBinaryTrace(const std::string& path, const std::vector<Process>& procs);
+
+// Reads a trace of any format one process at a time through a fixed-size buffer, for
+// replays that must not hold the whole trace in memory. The trace must already be in
+// arrival order (captured traces always are); an earlier arrival stops the reader with
+// an error, since sorting would need the whole file.
+class TraceReader {
+public:
+    explicit TraceReader(const std::string& path, size_t bufferBytes = 1 << 20);
+    ~TraceReader();
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    // False at the end of the trace or on an error.
+    bool next(Process& out);
+    // Empty unless the trace could not be opened or read, is corrupt, or is unsorted.
+    const std::string& error() const { return error_; }
+    const TraceLoadStats& stats() const { return st_; }
+
+private:
+    enum class Format { Csv, Binary, Captured };
+    bool fill();
+    bool nextCsv(Process& out);
+    bool nextBinary(Process& out);
+    bool nextCaptured(Process& out);
+    bool fail(const char* what);
+
+    int fd_ = -1;
+    std::vector<char> buf_;
+    size_t pos_ = 0, len_ = 0;
+    bool eof_ = false;
+    Format fmt_ = Format::Csv;
+    bool header_ = true;       // CSV: the first non-empty line may be a header
+    std::uint64_t left_ = 0;   // binary: records left; captured: records left in the block
+    std::int64_t time_ = 0;    // captured: time of the current block
+    int lastArrival_ = INT_MIN;
+    std::string error_;
+    TraceLoadStats st_;
+};
@@ -0,0 +1,93 @@
+#ifndef TSDB_H
+#define TSDB_H
+
+#include "monitor.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Memory-mapped, append-only time-series store for metric_t samples.
+//
+// The store is a directory of fixed-size segment files (seg-00000001.tsm, ...). Each
+// segment is preallocated and mmapped: a header page, a sparse index with one entry per
+// TSDB_INDEX_STRIDE records, then fixed 32-byte records in append order. Index entries
+// hold the running maximum timestamp, so a time-range lookup is a binary search over
+// the index followed by a sequential scan. When a segment fills, the writer rotates to
+// a new one and deletes the oldest segments beyond max_segments.
+//
+// Retention tiers. With max_segments = TSDB_KEEP_ALL the writer never deletes, and
+// tsdb_compact (run by the log archiver, log_archive.h) keeps the newest segments
+// instead, rolling older ones up rather than deleting them: into DIR/1m one record per
+// (kind, id) per minute, holding the time-weighted means of v1 and v2 and the time they
+// cover as interval_ms; segments leaving DIR/1m the same way into DIR/1h, whose records
+// count interval_ms in seconds. Only DIR/1h deletes. Alerts are kept one by one,
+// stamped with their bucket. Queries read each tier for the part of the range older
+// than what the finer tiers hold, so min/max/percentiles that reach back into a tier
+// are over its bucket means.
+
+#define TSDB_MAGIC 0x31445354u // "TSD1"
+#define TSDB_VERSION 1
+#define TSDB_INDEX_STRIDE 64
+#define TSDB_DEFAULT_DIR "data/tsdb"
+#define TSDB_DEFAULT_SEGMENT_BYTES (16u << 20)
+#define TSDB_DEFAULT_MAX_SEGMENTS 64
+// Producers stamp samples independently, so records are only roughly time ordered.
+// A range scan stops once it is this far past the end of the range.
+#define TSDB_REORDER_SLACK_MS 5000
+#define TSDB_KEEP_ALL UINT32_MAX
+#define TSDB_TIERS 3                        // raw, 1m, 1h
+#define TSDB_TIER_SEGMENT_BYTES (4u << 20)
+#define TSDB_TIER_MAX_SEGMENTS 64
+
+typedef struct {
+    uint64_t ts_ms;
+    uint16_t kind;
+    uint16_t interval_ms; // metric_t.interval_ms, saturated; 0 = unknown (segments from before it was kept)
+    uint32_t id;
+    double v1;
+    double v2;
+} tsdb_record_t;
+
+typedef struct tsdb tsdb_t;
+
+tsdb_t *tsdb_open(const char *dir, size_t segment_bytes, unsigned int max_segments);
+int tsdb_append(tsdb_t *db, const metric_t *m);
+void tsdb_sync(tsdb_t *db); // schedule write-back of dirty pages (MS_ASYNC)
+void tsdb_close(tsdb_t *db);
+
+// Keeps max_segments raw and TSDB_TIER_MAX_SEGMENTS per tier, rolling the rest up.
+// Returns the number of segments retired, or -1 if dir cannot be read.
+int tsdb_compact(const char *dir, unsigned int max_segments);
+// Rolls metrics (in any order) up into tier 1 or 2 of the store at dir; this is how
+// archived text and binary logs (log_archive.h) end up in the tiers.
+int tsdb_rollup(const char *dir, int tier, const metric_t *ms, size_t n);
+
+// Where a tier ends: its newest segment and that segment's record count (0, 0 when the
+// tier is empty). Rewinding drops everything appended since the mark, so a rollup that
+// fails partway can be undone and run again without counting any sample twice.
+typedef struct { unsigned int seg; uint64_t count; } tsdb_mark_t;
+int tsdb_tier_mark(const char *dir, int tier, tsdb_mark_t *m);
+int tsdb_tier_rewind(const char *dir, int tier, const tsdb_mark_t *m);
+
+// ---- Queries (read-only, safe while a writer is appending) ----
+
+#define TSDB_ANY_ID UINT32_MAX
+
+typedef bool (*tsdb_visit_fn)(const tsdb_record_t *r, void *arg); // return false to stop
+
+// Visits every record of `kind` (and `id`, unless TSDB_ANY_ID) with t0 <= ts <= t1.
+int tsdb_query(const char *dir, metric_kind_t kind, uint32_t id, uint64_t t0, uint64_t t1,
+               tsdb_visit_fn fn, void *arg);
+
+typedef struct {
+    uint64_t count;
+    double min, max, avg;
+    double pct[8]; // filled for each requested percentile
+} tsdb_stats_t;
+
+// Summary of v1 (or v2 when use_v2) over a range; pcts are in [0,100].
+int tsdb_stats(const char *dir, metric_kind_t kind, uint32_t id, uint64_t t0, uint64_t t1,
+               bool use_v2, const double *pcts, int npcts, tsdb_stats_t *out);
+
+#endif // TSDB_H
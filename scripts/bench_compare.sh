@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Compares two bench_monitor result files (make bench writes data/reports/bench-<rev>.tsv).
+# Usage: scripts/bench_compare.sh OLD.tsv NEW.tsv [THRESHOLD_PCT]
+# Prints every figure with its change; marks changes beyond the threshold (default 10%)
+# in the bad direction (ns/us up, rates down) and exits 1 if there are any.
+
+OLD=${1:?usage: $0 OLD.tsv NEW.tsv [THRESHOLD_PCT]}
+NEW=${2:?usage: $0 OLD.tsv NEW.tsv [THRESHOLD_PCT]}
+TH=${3:-10}
+
+awk -F'\t' -v th="$TH" '
+    NR == FNR { old[$1 "\t" $2] = $3; next }
+    {
+        key = $1 "\t" $2
+        if (!(key in old)) { printf "%-8s %-16s %14s %14.3f %-9s   (new)\n", $1, $2, "-", $3, $4; next }
+        o = old[key]; d = o != 0 ? 100 * ($3 - o) / o : 0
+        worse = ($4 ~ /\/s$/) ? -d : d
+        flag = worse > th ? "  REGRESSION" : ""
+        if (flag != "") bad++
+        printf "%-8s %-16s %14.3f %14.3f %-9s %+7.1f%%%s\n", $1, $2, o, $3, $4, d, flag
+    }
+    END { exit bad > 0 }
+' "$OLD" "$NEW"
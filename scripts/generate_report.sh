@@ -3,11 +3,35 @@ set -euo pipefail
 ROOT="$(cd "$(dirname "$0")/.." && pwd)"
 REPORT_DIR="$ROOT/data/reports"
 LOG_DIR="$ROOT/data/logs"
+TSDB_DIR="$ROOT/data/tsdb"
+TSQ="$ROOT/bin/tsq"
+IPC="$ROOT/bin/ipc_consumer"
 OUT="$REPORT_DIR/full_report_$(date +%Y%m%d_%H%M%S).txt"
+# The monitor's shared-memory name: $1, else shm-name from data/monitor.conf.
+SHM_NAME=${1:-$(sed -n 's/^[[:space:]]*shm-name[[:space:]]*=[[:space:]]*//p' "$ROOT/data/monitor.conf" 2>/dev/null | tail -n 1)}
+SHM_NAME=${SHM_NAME:-/sysmon_metrics}
 mkdir -p "$REPORT_DIR"
 {
   echo "=== System Resource Monitor Summary ==="
-  tail -n 50 "$LOG_DIR/resource_log.txt" 2>/dev/null || echo "No resource logs yet."
+  # A running monitor serves rolling 1s/10s/1m/5m aggregates from shared memory.
+  if [[ -x "$IPC" && -e "/dev/shm/${SHM_NAME#/}" ]]; then
+    echo "-- Live aggregates --"
+    "$IPC" --aggregates --shm-name "$SHM_NAME" || true
+  fi
+  if [[ -x "$TSQ" && -d "$TSDB_DIR" ]]; then
+    echo "-- Last hour (segment store) --"
+    for kind in CPU MEM; do
+      "$TSQ" -d "$TSDB_DIR" "$kind" --from -1h -p 50,95,99
+    done
+    echo "-- Recent alerts --"
+    "$TSQ" -d "$TSDB_DIR" ALERT --from -1h --raw | tail -n 20
+  fi
+  if [[ -f "$LOG_DIR/resource_log.txt" ]]; then
+    echo "-- Text log (last 50 lines) --"
+    tail -n 50 "$LOG_DIR/resource_log.txt"
+  elif [[ ! -d "$TSDB_DIR" ]]; then
+    echo "No resource logs yet."
+  fi
   echo
   echo "=== Scheduler Latest Report ==="
   tail -n 50 "$REPORT_DIR/scheduler_report.txt" 2>/dev/null || echo "No scheduler report yet."
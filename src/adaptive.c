@@ -0,0 +1,44 @@
+#include "adaptive.h"
+
+#include <math.h>
+
+void adapt_init(adapt_t *a, unsigned int floor_ms, unsigned int base_ms, unsigned int ceil_ms,
+                double threshold, double near, double min_step) {
+    if (floor_ms == 0) floor_ms = 1;
+    if (base_ms < floor_ms) base_ms = floor_ms;
+    if (ceil_ms < base_ms) ceil_ms = base_ms;
+    *a = (adapt_t){ .floor_ms = floor_ms, .base_ms = base_ms, .ceil_ms = ceil_ms,
+                    .threshold = threshold, .near = near, .min_step = min_step };
+}
+
+unsigned int adapt_next(adapt_t *a, unsigned int cur_ms, double level) {
+    if (!a->primed) {
+        a->mean = a->last = level;
+        a->var = 0;
+        a->primed = true;
+        return a->base_ms;
+    }
+    double step = fabs(level - a->last);
+    double noise = fmax(ADAPT_SIGMAS * sqrt(a->var), fmax(ADAPT_REL_STEP * fabs(a->mean), a->min_step));
+    bool spike = step > noise;
+    bool near = !isnan(a->threshold) && level >= a->threshold - a->near;
+    double dev = level - a->mean;
+    a->mean += ADAPT_ALPHA * dev;
+    a->var = (1.0 - ADAPT_ALPHA) * (a->var + ADAPT_ALPHA * dev * dev);
+    a->last = level;
+
+    unsigned int next = cur_ms;
+    if (spike) {
+        next = a->floor_ms;
+        a->calm = 0;
+    } else if (near) {
+        next = cur_ms / 2;
+        a->calm = 0;
+    } else if (++a->calm >= ADAPT_CALM_TICKS) {
+        next = cur_ms > a->ceil_ms / 2 ? a->ceil_ms : cur_ms * 2;
+        a->calm = 0;
+    }
+    if (next < a->floor_ms) next = a->floor_ms;
+    if (next > a->ceil_ms) next = a->ceil_ms;
+    return next;
+}
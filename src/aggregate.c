@@ -0,0 +1,220 @@
+#include "aggregate.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ---- DDSketch ----
+
+#define DD_GAMMA ((1.0 + DD_ALPHA) / (1.0 - DD_ALPHA))
+
+static int32_t dd_key(double x) {
+    return (int32_t)ceil(log(x) / log(DD_GAMMA));
+}
+
+static double dd_value(int32_t k) {
+    return 2.0 * pow(DD_GAMMA, k) / (DD_GAMMA + 1.0);
+}
+
+void dd_init(dd_sketch_t *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+static void dd_add_key(dd_sketch_t *s, int32_t k, uint32_t cnt) {
+    if (s->count == s->zero) {
+        s->base = k - DD_BINS / 2;
+    } else if (k >= s->base + DD_BINS) {
+        // Slide up, folding the lowest bins into the new lowest one.
+        int32_t sh = k - (s->base + DD_BINS - 1);
+        if (sh >= DD_BINS) {
+            uint32_t total = 0;
+            for (int i = 0; i < DD_BINS; i++) total += s->bins[i];
+            memset(s->bins, 0, sizeof(s->bins));
+            s->bins[0] = total;
+        } else {
+            for (int i = 0; i < sh; i++) s->bins[sh] += s->bins[i];
+            memmove(s->bins, s->bins + sh, (size_t)(DD_BINS - sh) * sizeof(s->bins[0]));
+            memset(s->bins + DD_BINS - sh, 0, (size_t)sh * sizeof(s->bins[0]));
+        }
+        s->base += sh;
+    } else if (k < s->base) {
+        // Slide down as far as the highest occupied bin allows; anything lower collapses.
+        int hi = DD_BINS - 1;
+        while (hi > 0 && s->bins[hi] == 0) hi--;
+        int32_t sh = s->base - k;
+        if (sh > DD_BINS - 1 - hi) sh = DD_BINS - 1 - hi;
+        if (sh > 0) {
+            memmove(s->bins + sh, s->bins, (size_t)(DD_BINS - sh) * sizeof(s->bins[0]));
+            memset(s->bins, 0, (size_t)sh * sizeof(s->bins[0]));
+            s->base -= sh;
+        }
+        if (k < s->base) k = s->base;
+    }
+    s->bins[k - s->base] += cnt;
+    s->count += cnt;
+}
+
+void dd_add_n(dd_sketch_t *s, double x, uint32_t n) {
+    if (!(x > DD_MIN_VALUE)) { s->zero += n; s->count += n; return; }
+    dd_add_key(s, dd_key(x), n);
+}
+
+void dd_add(dd_sketch_t *s, double x) {
+    dd_add_n(s, x, 1);
+}
+
+void dd_merge(dd_sketch_t *dst, const dd_sketch_t *src) {
+    dst->zero += src->zero;
+    dst->count += src->zero;
+    for (int i = DD_BINS - 1; i >= 0; i--)
+        if (src->bins[i]) dd_add_key(dst, src->base + i, src->bins[i]);
+}
+
+double dd_quantile(const dd_sketch_t *s, double q) {
+    if (s->count == 0) return 0.0;
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+    double rank = q * (double)(s->count - 1);
+    uint64_t cum = s->zero;
+    if (rank < (double)cum) return 0.0;
+    for (int i = 0; i < DD_BINS; i++) {
+        cum += s->bins[i];
+        if ((double)cum > rank) return dd_value(s->base + i);
+    }
+    return dd_value(s->base + DD_BINS - 1);
+}
+
+// ---- Windows ----
+
+static const unsigned int window_ms[AGG_WINDOWS] = { 1000, 10000, 60000, 300000 };
+static const char *const window_name[AGG_WINDOWS] = { "1s", "10s", "1m", "5m" };
+
+typedef struct {
+    uint64_t epoch; // bucket number + 1, 0 = never used
+    uint64_t count;
+    double sum, min, max; // sum is weighted: sum of x * w
+    uint64_t weight;      // sum of w
+    dd_sketch_t sk;
+} bucket_t;
+
+typedef struct {
+    bucket_t ring[AGG_WINDOWS][AGG_BUCKETS];
+    double ewma, last;
+    uint64_t last_ts;
+    bool seen;
+} kind_agg_t;
+
+struct agg {
+    kind_agg_t k[METRIC_KIND_COUNT];
+};
+
+unsigned int agg_window_ms(agg_window_t w) {
+    return (unsigned)w < AGG_WINDOWS ? window_ms[w] : 0;
+}
+
+const char *agg_window_name(agg_window_t w) {
+    return (unsigned)w < AGG_WINDOWS ? window_name[w] : "?";
+}
+
+int agg_window_from_seconds(unsigned int s) {
+    for (int w = 0; w < AGG_WINDOWS; w++)
+        if (window_ms[w] == s * 1000u) return w;
+    return -1;
+}
+
+agg_t *agg_create(void) {
+    return calloc(1, sizeof(agg_t));
+}
+
+void agg_destroy(agg_t *g) {
+    free(g);
+}
+
+void agg_add(agg_t *g, const metric_t *m) {
+    if ((unsigned)m->kind >= METRIC_KIND_COUNT || m->kind == METRIC_ALERT) return;
+    kind_agg_t *k = &g->k[m->kind];
+    double x = m->v1;
+    uint32_t w = m->interval_ms ? (m->interval_ms + AGG_WEIGHT_MS / 2) / AGG_WEIGHT_MS : 1;
+    if (w == 0) w = 1;
+    for (int win = 0; win < AGG_WINDOWS; win++) {
+        uint64_t epoch = m->ts_ms / (window_ms[win] / AGG_BUCKETS) + 1;
+        bucket_t *b = &k->ring[win][epoch % AGG_BUCKETS];
+        if (b->epoch > epoch) continue; // older than anything this slot can still hold
+        if (b->epoch != epoch) {
+            b->epoch = epoch;
+            b->count = 0; b->sum = 0; b->weight = 0;
+            dd_init(&b->sk);
+        }
+        if (b->count == 0 || x < b->min) b->min = x;
+        if (b->count == 0 || x > b->max) b->max = x;
+        b->count++;
+        b->sum += x * w;
+        b->weight += w;
+        dd_add_n(&b->sk, x, w);
+    }
+    // Time-based EWMA, so irregular sample spacing does not skew the weights.
+    if (!k->seen) {
+        k->ewma = x;
+        k->seen = true;
+    } else if (m->ts_ms > k->last_ts) {
+        double a = 1.0 - exp(-(double)(m->ts_ms - k->last_ts) / AGG_EWMA_TAU_MS);
+        k->ewma += a * (x - k->ewma);
+    }
+    if (m->ts_ms >= k->last_ts) { k->last_ts = m->ts_ms; k->last = x; }
+}
+
+bool agg_window(const agg_t *g, metric_kind_t kind, agg_window_t w, uint64_t now_ms,
+                bool with_quantiles, agg_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if ((unsigned)kind >= METRIC_KIND_COUNT || (unsigned)w >= AGG_WINDOWS) return false;
+    const kind_agg_t *k = &g->k[kind];
+    uint64_t cur = now_ms / (window_ms[w] / AGG_BUCKETS) + 1;
+    dd_sketch_t sk;
+    if (with_quantiles) dd_init(&sk);
+    double sum = 0;
+    uint64_t weight = 0;
+    for (int i = 0; i < AGG_BUCKETS; i++) {
+        const bucket_t *b = &k->ring[w][i];
+        if (b->count == 0 || b->epoch > cur || b->epoch + AGG_BUCKETS <= cur) continue;
+        if (out->count == 0 || b->min < out->min) out->min = b->min;
+        if (out->count == 0 || b->max > out->max) out->max = b->max;
+        out->count += b->count;
+        sum += b->sum;
+        weight += b->weight;
+        if (with_quantiles) dd_merge(&sk, &b->sk);
+    }
+    if (out->count == 0) return false;
+    out->mean = sum / (double)weight;
+    if (with_quantiles) {
+        // Sketch values are bin midpoints; keep them inside the observed range.
+        double q[3] = { dd_quantile(&sk, 0.50), dd_quantile(&sk, 0.95), dd_quantile(&sk, 0.99) };
+        for (int i = 0; i < 3; i++) q[i] = q[i] < out->min ? out->min : q[i] > out->max ? out->max : q[i];
+        out->p50 = q[0]; out->p95 = q[1]; out->p99 = q[2];
+    }
+    return true;
+}
+
+bool agg_summary(const agg_t *g, metric_kind_t kind, uint64_t now_ms, agg_summary_t *out) {
+    memset(out, 0, sizeof(*out));
+    if ((unsigned)kind >= METRIC_KIND_COUNT || !g->k[kind].seen) return false;
+    const kind_agg_t *k = &g->k[kind];
+    out->ts_ms = k->last_ts;
+    out->last = k->last;
+    out->ewma = k->ewma;
+    for (int w = 0; w < AGG_WINDOWS; w++) agg_window(g, kind, (agg_window_t)w, now_ms, true, &out->win[w]);
+    return true;
+}
+
+// ---- Alerts ----
+
+bool agg_alert_eval(agg_alert_t *a, const agg_t *g, uint64_t now_ms, metric_t *out) {
+    agg_stats_t st;
+    if (!agg_window(g, a->kind, a->window, now_ms, false, &st)) return false;
+    bool raise = !a->active && st.mean >= a->threshold;
+    bool clear = a->active && st.mean < a->threshold - a->hysteresis;
+    if (!raise && !clear) return false;
+    a->active = raise;
+    *out = (metric_t){ .kind = METRIC_ALERT, .id = (uint32_t)a->kind, .v1 = st.mean, .v2 = raise ? 0.0 : 1.0,
+                       .ts_ms = now_ms };
+    return true;
+}
@@ -0,0 +1,348 @@
+#define _GNU_SOURCE
+#include "binlog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Worst case per sample: ts 4+64, id 2+32, two values 2+5+6+64 each, interval 1+32
+// = 289 bits.
+#define SAMPLE_MAX_BYTES 37
+
+typedef struct {
+    uint8_t bits[BINLOG_BLOCK_SIZE];
+    size_t nbits;
+    uint32_t count;
+    uint64_t prev_ts;
+    int64_t prev_delta;
+    uint32_t prev_id;
+    uint32_t prev_interval;
+    uint64_t prev_v[2];
+    int lead[2], trail[2]; // current XOR window; lead < 0 means none yet
+} col_enc_t;
+
+struct binlog {
+    int fd;
+    off_t block_off;      // file offset of the block being filled
+    uint8_t *block;       // BINLOG_BLOCK_SIZE, page aligned for O_DIRECT
+    col_enc_t cols[METRIC_KIND_COUNT];
+    uint32_t count;
+    uint64_t min_ts, max_ts;
+    size_t used;          // bytes the block would take if sealed now
+    unsigned int flush_ms;
+    uint64_t last_flush;
+    bool dirty;
+};
+
+// ---- Bit I/O (MSB first) ----
+
+static void put_bits(col_enc_t *c, uint64_t v, int n) {
+    while (n > 0) {
+        size_t byte = c->nbits >> 3;
+        int room = 8 - (int)(c->nbits & 7);
+        int take = n < room ? n : room;
+        uint8_t chunk = (uint8_t)((v >> (n - take)) & ((1u << take) - 1));
+        c->bits[byte] |= (uint8_t)(chunk << (room - take));
+        c->nbits += (size_t)take;
+        n -= take;
+    }
+}
+
+typedef struct { const uint8_t *p; size_t pos, end; } bit_reader_t;
+
+static bool get_bits(bit_reader_t *r, int n, uint64_t *out) {
+    if (r->pos + (size_t)n > r->end) return false;
+    uint64_t v = 0;
+    while (n > 0) {
+        int avail = 8 - (int)(r->pos & 7);
+        int take = n < avail ? n : avail;
+        uint8_t byte = r->p[r->pos >> 3];
+        uint8_t chunk = (uint8_t)((byte >> (avail - take)) & ((1u << take) - 1));
+        v = (v << take) | chunk;
+        r->pos += (size_t)take;
+        n -= take;
+    }
+    *out = v;
+    return true;
+}
+
+static uint64_t dbits(double d) { uint64_t u; memcpy(&u, &d, sizeof(u)); return u; }
+static double bitsd(uint64_t u) { double d; memcpy(&d, &u, sizeof(d)); return d; }
+
+// ---- Column encoding ----
+
+static void col_reset(col_enc_t *c) {
+    memset(c->bits, 0, (c->nbits + 7) / 8);
+    c->nbits = 0; c->count = 0;
+    c->prev_ts = 0; c->prev_delta = 0; c->prev_id = UINT32_MAX; c->prev_interval = 0;
+    c->prev_v[0] = c->prev_v[1] = 0;
+    c->lead[0] = c->lead[1] = -1;
+    c->trail[0] = c->trail[1] = 0;
+}
+
+static void put_ts(col_enc_t *c, uint64_t ts) {
+    if (c->count == 0) { put_bits(c, ts, 64); c->prev_ts = ts; return; }
+    int64_t delta = (int64_t)(ts - c->prev_ts);
+    int64_t dod = delta - c->prev_delta;
+    if (dod == 0) put_bits(c, 0, 1);
+    else if (dod >= -63 && dod <= 64) { put_bits(c, 0x2, 2); put_bits(c, (uint64_t)(dod + 63), 7); }
+    else if (dod >= -255 && dod <= 256) { put_bits(c, 0x6, 3); put_bits(c, (uint64_t)(dod + 255), 9); }
+    else if (dod >= -2047 && dod <= 2048) { put_bits(c, 0xE, 4); put_bits(c, (uint64_t)(dod + 2047), 12); }
+    else { put_bits(c, 0xF, 4); put_bits(c, (uint64_t)dod, 64); }
+    c->prev_delta = delta;
+    c->prev_ts = ts;
+}
+
+static void put_id(col_enc_t *c, uint32_t id) {
+    if (id == c->prev_id) put_bits(c, 0, 1);
+    else if (id == c->prev_id + 1) put_bits(c, 0x2, 2);
+    else { put_bits(c, 0x3, 2); put_bits(c, id, 32); }
+    c->prev_id = id;
+}
+
+static void put_interval(col_enc_t *c, uint32_t ms) {
+    if (ms == c->prev_interval) { put_bits(c, 0, 1); return; }
+    put_bits(c, 1, 1);
+    put_bits(c, ms, 32);
+    c->prev_interval = ms;
+}
+
+static void put_value(col_enc_t *c, int slot, double d) {
+    uint64_t v = dbits(d);
+    uint64_t x = v ^ c->prev_v[slot];
+    c->prev_v[slot] = v;
+    if (x == 0) { put_bits(c, 0, 1); return; }
+    int lead = __builtin_clzll(x), trail = __builtin_ctzll(x);
+    if (lead > 31) lead = 31;
+    if (c->lead[slot] >= 0 && lead >= c->lead[slot] && trail >= c->trail[slot]) {
+        int len = 64 - c->lead[slot] - c->trail[slot];
+        put_bits(c, 0x2, 2);
+        put_bits(c, x >> c->trail[slot], len);
+        return;
+    }
+    int len = 64 - lead - trail;
+    put_bits(c, 0x3, 2);
+    put_bits(c, (uint64_t)lead, 5);
+    put_bits(c, (uint64_t)(len - 1), 6);
+    put_bits(c, x >> trail, len);
+    c->lead[slot] = lead; c->trail[slot] = trail;
+}
+
+// ---- Block assembly ----
+
+static size_t header_bytes(const binlog_t *bl) {
+    size_t ncols = 0;
+    for (int k = 0; k < METRIC_KIND_COUNT; k++) ncols += bl->cols[k].count > 0;
+    return sizeof(binlog_block_hdr_t) + ncols * sizeof(binlog_col_t);
+}
+
+static void assemble(binlog_t *bl) {
+    memset(bl->block, 0, BINLOG_BLOCK_SIZE);
+    binlog_block_hdr_t *h = (binlog_block_hdr_t *)bl->block;
+    binlog_col_t *dir = (binlog_col_t *)(bl->block + sizeof(*h));
+    size_t off = header_bytes(bl);
+    uint16_t ncols = 0;
+    for (int k = 0; k < METRIC_KIND_COUNT; k++) {
+        col_enc_t *c = &bl->cols[k];
+        if (c->count == 0) continue;
+        size_t bytes = (c->nbits + 7) / 8;
+        dir[ncols] = (binlog_col_t){ .kind = (uint16_t)k, .count = c->count,
+                                     .offset = (uint32_t)off, .nbits = (uint32_t)c->nbits };
+        memcpy(bl->block + off, c->bits, bytes);
+        off += bytes;
+        ncols++;
+    }
+    *h = (binlog_block_hdr_t){ .magic = BINLOG_MAGIC, .version = BINLOG_VERSION, .ncols = ncols,
+                               .count = bl->count, .min_ts = bl->min_ts, .max_ts = bl->max_ts };
+}
+
+static int write_block(binlog_t *bl) {
+    assemble(bl);
+    size_t done = 0;
+    while (done < BINLOG_BLOCK_SIZE) {
+        ssize_t n = pwrite(bl->fd, bl->block + done, BINLOG_BLOCK_SIZE - done, bl->block_off + (off_t)done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static void reset_block(binlog_t *bl) {
+    for (int k = 0; k < METRIC_KIND_COUNT; k++) col_reset(&bl->cols[k]);
+    bl->count = 0; bl->min_ts = UINT64_MAX; bl->max_ts = 0;
+    bl->used = sizeof(binlog_block_hdr_t);
+    bl->dirty = false;
+}
+
+binlog_t *binlog_open(const char *path, unsigned int flush_ms, bool direct) {
+    binlog_t *bl = calloc(1, sizeof(*bl));
+    if (!bl) return NULL;
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+    bl->fd = -1;
+    if (direct) bl->fd = open(path, flags | O_DIRECT, 0644);
+    if (bl->fd < 0) bl->fd = open(path, flags, 0644);
+    if (bl->fd < 0 || posix_memalign((void **)&bl->block, BINLOG_BLOCK_SIZE, BINLOG_BLOCK_SIZE) != 0) {
+        if (bl->fd >= 0) close(bl->fd);
+        free(bl);
+        return NULL;
+    }
+    // Append after the last whole block; a torn tail block (a write cut short) is
+    // overwritten, since blocks carry no checksum to tell its zeroed tail from samples.
+    struct stat st;
+    off_t size = (fstat(bl->fd, &st) == 0) ? st.st_size : 0;
+    bl->block_off = size / BINLOG_BLOCK_SIZE * BINLOG_BLOCK_SIZE;
+    bl->flush_ms = flush_ms;
+    for (int k = 0; k < METRIC_KIND_COUNT; k++) bl->cols[k].nbits = 0;
+    reset_block(bl);
+    return bl;
+}
+
+int binlog_append(binlog_t *bl, const metric_t *m) {
+    if ((unsigned)m->kind >= METRIC_KIND_COUNT) return -1;
+    col_enc_t *c = &bl->cols[m->kind];
+    size_t need = SAMPLE_MAX_BYTES + (c->count == 0 ? sizeof(binlog_col_t) : 0);
+    if (bl->used + need > BINLOG_BLOCK_SIZE) {
+        if (write_block(bl) != 0) return -1;
+        bl->block_off += BINLOG_BLOCK_SIZE;
+        reset_block(bl);
+    }
+    size_t before = (c->nbits + 7) / 8;
+    if (c->count == 0) bl->used += sizeof(binlog_col_t);
+    put_ts(c, m->ts_ms);
+    put_id(c, m->id);
+    put_value(c, 0, m->v1);
+    put_value(c, 1, m->v2);
+    put_interval(c, m->interval_ms);
+    c->count++;
+    bl->used += (c->nbits + 7) / 8 - before;
+    bl->count++;
+    if (m->ts_ms < bl->min_ts) bl->min_ts = m->ts_ms;
+    if (m->ts_ms > bl->max_ts) bl->max_ts = m->ts_ms;
+    bl->dirty = true;
+    if (bl->flush_ms == 0) return binlog_flush(bl);
+    return 0;
+}
+
+int binlog_flush(binlog_t *bl) {
+    if (!bl->dirty) return 0;
+    if (write_block(bl) != 0) return -1;
+    bl->dirty = false;
+    return 0;
+}
+
+int binlog_tick(binlog_t *bl, uint64_t now_ms) {
+    if (now_ms - bl->last_flush < bl->flush_ms) return 0;
+    bl->last_flush = now_ms;
+    return binlog_flush(bl);
+}
+
+int binlog_close(binlog_t *bl) {
+    if (!bl) return 0;
+    int rc = binlog_flush(bl);
+    close(bl->fd);
+    free(bl->block);
+    free(bl);
+    return rc;
+}
+
+uint64_t binlog_size(const binlog_t *bl) {
+    return (uint64_t)bl->block_off + (bl->count ? BINLOG_BLOCK_SIZE : 0);
+}
+
+// ---- Decoding ----
+
+static bool get_value(bit_reader_t *r, uint64_t *prev, int *lead, int *trail, double *out) {
+    uint64_t b;
+    if (!get_bits(r, 1, &b)) return false;
+    if (b == 0) { *out = bitsd(*prev); return true; }
+    if (!get_bits(r, 1, &b)) return false;
+    uint64_t x;
+    if (b == 0) {
+        if (*lead < 0) return false;
+        if (!get_bits(r, 64 - *lead - *trail, &x)) return false;
+        x <<= *trail;
+    } else {
+        uint64_t l, len;
+        if (!get_bits(r, 5, &l) || !get_bits(r, 6, &len)) return false;
+        int n = (int)len + 1;
+        if ((int)l + n > 64) return false;
+        if (!get_bits(r, n, &x)) return false;
+        *lead = (int)l; *trail = 64 - (int)l - n;
+        x <<= *trail;
+    }
+    *prev ^= x;
+    *out = bitsd(*prev);
+    return true;
+}
+
+// Version 1 blocks carry no intervals; their samples decode with interval_ms 0.
+static int decode_column(const uint8_t *block, const binlog_col_t *col, int version, metric_t *out) {
+    if (col->offset >= BINLOG_BLOCK_SIZE || col->offset + (col->nbits + 7) / 8 > BINLOG_BLOCK_SIZE) return -1;
+    bit_reader_t r = { .p = block + col->offset, .pos = 0, .end = col->nbits };
+    uint64_t ts = 0, v[2] = {0, 0}, b;
+    int64_t delta = 0;
+    uint32_t id = UINT32_MAX, interval = 0;
+    int lead[2] = {-1, -1}, trail[2] = {0, 0};
+    for (uint32_t i = 0; i < col->count; i++) {
+        if (i == 0) {
+            if (!get_bits(&r, 64, &ts)) return -1;
+        } else {
+            int ones = 0;
+            while (ones < 4) {
+                if (!get_bits(&r, 1, &b)) return -1;
+                if (b == 0) break;
+                ones++;
+            }
+            int64_t dod = 0;
+            uint64_t raw;
+            switch (ones) {
+                case 0: dod = 0; break;
+                case 1: if (!get_bits(&r, 7, &raw)) return -1; dod = (int64_t)raw - 63; break;
+                case 2: if (!get_bits(&r, 9, &raw)) return -1; dod = (int64_t)raw - 255; break;
+                case 3: if (!get_bits(&r, 12, &raw)) return -1; dod = (int64_t)raw - 2047; break;
+                default: if (!get_bits(&r, 64, &raw)) return -1; dod = (int64_t)raw; break;
+            }
+            delta += dod;
+            ts += (uint64_t)delta;
+        }
+        if (!get_bits(&r, 1, &b)) return -1;
+        if (b) {
+            if (!get_bits(&r, 1, &b)) return -1;
+            if (b == 0) id = id + 1;
+            else { uint64_t raw; if (!get_bits(&r, 32, &raw)) return -1; id = (uint32_t)raw; }
+        }
+        metric_t *m = &out[i];
+        m->kind = (metric_kind_t)col->kind;
+        m->id = id;
+        m->ts_ms = ts;
+        if (!get_value(&r, &v[0], &lead[0], &trail[0], &m->v1)) return -1;
+        if (!get_value(&r, &v[1], &lead[1], &trail[1], &m->v2)) return -1;
+        if (version >= 2) {
+            if (!get_bits(&r, 1, &b)) return -1;
+            if (b) { uint64_t raw; if (!get_bits(&r, 32, &raw)) return -1; interval = (uint32_t)raw; }
+        }
+        m->interval_ms = interval;
+    }
+    return (int)col->count;
+}
+
+int binlog_decode_block(const uint8_t *block, metric_t *out, size_t cap) {
+    const binlog_block_hdr_t *h = (const binlog_block_hdr_t *)block;
+    if (h->magic != BINLOG_MAGIC || h->version < 1 || h->version > BINLOG_VERSION) return -1;
+    if (h->count > cap || sizeof(*h) + (size_t)h->ncols * sizeof(binlog_col_t) > BINLOG_BLOCK_SIZE) return -1;
+    const binlog_col_t *dir = (const binlog_col_t *)(block + sizeof(*h));
+    size_t n = 0;
+    for (uint16_t i = 0; i < h->ncols; i++) {
+        if (dir[i].kind >= METRIC_KIND_COUNT || n + dir[i].count > cap) return -1;
+        int got = decode_column(block, &dir[i], h->version, out + n);
+        if (got < 0) return -1;
+        n += (size_t)got;
+    }
+    return (int)n;
+}
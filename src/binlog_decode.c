@@ -0,0 +1,81 @@
+#include "aggregate.h"
+#include "binlog.h"
+#include "metric_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Converts binary monitor logs back to the resource_log.txt CSV text.
+// ALERT lines are not stored in the binary log; pass the monitor's thresholds (and
+// alert window/hysteresis, if not the defaults) to regenerate them from the aggregates.
+
+typedef struct { metric_t m; int seq; } row_t;
+
+static int cmp_row(const void *a, const void *b) {
+    const row_t *x = a, *y = b;
+    if (x->m.ts_ms != y->m.ts_ms) return x->m.ts_ms < y->m.ts_ms ? -1 : 1;
+    return x->seq - y->seq;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--cpu-alert PCT] [--mem-alert PCT] [--alert-window 1|10|60|300]\n"
+                    "       [--alert-hysteresis PCT] file.bin...\n", prog);
+}
+
+int main(int argc, char **argv) {
+    agg_alert_t alerts[2] = {
+        { .kind = METRIC_CPU, .threshold = -1, .hysteresis = 5.0, .window = AGG_10S },
+        { .kind = METRIC_MEM, .threshold = -1, .hysteresis = 5.0, .window = AGG_10S },
+    };
+    int first = 1;
+    for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++) {
+        if (strcmp(argv[first], "--cpu-alert") == 0 && first + 1 < argc) alerts[0].threshold = atof(argv[++first]);
+        else if (strcmp(argv[first], "--mem-alert") == 0 && first + 1 < argc) alerts[1].threshold = atof(argv[++first]);
+        else if (strcmp(argv[first], "--alert-hysteresis") == 0 && first + 1 < argc) {
+            alerts[0].hysteresis = alerts[1].hysteresis = atof(argv[++first]);
+        } else if (strcmp(argv[first], "--alert-window") == 0 && first + 1 < argc) {
+            int w = agg_window_from_seconds((unsigned)atoi(argv[++first]));
+            if (w < 0) { usage(argv[0]); return 2; }
+            alerts[0].window = alerts[1].window = (agg_window_t)w;
+        } else { usage(argv[0]); return 2; }
+    }
+    if (first >= argc) { usage(argv[0]); return 2; }
+    agg_t *agg = agg_create();
+    if (!agg) { perror("agg_create"); return 1; }
+
+    static uint8_t block[BINLOG_BLOCK_SIZE];
+    static metric_t ms[BINLOG_MAX_PER_BLOCK];
+    static row_t rows[BINLOG_MAX_PER_BLOCK];
+    char line[METRIC_LINE_MAX];
+    int status = 0;
+    for (int f = first; f < argc; f++) {
+        FILE *in = fopen(argv[f], "rb");
+        if (!in) { perror(argv[f]); status = 1; continue; }
+        long bad = 0;
+        while (fread(block, 1, sizeof(block), in) == sizeof(block)) {
+            int n = binlog_decode_block(block, ms, BINLOG_MAX_PER_BLOCK);
+            if (n < 0) { bad++; continue; }
+            // Columns are stored kind by kind; restore time order within the block.
+            for (int i = 0; i < n; i++) { rows[i].m = ms[i]; rows[i].seq = i; }
+            qsort(rows, (size_t)n, sizeof(row_t), cmp_row);
+            for (int i = 0; i < n; i++) {
+                const metric_t *m = &rows[i].m;
+                int len = metric_format_csv(line, sizeof(line), m);
+                if (len > 0) fwrite(line, 1, (size_t)len, stdout);
+                agg_add(agg, m);
+                for (int a = 0; a < 2; a++) {
+                    metric_t alert;
+                    if (alerts[a].threshold < 0 || alerts[a].kind != m->kind ||
+                        !agg_alert_eval(&alerts[a], agg, m->ts_ms, &alert)) continue;
+                    len = metric_format_csv(line, sizeof(line), &alert);
+                    if (len > 0) fwrite(line, 1, (size_t)len, stdout);
+                }
+            }
+        }
+        if (bad) fprintf(stderr, "%s: skipped %ld unreadable block(s)\n", argv[f], bad);
+        fclose(in);
+    }
+    agg_destroy(agg);
+    return status;
+}
@@ -0,0 +1,372 @@
+#define _GNU_SOURCE
+#include "cgroup_stats.h"
+#include "proc_reader.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM | IN_MODIFY | IN_DELETE_SELF | IN_ONLYDIR)
+
+typedef struct {
+    uint32_t id;
+    int wd;          // inotify watch on the directory, -1 for a free slot
+    char *path;      // relative to the root, "" for the root itself
+    int active;      // position in tree->active, -1 while empty
+    bool draining;   // emptied: sampled once more, then closed
+    bool have_prev, moved;
+    proc_file_t cpu, mem, io;
+    uint64_t prev_ns, usage_us, throttled_us, rbytes, wbytes, mem_bytes;
+} cg_t;
+
+struct cgroup_tree {
+    char *root;
+    int ifd;
+    unsigned int max, count;
+    bool warned;
+    cg_t *cg;
+    int ncg, capcg;
+    int *free_slots, nfree;
+    int *active, nactive;
+    int *wd_key, *wd_val; // wd -> slot, open addressing
+    uint32_t wd_mask, wd_count;
+};
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// ---- wd -> slot ----
+
+static uint32_t wd_hash(int wd) {
+    return (uint32_t)wd * 2654435761u;
+}
+
+static int wd_find(const cgroup_tree_t *t, int wd) {
+    for (uint32_t h = wd_hash(wd) & t->wd_mask; t->wd_key[h] != -1; h = (h + 1) & t->wd_mask)
+        if (t->wd_key[h] == wd) return t->wd_val[h];
+    return -1;
+}
+
+static int wd_resize(cgroup_tree_t *t, uint32_t size) {
+    int *key = malloc(size * sizeof(int)), *val = malloc(size * sizeof(int));
+    if (!key || !val) { free(key); free(val); return -1; }
+    memset(key, 0xff, size * sizeof(int));
+    for (uint32_t i = 0; t->wd_key && i <= t->wd_mask; i++) {
+        if (t->wd_key[i] == -1) continue;
+        uint32_t h = wd_hash(t->wd_key[i]) & (size - 1);
+        while (key[h] != -1) h = (h + 1) & (size - 1);
+        key[h] = t->wd_key[i]; val[h] = t->wd_val[i];
+    }
+    free(t->wd_key); free(t->wd_val);
+    t->wd_key = key; t->wd_val = val; t->wd_mask = size - 1;
+    return 0;
+}
+
+static int wd_put(cgroup_tree_t *t, int wd, int slot) {
+    if (2 * (t->wd_count + 1) > t->wd_mask + 1 && wd_resize(t, 2 * (t->wd_mask + 1)) != 0) return -1;
+    uint32_t h = wd_hash(wd) & t->wd_mask;
+    while (t->wd_key[h] != -1) h = (h + 1) & t->wd_mask;
+    t->wd_key[h] = wd; t->wd_val[h] = slot;
+    t->wd_count++;
+    return 0;
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones.
+static void wd_del(cgroup_tree_t *t, int wd) {
+    uint32_t i = wd_hash(wd) & t->wd_mask;
+    while (t->wd_key[i] != wd) {
+        if (t->wd_key[i] == -1) return;
+        i = (i + 1) & t->wd_mask;
+    }
+    for (uint32_t j = i;;) {
+        j = (j + 1) & t->wd_mask;
+        if (t->wd_key[j] == -1) break;
+        uint32_t k = wd_hash(t->wd_key[j]) & t->wd_mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+        t->wd_key[i] = t->wd_key[j]; t->wd_val[i] = t->wd_val[j];
+        i = j;
+    }
+    t->wd_key[i] = -1;
+    t->wd_count--;
+}
+
+// ---- Cgroups ----
+
+static void full_path(const cgroup_tree_t *t, const cg_t *c, const char *file, char *buf, size_t cap) {
+    snprintf(buf, cap, "%s%s%s/%s", t->root, c->path[0] ? "/" : "", c->path, file);
+}
+
+static bool populated(const cgroup_tree_t *t, const cg_t *c) {
+    char path[PATH_MAX], buf[256];
+    full_path(t, c, "cgroup.events", path, sizeof(path));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return false;
+    buf[n] = '\0';
+    return strstr(buf, "populated 1") != NULL;
+}
+
+// Opens the stat files; only cpu.stat is required (memory.current and io.stat exist
+// only where the parent enables those controllers).
+static void activate(cgroup_tree_t *t, int s) {
+    cg_t *c = &t->cg[s];
+    char path[PATH_MAX];
+    full_path(t, c, "cpu.stat", path, sizeof(path));
+    if (pf_open(&c->cpu, path, 512) != 0) return;
+    full_path(t, c, "memory.current", path, sizeof(path));
+    pf_open(&c->mem, path, 64);
+    full_path(t, c, "io.stat", path, sizeof(path));
+    pf_open(&c->io, path, 512);
+    c->have_prev = c->draining = false;
+    c->moved = true; // report it once even if nothing moves
+    c->active = t->nactive;
+    t->active[t->nactive++] = s;
+}
+
+static void deactivate(cgroup_tree_t *t, int s) {
+    cg_t *c = &t->cg[s];
+    if (c->active < 0) return;
+    pf_close(&c->cpu); pf_close(&c->mem); pf_close(&c->io);
+    int last = t->active[--t->nactive];
+    t->active[c->active] = last;
+    t->cg[last].active = c->active;
+    c->active = -1;
+}
+
+static void cg_remove(cgroup_tree_t *t, int s, bool rm_watch) {
+    cg_t *c = &t->cg[s];
+    deactivate(t, s);
+    if (rm_watch) inotify_rm_watch(t->ifd, c->wd);
+    wd_del(t, c->wd);
+    free(c->path);
+    c->path = NULL;
+    c->wd = -1;
+    t->free_slots[t->nfree++] = s;
+    t->count--;
+}
+
+// Slot tracking the cgroup at `rel`, or -1. A linear scan, for removals only.
+static int find_path(const cgroup_tree_t *t, const char *rel) {
+    for (int s = 0; s < t->ncg; s++)
+        if (t->cg[s].wd >= 0 && strcmp(t->cg[s].path, rel) == 0) return s;
+    return -1;
+}
+
+static int new_slot(cgroup_tree_t *t) {
+    if (t->nfree > 0) return t->free_slots[--t->nfree];
+    if (t->ncg == t->capcg) {
+        int cap = t->capcg ? 2 * t->capcg : 64;
+        cg_t *cg = realloc(t->cg, (size_t)cap * sizeof(*cg));
+        if (!cg) return -1;
+        t->cg = cg;
+        int *fs = realloc(t->free_slots, (size_t)cap * sizeof(int));
+        if (!fs) return -1;
+        t->free_slots = fs;
+        int *act = realloc(t->active, (size_t)cap * sizeof(int));
+        if (!act) return -1;
+        t->active = act;
+        t->capcg = cap;
+    }
+    return t->ncg++;
+}
+
+// Watches `rel` and everything below it. The watch goes in before the directory is
+// read, so a child created meanwhile is either listed or reported, possibly both:
+// inotify returns the existing wd for a directory already watched.
+static void cg_add(cgroup_tree_t *t, const char *rel) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s%s%s", t->root, rel[0] ? "/" : "", rel);
+    if (t->count >= t->max) {
+        if (!t->warned) fprintf(stderr, "cgroup: more than %u cgroups, ignoring the rest\n", t->max);
+        t->warned = true;
+        return;
+    }
+    struct stat st;
+    int wd = inotify_add_watch(t->ifd, path, WATCH_MASK);
+    if (wd < 0) {
+        if (errno == ENOSPC && !t->warned) fprintf(stderr, "cgroup: out of inotify watches (fs.inotify.max_user_watches)\n");
+        t->warned |= errno == ENOSPC;
+        return;
+    }
+    if (wd_find(t, wd) >= 0) return;
+    int s = stat(path, &st) == 0 ? new_slot(t) : -1;
+    if (s < 0) { inotify_rm_watch(t->ifd, wd); return; }
+    cg_t *c = &t->cg[s];
+    memset(c, 0, sizeof(*c));
+    c->cpu.fd = c->mem.fd = c->io.fd = -1;
+    c->active = -1;
+    c->wd = wd;
+    c->id = (uint32_t)st.st_ino;
+    if (!(c->path = strdup(rel)) || wd_put(t, wd, s) != 0) {
+        free(c->path);
+        c->wd = -1;
+        t->free_slots[t->nfree++] = s;
+        inotify_rm_watch(t->ifd, wd);
+        return;
+    }
+    t->count++;
+    if (rel[0] && populated(t, c)) activate(t, s); // the root is the whole host
+
+    DIR *d = opendir(path);
+    if (!d) return;
+    for (struct dirent *e; (e = readdir(d));) {
+        if (e->d_type != DT_DIR || e->d_name[0] == '.') continue;
+        char child[PATH_MAX];
+        if (snprintf(child, sizeof(child), "%s%s%s", rel, rel[0] ? "/" : "", e->d_name) < (int)sizeof(child)) cg_add(t, child);
+    }
+    closedir(d);
+}
+
+static void rescan(cgroup_tree_t *t) {
+    for (int s = 0; s < t->ncg; s++)
+        if (t->cg[s].wd >= 0) cg_remove(t, s, true);
+    cg_add(t, "");
+}
+
+static void apply_events(cgroup_tree_t *t) {
+    _Alignas(struct inotify_event) char buf[16384];
+    bool again = false;
+    for (;;) {
+        ssize_t n = read(t->ifd, buf, sizeof(buf));
+        if (n <= 0) break;
+        for (char *p = buf; p < buf + n;) {
+            const struct inotify_event *e = (const struct inotify_event *)p;
+            p += sizeof(*e) + e->len;
+            if (e->mask & IN_Q_OVERFLOW) { again = true; continue; }
+            int s = wd_find(t, e->wd);
+            if (s < 0) continue;
+            // cgroupfs reports an rmdir only to the parent, as IN_DELETE; IN_IGNORED on
+            // the cgroup's own watch is the fallback where it comes.
+            if (e->mask & IN_IGNORED) { cg_remove(t, s, false); continue; }
+            bool dir = e->mask & IN_ISDIR;
+            char child[PATH_MAX];
+            const char *rel = t->cg[s].path;
+            bool named = dir && e->len &&
+                         snprintf(child, sizeof(child), "%s%s%s", rel, rel[0] ? "/" : "", e->name) < (int)sizeof(child);
+            if (dir && (e->mask & IN_MOVED_FROM)) again = true; // renamed: paths below are stale
+            else if (named && (e->mask & (IN_CREATE | IN_MOVED_TO))) cg_add(t, child);
+            else if (named && (e->mask & IN_DELETE)) {
+                int gone = find_path(t, child);
+                if (gone >= 0) cg_remove(t, gone, true);
+            } else if ((e->mask & IN_MODIFY) && e->len && strcmp(e->name, "cgroup.events") == 0 && t->cg[s].path[0]) {
+                cg_t *c = &t->cg[s];
+                bool pop = populated(t, c);
+                if (pop && c->active < 0) activate(t, s);
+                else if (pop) c->draining = false;
+                else if (c->active >= 0) c->draining = true;
+            }
+        }
+    }
+    if (again) rescan(t);
+}
+
+// ---- Sampling ----
+
+static uint64_t kv(const char *buf, const char *key) {
+    size_t n = strlen(key);
+    for (const char *p = buf; *p; p = pr_next_line(p)) {
+        if (strncmp(p, key, n) != 0 || p[n] != ' ') continue;
+        const char *q = p + n;
+        unsigned long long v = 0;
+        pr_next_u64(&q, &v);
+        return v;
+    }
+    return 0;
+}
+
+// "8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0", one line per device.
+static void io_bytes(const char *buf, uint64_t *r, uint64_t *w) {
+    uint64_t sr = 0, sw = 0;
+    for (const char *p = buf; *p; p = pr_next_line(p)) {
+        for (const char *q = pr_skip_token(p); *q && *q != '\n'; q = pr_skip_token(q)) {
+            q = pr_skip_blanks(q);
+            unsigned long long v;
+            const char *x = q;
+            if (pr_starts_with(q, "rbytes=")) { x += 7; if (pr_next_u64(&x, &v)) sr += v; }
+            else if (pr_starts_with(q, "wbytes=")) { x += 7; if (pr_next_u64(&x, &v)) sw += v; }
+        }
+    }
+    *r = sr; *w = sw;
+}
+
+static bool sample_one(cg_t *c, uint64_t now, cgroup_sample_t *out) {
+    if (pf_read(&c->cpu) < 0) return false;
+    uint64_t usage = kv(c->cpu.buf, "usage_usec"), thr = kv(c->cpu.buf, "throttled_usec");
+    uint64_t mem = 0, rb = 0, wb = 0;
+    if (c->mem.fd >= 0 && pf_read(&c->mem) >= 0) mem = strtoull(c->mem.buf, NULL, 10);
+    if (c->io.fd >= 0 && pf_read(&c->io) >= 0) io_bytes(c->io.buf, &rb, &wb);
+    bool emit = false;
+    if (c->have_prev && now > c->prev_ns) {
+        double us = (double)(now - c->prev_ns) / 1e3;
+        *out = (cgroup_sample_t){ .id = c->id, .path = c->path, .mem_bytes = mem,
+                                  .cpu_pct = usage > c->usage_us ? 100.0 * (double)(usage - c->usage_us) / us : 0,
+                                  .throttled_pct = thr > c->throttled_us ? 100.0 * (double)(thr - c->throttled_us) / us : 0,
+                                  .read_bytes = rb > c->rbytes ? rb - c->rbytes : 0,
+                                  .write_bytes = wb > c->wbytes ? wb - c->wbytes : 0,
+                                  .has_mem = c->mem.fd >= 0, .has_io = c->io.fd >= 0 };
+        bool moved = usage != c->usage_us || thr != c->throttled_us || mem != c->mem_bytes || rb != c->rbytes || wb != c->wbytes;
+        emit = moved || c->moved;
+        c->moved = moved;
+    }
+    c->have_prev = true;
+    c->prev_ns = now;
+    c->usage_us = usage; c->throttled_us = thr; c->mem_bytes = mem; c->rbytes = rb; c->wbytes = wb;
+    return emit;
+}
+
+int cgroup_tree_sample(cgroup_tree_t *t, cgroup_fn fn, void *arg) {
+    apply_events(t);
+    uint64_t now = mono_ns();
+    for (int i = 0; i < t->nactive; i++) {
+        int s = t->active[i];
+        cg_t *c = &t->cg[s];
+        cgroup_sample_t out;
+        if (sample_one(c, now, &out) && fn) fn(&out, arg);
+        if (c->draining) { deactivate(t, s); i--; } // the last active slot moved into i
+    }
+    return t->nactive;
+}
+
+unsigned int cgroup_tree_count(const cgroup_tree_t *t) {
+    return t->count;
+}
+
+cgroup_tree_t *cgroup_tree_open(const char *root, unsigned int max_cgroups) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/cgroup.controllers", root);
+    if (access(path, R_OK) != 0) { errno = ENOTSUP; return NULL; }
+    cgroup_tree_t *t = calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    t->max = max_cgroups ? max_cgroups : CGROUP_MAX_TRACKED;
+    t->ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    t->root = strdup(root);
+    if (!t->root || t->ifd < 0 || wd_resize(t, 64) != 0) { cgroup_tree_close(t); return NULL; }
+    cg_add(t, "");
+    return t;
+}
+
+void cgroup_tree_close(cgroup_tree_t *t) {
+    if (!t) return;
+    for (int s = 0; s < t->ncg; s++) {
+        if (t->cg[s].wd < 0) continue;
+        deactivate(t, s);
+        free(t->cg[s].path);
+    }
+    if (t->ifd >= 0) close(t->ifd);
+    free(t->cg); free(t->free_slots); free(t->active); free(t->wd_key); free(t->wd_val);
+    free(t->root);
+    free(t);
+}
@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include "collector.h"
+#include "selfstat.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+// Single-threaded scheduler: one timerfd per collector, multiplexed through epoll.
+// Timers are periodic on absolute CLOCK_MONOTONIC deadlines, so a slow tick never
+// shifts later ones; overruns show up as extra expirations and are counted as missed.
+// A collector's event_fds sit in the same epoll set and tick it out of turn.
+
+// epoll data: collector i's timer is i, its event fd j EVENT_ID(i, j), the stop fd UINT32_MAX.
+#define EVENT_ID(i, j) (MAX_COLLECTORS + (uint32_t)(i) * COLLECTOR_EVENT_FDS + (uint32_t)(j))
+#define MAX_EVENTS (MAX_COLLECTORS * (1 + COLLECTOR_EVENT_FDS) + 1)
+
+static int arm_timer(int tfd, const struct timespec *base, unsigned int interval_ms) {
+    if (interval_ms == 0) interval_ms = 1;
+    struct itimerspec its;
+    its.it_interval.tv_sec = interval_ms / 1000;
+    its.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000L;
+    its.it_value.tv_sec = base->tv_sec + its.it_interval.tv_sec;
+    its.it_value.tv_nsec = base->tv_nsec + its.it_interval.tv_nsec;
+    if (its.it_value.tv_nsec >= 1000000000L) { its.it_value.tv_sec++; its.it_value.tv_nsec -= 1000000000L; }
+    return timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+// Ticks collector i and, if that changed its interval (adaptive, or a reload), starts
+// the new period from now.
+static void tick(collector_t *cols, int i, int tfd, monitor_ctx_t *ctx) {
+    unsigned int was = cols[i].interval_ms;
+    collector_tick(&cols[i], i, ctx);
+    if (cols[i].interval_ms != was) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        arm_timer(tfd, &now, cols[i].interval_ms);
+    }
+}
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void collector_tick(collector_t *c, int idx, monitor_ctx_t *ctx) {
+    unsigned int gen = atomic_load_explicit(&ctx->cfg_gen, memory_order_acquire);
+    if (gen != c->cfg_gen) {
+        pthread_mutex_lock(&ctx->cfg_lock);
+        collector_configure(c, &ctx->cfg);
+        pthread_mutex_unlock(&ctx->cfg_lock);
+        c->cfg_gen = gen;
+    }
+    uint64_t now = mono_ns();
+    c->tick_ms = c->last_tick_ns ? (unsigned int)((now - c->last_tick_ns + 500000) / 1000000) : c->interval_ms;
+    c->last_tick_ns = now;
+    c->level = NAN;
+    (void)idx;
+    SELF_TIME_START(t0);
+    c->sample(c, ctx);
+    c->events = 0;
+    SELF_TIME_END(SELF_H_SAMPLE + idx, t0);
+    c->ticks++;
+    if (c->adaptive && !isnan(c->level)) c->interval_ms = adapt_next(&c->adapt, c->interval_ms, c->level);
+}
+
+int collector_loop_run(collector_t *cols, int n, monitor_ctx_t *ctx, int stop_fd) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) { perror("epoll_create1"); return -1; }
+    SELF_THREAD("loop");
+    int tfds[MAX_COLLECTORS];
+    struct timespec base;
+    clock_gettime(CLOCK_MONOTONIC, &base);
+    int armed = 0;
+    for (int i = 0; i < n && i < MAX_COLLECTORS; i++) {
+        tfds[i] = -1;
+        if (!cols[i].state) continue; // init failed
+        int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (tfd < 0 || arm_timer(tfd, &base, cols[i].interval_ms) != 0) {
+            perror("timerfd");
+            if (tfd >= 0) close(tfd);
+            continue;
+        }
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)i };
+        epoll_ctl(ep, EPOLL_CTL_ADD, tfd, &ev);
+        tfds[i] = tfd;
+        armed++;
+        for (int j = 0; j < cols[i].nevent_fds; j++) {
+            struct epoll_event xev = { .events = (uint32_t)cols[i].event_mask, .data.u32 = (uint32_t)(EVENT_ID(i, j)) };
+            epoll_ctl(ep, EPOLL_CTL_ADD, cols[i].event_fds[j], &xev);
+        }
+    }
+    if (stop_fd >= 0) {
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = UINT32_MAX };
+        epoll_ctl(ep, EPOLL_CTL_ADD, stop_fd, &ev);
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (ctx->running && armed > 0) {
+        int k = epoll_wait(ep, events, MAX_EVENTS, -1);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int e = 0; e < k && ctx->running; e++) {
+            uint32_t i = events[e].data.u32;
+            if (i == UINT32_MAX) { ctx->running = false; break; }
+            if (i >= EVENT_ID(0, 0)) {
+                // Ticked once per batch, after every fd that fired has set its bit.
+                collector_t *c = &cols[(i - EVENT_ID(0, 0)) / COLLECTOR_EVENT_FDS];
+                c->events |= 1u << ((i - EVENT_ID(0, 0)) % COLLECTOR_EVENT_FDS);
+                continue;
+            }
+            uint64_t expirations = 0;
+            if (read(tfds[i], &expirations, sizeof(expirations)) != sizeof(expirations)) continue;
+            if (expirations > 1) cols[i].missed += expirations - 1;
+            tick(cols, (int)i, tfds[i], ctx);
+        }
+        for (int i = 0; i < n && i < MAX_COLLECTORS && ctx->running; i++)
+            if (cols[i].events) tick(cols, i, tfds[i], ctx);
+    }
+
+    for (int i = 0; i < n && i < MAX_COLLECTORS; i++) {
+        if (tfds[i] >= 0) close(tfds[i]);
+    }
+    close(ep);
+    return 0;
+}
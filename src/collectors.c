@@ -0,0 +1,54 @@
+#include "collectors.h"
+
+
+// cpu  3357 0 4313 1362393 0 0 0 0 0 0
+int parse_cpu_times(const char *buf, cpu_times_t *t) {
+    if (!pr_starts_with(buf, "cpu ")) return -1;
+    const char *p = buf + 4;
+    unsigned long long *fields[] = { &t->user, &t->nice, &t->system, &t->idle, &t->iowait,
+                                     &t->irq, &t->softirq, &t->steal, &t->guest, &t->guest_nice };
+    int n = 0;
+    for (; n < 10; n++) {
+        if (!pr_next_u64(&p, fields[n])) break;
+    }
+    for (int i = n; i < 10; i++) *fields[i] = 0;
+    return (n >= 4) ? 0 : -1;
+}
+
+double cpu_busy_percent(const cpu_times_t *a, const cpu_times_t *b) {
+    unsigned long long idle_a = a->idle + a->iowait;
+    unsigned long long idle_b = b->idle + b->iowait;
+    unsigned long long non_a = a->user + a->nice + a->system + a->irq + a->softirq + a->steal;
+    unsigned long long non_b = b->user + b->nice + b->system + b->irq + b->softirq + b->steal;
+    unsigned long long idle_delta = idle_b - idle_a;
+    unsigned long long non_delta = non_b - non_a;
+    unsigned long long total = idle_delta + non_delta;
+    if (total == 0) return 0.0;
+    return 100.0 * ((double)non_delta / (double)total);
+}
+
+double parse_mem_usage_percent(const char *buf) {
+    unsigned long long memTotal = 0, memAvailable = 0;
+    bool haveAvail = false;
+    for (const char *p = buf; *p; p = pr_next_line(p)) {
+        if (pr_starts_with(p, "MemTotal:")) {
+            p += 9; pr_next_u64(&p, &memTotal);
+        } else if (pr_starts_with(p, "MemAvailable:")) {
+            p += 13; haveAvail = pr_next_u64(&p, &memAvailable);
+            break;
+        }
+    }
+    if (memTotal == 0 || !haveAvail) return -1.0;
+    double used = (double)(memTotal - memAvailable);
+    return 100.0 * used / (double)memTotal;
+}
+
+int read_cpu_times(proc_file_t *pf, cpu_times_t *t) {
+    if (pf_read(pf) < 0) return -1;
+    return parse_cpu_times(pf->buf, t);
+}
+
+double read_mem_usage_percent(proc_file_t *pf) {
+    if (pf_read(pf) < 0) return -1.0;
+    return parse_mem_usage_percent(pf->buf);
+}
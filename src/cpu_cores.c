@@ -0,0 +1,195 @@
+#define _GNU_SOURCE
+#include "cpu_cores.h"
+#include "proc_reader.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+#define CORE_ALIGN 32
+#define CORE_LANES 4
+
+static unsigned long long *grow_u64(unsigned long long *old, int old_cap, int new_cap) {
+    unsigned long long *p = aligned_alloc(CORE_ALIGN, sizeof(*p) * (size_t)new_cap);
+    if (!p) return NULL;
+    if (old) memcpy(p, old, sizeof(*p) * (size_t)old_cap);
+    memset(p + old_cap, 0, sizeof(*p) * (size_t)(new_cap - old_cap));
+    free(old);
+    return p;
+}
+
+static double *grow_f64(double *old, int new_cap) {
+    free(old);
+    double *p = aligned_alloc(CORE_ALIGN, sizeof(*p) * (size_t)new_cap);
+    if (p) memset(p, 0, sizeof(*p) * (size_t)new_cap);
+    return p;
+}
+
+static int round_cap(int n) {
+    int cap = CORE_LANES;
+    while (cap < n) cap *= 2;
+    return cap;
+}
+
+void cpu_cores_init(cpu_cores_t *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+void cpu_cores_free(cpu_cores_t *c) {
+    free(c->user); free(c->nice); free(c->system); free(c->idle);
+    free(c->iowait); free(c->irq); free(c->softirq); free(c->steal);
+    memset(c, 0, sizeof(*c));
+}
+
+void cpu_core_pct_init(cpu_core_pct_t *p) {
+    memset(p, 0, sizeof(*p));
+}
+
+void cpu_core_pct_free(cpu_core_pct_t *p) {
+    free(p->busy); free(p->user); free(p->system); free(p->iowait); free(p->steal);
+    memset(p, 0, sizeof(*p));
+}
+
+static int cores_reserve(cpu_cores_t *c, int n) {
+    if (n <= c->cap) return 0;
+    int cap = round_cap(n);
+    unsigned long long **arrs[] = { &c->user, &c->nice, &c->system, &c->idle,
+                                    &c->iowait, &c->irq, &c->softirq, &c->steal };
+    for (size_t i = 0; i < sizeof(arrs) / sizeof(arrs[0]); i++) {
+        unsigned long long *p = grow_u64(*arrs[i], c->cap, cap);
+        if (!p) return -1;
+        *arrs[i] = p;
+    }
+    c->cap = cap;
+    return 0;
+}
+
+static int pct_reserve(cpu_core_pct_t *p, int cap) {
+    if (cap <= p->cap) return 0;
+    double **arrs[] = { &p->busy, &p->user, &p->system, &p->iowait, &p->steal };
+    for (size_t i = 0; i < sizeof(arrs) / sizeof(arrs[0]); i++) {
+        if (!(*arrs[i] = grow_f64(*arrs[i], cap))) return -1;
+    }
+    p->cap = cap;
+    return 0;
+}
+
+// cpu0 2271 0 652 21667 117 0 0 309 0 0
+int parse_cpu_cores(const char *buf, cpu_cores_t *c) {
+    int ncores = 0;
+    for (const char *p = buf; *p; p = pr_next_line(p)) {
+        if (!pr_starts_with(p, "cpu")) {
+            if (ncores > 0) break; // per-core lines are contiguous; skip the long intr line
+            continue;
+        }
+        const char *q = p + 3;
+        unsigned long long core;
+        if (*q < '0' || *q > '9' || !pr_next_u64(&q, &core)) continue; // aggregate line
+        int idx = (int)core;
+        if (cores_reserve(c, idx + 1) != 0) return -1;
+        unsigned long long v[8] = {0};
+        for (int i = 0; i < 8 && pr_next_u64(&q, &v[i]); i++) {}
+        c->user[idx] = v[0]; c->nice[idx] = v[1]; c->system[idx] = v[2]; c->idle[idx] = v[3];
+        c->iowait[idx] = v[4]; c->irq[idx] = v[5]; c->softirq[idx] = v[6]; c->steal[idx] = v[7];
+        if (idx + 1 > ncores) ncores = idx + 1;
+    }
+    c->ncores = ncores;
+    return ncores > 0 ? 0 : -1;
+}
+
+static inline double d64(unsigned long long a, unsigned long long b) {
+    return b > a ? (double)(b - a) : 0.0; // counters can step back on CPU hotplug
+}
+
+static void delta_scalar_range(const cpu_cores_t *pv, const cpu_cores_t *cu, cpu_core_pct_t *o, int from, int n) {
+    for (int i = from; i < n; i++) {
+        double user = d64(pv->user[i], cu->user[i]) + d64(pv->nice[i], cu->nice[i]);
+        double system = d64(pv->system[i], cu->system[i]) + d64(pv->irq[i], cu->irq[i]) +
+                        d64(pv->softirq[i], cu->softirq[i]);
+        double idle = d64(pv->idle[i], cu->idle[i]);
+        double iowait = d64(pv->iowait[i], cu->iowait[i]);
+        double steal = d64(pv->steal[i], cu->steal[i]);
+        double total = user + system + idle + iowait + steal;
+        double scale = total > 0 ? 100.0 / total : 0.0;
+        o->busy[i] = (user + system + steal) * scale;
+        o->user[i] = user * scale;
+        o->system[i] = system * scale;
+        o->iowait[i] = iowait * scale;
+        o->steal[i] = steal * scale;
+    }
+}
+
+void cpu_cores_delta_scalar(const cpu_cores_t *prev, const cpu_cores_t *cur, cpu_core_pct_t *out, int n) {
+    delta_scalar_range(prev, cur, out, 0, n);
+}
+
+#ifdef HAVE_X86_KERNELS
+// Counter deltas are far below 2^52, so u64 -> double is done with the exponent trick
+// (OR in the bits of 2^52, subtract 2^52) since AVX2 has no packed u64 conversion.
+__attribute__((target("avx2")))
+static inline __m256d delta4(const unsigned long long *prev, const unsigned long long *cur) {
+    __m256i a = _mm256_load_si256((const __m256i *)prev);
+    __m256i b = _mm256_load_si256((const __m256i *)cur);
+    __m256i d = _mm256_andnot_si256(_mm256_cmpgt_epi64(a, b), _mm256_sub_epi64(b, a));
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(d, _mm256_set1_epi64x(0x4330000000000000LL))),
+                         _mm256_set1_pd(4503599627370496.0));
+}
+
+__attribute__((target("avx2")))
+static void delta_avx2(const cpu_cores_t *pv, const cpu_cores_t *cu, cpu_core_pct_t *o, int n) {
+    const __m256d hundred = _mm256_set1_pd(100.0);
+    const __m256d zero = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + CORE_LANES <= n; i += CORE_LANES) {
+        __m256d user = _mm256_add_pd(delta4(pv->user + i, cu->user + i), delta4(pv->nice + i, cu->nice + i));
+        __m256d system = _mm256_add_pd(_mm256_add_pd(delta4(pv->system + i, cu->system + i),
+                                                     delta4(pv->irq + i, cu->irq + i)),
+                                       delta4(pv->softirq + i, cu->softirq + i));
+        __m256d idle = delta4(pv->idle + i, cu->idle + i);
+        __m256d iowait = delta4(pv->iowait + i, cu->iowait + i);
+        __m256d steal = delta4(pv->steal + i, cu->steal + i);
+        __m256d busy = _mm256_add_pd(_mm256_add_pd(user, system), steal);
+        __m256d total = _mm256_add_pd(_mm256_add_pd(busy, idle), iowait);
+        __m256d scale = _mm256_and_pd(_mm256_div_pd(hundred, total),
+                                      _mm256_cmp_pd(total, zero, _CMP_GT_OQ));
+        _mm256_store_pd(o->busy + i, _mm256_mul_pd(busy, scale));
+        _mm256_store_pd(o->user + i, _mm256_mul_pd(user, scale));
+        _mm256_store_pd(o->system + i, _mm256_mul_pd(system, scale));
+        _mm256_store_pd(o->iowait + i, _mm256_mul_pd(iowait, scale));
+        _mm256_store_pd(o->steal + i, _mm256_mul_pd(steal, scale));
+    }
+    delta_scalar_range(pv, cu, o, i, n);
+}
+#endif
+
+typedef void (*delta_fn)(const cpu_cores_t *, const cpu_cores_t *, cpu_core_pct_t *, int);
+
+static delta_fn pick_kernel(const char **name) {
+#ifdef HAVE_X86_KERNELS
+    if (__builtin_cpu_supports("avx2")) { *name = "avx2"; return delta_avx2; }
+#endif
+    *name = "scalar";
+    return cpu_cores_delta_scalar;
+}
+
+static delta_fn g_kernel;
+static const char *g_kernel_name;
+
+const char *cpu_cores_kernel_name(void) {
+    if (!g_kernel) g_kernel = pick_kernel(&g_kernel_name);
+    return g_kernel_name;
+}
+
+int cpu_cores_delta(const cpu_cores_t *prev, const cpu_cores_t *cur, cpu_core_pct_t *out) {
+    if (!g_kernel) g_kernel = pick_kernel(&g_kernel_name);
+    int n = cur->ncores < prev->ncores ? cur->ncores : prev->ncores;
+    if (n <= 0) return -1;
+    if (pct_reserve(out, cur->cap) != 0) return -1;
+    g_kernel(prev, cur, out, n);
+    out->ncores = n;
+    return 0;
+}
@@ -0,0 +1,368 @@
+#define _GNU_SOURCE
+#include "dev_stats.h"
+#include "proc_reader.h"
+
+#include <errno.h>
+#include <fnmatch.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+void dev_table_init(dev_table_t *t, dev_class_t cls, const char *filter) {
+    memset(t, 0, sizeof(*t));
+    t->cls = cls;
+    t->filter = filter ? filter : cls == DEV_DISK ? DEV_DISK_DEFAULT_FILTER : DEV_NET_DEFAULT_FILTER;
+}
+
+static void free_rows(dev_table_t *t) {
+    free(t->key); free(t->name); free(t->use); free(t->moved);
+    free(t->a); free(t->b); free(t->a0); free(t->b0);
+}
+
+void dev_table_free(dev_table_t *t) {
+    free_rows(t);
+    free(t->skey); free(t->sname); free(t->sa); free(t->sb);
+    dev_table_init(t, t->cls, t->filter);
+}
+
+bool dev_filter_match(const char *filter, const char *name) {
+    bool any_include = false, included = false;
+    char pat[64];
+    for (const char *p = filter; p && *p;) {
+        const char *e = strchr(p, ',');
+        size_t len = e ? (size_t)(e - p) : strlen(p);
+        const char *next = e ? e + 1 : p + len;
+        bool neg = len > 0 && *p == '!';
+        if (neg) { p++; len--; }
+        if (len > 0 && len < sizeof(pat)) {
+            memcpy(pat, p, len);
+            pat[len] = '\0';
+            bool hit = fnmatch(pat, name, 0) == 0;
+            if (neg && hit) return false;
+            if (!neg) { any_include = true; included |= hit; }
+        }
+        p = next;
+    }
+    return !any_include || included;
+}
+
+// sda1 after sda, nvme0n1p2 after nvme0n1: the name is the last whole disk's plus [p]digits.
+static bool is_partition(const char *disk, const char *name) {
+    size_t n = strlen(disk);
+    if (n == 0 || strncmp(name, disk, n) != 0) return false;
+    const char *p = name + n;
+    if (*p == 'p') p++;
+    if (*p < '0' || *p > '9') return false;
+    while (*p >= '0' && *p <= '9') p++;
+    return *p == '\0';
+}
+
+static void classify(dev_table_t *t) {
+    const char *disk = "";
+    for (int i = 0; i < t->n; i++) {
+        bool part = t->cls == DEV_DISK && is_partition(disk, t->name[i]);
+        if (t->cls == DEV_DISK && !part) disk = t->name[i];
+        t->use[i] = !part && t->name[i][0] && dev_filter_match(t->filter, t->name[i]);
+    }
+}
+
+// ---- Row lookup, used only while rebuilding ----
+
+typedef struct { int *slot; uint32_t mask; bool by_name; } row_index_t;
+
+static uint32_t name_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+}
+
+static uint32_t key_hash(uint32_t k) {
+    k ^= k >> 16; k *= 0x45d9f3bu; k ^= k >> 16;
+    return k;
+}
+
+// Open-addressing index over rows [lo, hi) of t, by name or by key.
+static int index_build(row_index_t *ix, const dev_table_t *t, int lo, int hi, bool by_name) {
+    uint32_t size = 16;
+    while (size < 2u * (uint32_t)(hi - lo)) size <<= 1;
+    if (!(ix->slot = malloc(size * sizeof(int)))) return -1;
+    memset(ix->slot, 0xff, size * sizeof(int));
+    ix->mask = size - 1;
+    ix->by_name = by_name;
+    for (int i = lo; i < hi; i++) {
+        uint32_t h = (by_name ? name_hash(t->name[i]) : key_hash(t->key[i])) & ix->mask;
+        while (ix->slot[h] >= 0) h = (h + 1) & ix->mask;
+        ix->slot[h] = i;
+    }
+    return 0;
+}
+
+static int index_find(const row_index_t *ix, const dev_table_t *t, uint32_t key, const char *name) {
+    for (uint32_t h = (ix->by_name ? name_hash(name) : key_hash(key)) & ix->mask; ix->slot[h] >= 0; h = (h + 1) & ix->mask) {
+        int i = ix->slot[h];
+        if (ix->by_name ? strcmp(t->name[i], name) == 0 : t->key[i] == key) return i;
+    }
+    return -1;
+}
+
+// ---- Scanning ----
+
+#define GROW(p, n) do { void *q_ = realloc((p), (size_t)(n) * sizeof(*(p))); if (!q_) return -1; (p) = q_; } while (0)
+
+static int grow_stage(dev_table_t *t) {
+    int cap = t->scap ? t->scap * 2 : 64;
+    GROW(t->skey, cap); GROW(t->sname, cap); GROW(t->sa, cap); GROW(t->sb, cap);
+    t->scap = cap;
+    return 0;
+}
+
+static void scan_begin(dev_table_t *t, bool by_name) {
+    t->seen = 0;
+    t->dirty = false;
+    t->by_name = by_name;
+}
+
+// One device line. While every line matches the cached row at its position this is
+// two stores; from the first that does not, rows are staged for rebuild().
+static void scan_row(dev_table_t *t, uint32_t key, const char *name, size_t len, uint64_t a, uint64_t b) {
+    if (len >= DEV_NAME_MAX) len = DEV_NAME_MAX - 1;
+    int i = t->seen++;
+    if (!t->dirty && i < t->n &&
+        (t->by_name ? memcmp(t->name[i], name, len) == 0 && t->name[i][len] == '\0' : t->key[i] == key)) {
+        t->a[i] = a; t->b[i] = b;
+        return;
+    }
+    if (!t->dirty) { t->dirty = true; t->first = i; t->staged = 0; }
+    if (t->staged == t->scap && grow_stage(t) != 0) return;
+    int j = t->staged++;
+    t->skey[j] = key;
+    if (len) memcpy(t->sname[j], name, len);
+    t->sname[j][len] = '\0';
+    t->sa[j] = a; t->sb[j] = b;
+}
+
+// /proc/net/dev has no ifindex: ask the kernel, once per new interface. Names it does
+// not know (another namespace, a fixture) get a hash with the top bit set.
+static uint32_t if_key(const char *name) {
+    unsigned int idx = if_nametoindex(name);
+    return idx ? idx : 0x80000000u | (name_hash(name) & 0x7FFFFFFFu);
+}
+
+// Rows [0, first) are unchanged; the staged rows replace the rest. Rows that existed
+// before (same key, or same name for /proc/net/dev) keep their previous snapshot.
+static int rebuild(dev_table_t *t) {
+    int n = t->first + t->staged, cap = t->cap ? t->cap : 64;
+    while (cap < n) cap *= 2;
+    dev_table_t nt = { .n = n, .cap = cap };
+    row_index_t ix = {0};
+    int rc = -1;
+    if (!(nt.key = malloc((size_t)cap * sizeof(*nt.key))) || !(nt.name = calloc((size_t)cap, sizeof(*nt.name))) ||
+        !(nt.use = calloc((size_t)cap, 1)) || !(nt.moved = calloc((size_t)cap, 1)) ||
+        !(nt.a = malloc((size_t)cap * 8)) || !(nt.b = malloc((size_t)cap * 8)) ||
+        !(nt.a0 = malloc((size_t)cap * 8)) || !(nt.b0 = malloc((size_t)cap * 8)) ||
+        index_build(&ix, t, t->first, t->n, t->by_name) != 0)
+        goto out;
+    size_t k = (size_t)t->first;
+    if (k) {
+        memcpy(nt.key, t->key, k * sizeof(*nt.key)); memcpy(nt.name, t->name, k * sizeof(*nt.name));
+        memcpy(nt.moved, t->moved, k); memcpy(nt.a, t->a, k * 8); memcpy(nt.b, t->b, k * 8);
+        memcpy(nt.a0, t->a0, k * 8); memcpy(nt.b0, t->b0, k * 8);
+    }
+    for (int j = 0; j < t->staged; j++) {
+        int r = t->first + j, o = index_find(&ix, t, t->skey[j], t->sname[j]);
+        memcpy(nt.name[r], o >= 0 && !t->sname[j][0] ? t->name[o] : t->sname[j], DEV_NAME_MAX);
+        nt.a[r] = t->sa[j]; nt.b[r] = t->sb[j];
+        if (o >= 0) {
+            nt.key[r] = t->key[o];
+            nt.a0[r] = t->a0[o]; nt.b0[r] = t->b0[o]; nt.moved[r] = t->moved[o];
+        } else {
+            nt.key[r] = t->by_name ? if_key(t->sname[j]) : t->skey[j];
+            nt.a0[r] = nt.a[r]; nt.b0[r] = nt.b[r];
+        }
+    }
+    free_rows(t);
+    t->key = nt.key; t->name = nt.name; t->use = nt.use; t->moved = nt.moved;
+    t->a = nt.a; t->b = nt.b; t->a0 = nt.a0; t->b0 = nt.b0;
+    t->n = n; t->cap = cap;
+    t->rebuilds++;
+    classify(t);
+    memset(&nt, 0, sizeof(nt));
+    rc = 0;
+out:
+    free_rows(&nt);
+    free(ix.slot);
+    return rc;
+}
+
+static int scan_end(dev_table_t *t) {
+    if (!t->dirty) {
+        if (t->seen == t->n) return 0;
+        t->first = t->seen; // rows vanished from the end
+        t->staged = 0;
+    }
+    return rebuild(t);
+}
+
+int dev_parse_diskstats(dev_table_t *t, const char *buf) {
+    scan_begin(t, false);
+    for (const char *p = buf; *p; p = pr_next_line(p)) {
+        // major minor name rd_ios rd_merges rd_sectors rd_ticks wr_ios wr_merges wr_sectors ...
+        const char *q = p;
+        unsigned long long maj, min, v[7];
+        if (!pr_next_u64(&q, &maj) || !pr_next_u64(&q, &min)) continue;
+        const char *name = pr_skip_blanks(q);
+        q = pr_skip_token(q);
+        size_t len = (size_t)(q - name);
+        int n = 0;
+        while (n < 7 && pr_next_u64(&q, &v[n])) n++;
+        if (n == 7) scan_row(t, DEV_KEY(maj, min), name, len, v[2], v[6]);
+    }
+    return scan_end(t);
+}
+
+// iface: rxBytes rxPackets ... (8 rx fields) txBytes ...
+int dev_parse_net_dev(dev_table_t *t, const char *buf) {
+    scan_begin(t, true);
+    for (const char *p = pr_next_line(pr_next_line(buf)); *p; p = pr_next_line(p)) { // two header lines
+        const char *name = pr_skip_blanks(p), *q = name;
+        while (*q && *q != ':' && *q != '\n') q++;
+        if (*q != ':') continue;
+        size_t len = (size_t)(q - name);
+        q++;
+        unsigned long long v[9];
+        int n = 0;
+        while (n < 9 && pr_next_u64(&q, &v[n])) n++;
+        if (n == 9) scan_row(t, 0, name, len, v[0], v[8]);
+    }
+    return scan_end(t);
+}
+
+void dev_table_sum(const dev_table_t *t, uint64_t *a, uint64_t *b) {
+    uint64_t sa = 0, sb = 0;
+    for (int i = 0; i < t->n; i++) {
+        if (!t->use[i]) continue;
+        sa += t->a[i]; sb += t->b[i];
+    }
+    *a = sa; *b = sb;
+}
+
+// ---- rtnetlink ----
+
+#define NL_BUF_SIZE (64 * 1024)
+
+struct dev_netlink {
+    int fd;
+    uint32_t seq;
+    bool need_names; // rows added by the last rebuild still lack a name
+    char *buf;
+};
+
+dev_netlink_t *dev_netlink_open(void) {
+    dev_netlink_t *nl = calloc(1, sizeof(*nl));
+    if (!nl) return NULL;
+    struct sockaddr_nl sa = { .nl_family = AF_NETLINK };
+    nl->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (nl->fd < 0 || bind(nl->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 || !(nl->buf = malloc(NL_BUF_SIZE))) {
+        dev_netlink_close(nl);
+        return NULL;
+    }
+    return nl;
+}
+
+void dev_netlink_close(dev_netlink_t *nl) {
+    if (!nl) return;
+    if (nl->fd >= 0) close(nl->fd);
+    free(nl->buf);
+    free(nl);
+}
+
+// Sends a dump request and hands each reply to fn until NLMSG_DONE.
+static int nl_dump(dev_netlink_t *nl, struct nlmsghdr *req, void (*fn)(const struct nlmsghdr *, void *), void *arg) {
+    req->nlmsg_seq = ++nl->seq;
+    if (send(nl->fd, req, req->nlmsg_len, 0) < 0) return -1;
+    for (;;) {
+        ssize_t len = recv(nl->fd, nl->buf, NL_BUF_SIZE, 0);
+        if (len < 0 && errno == EINTR) continue;
+        if (len <= 0) return -1;
+        for (size_t off = 0; off + sizeof(struct nlmsghdr) <= (size_t)len;) {
+            const struct nlmsghdr *h = (const struct nlmsghdr *)(nl->buf + off);
+            if (h->nlmsg_len < sizeof(*h) || off + h->nlmsg_len > (size_t)len) break;
+            off += NLMSG_ALIGN(h->nlmsg_len);
+            if (h->nlmsg_seq != nl->seq) continue;
+            if (h->nlmsg_type == NLMSG_DONE) return 0;
+            if (h->nlmsg_type == NLMSG_ERROR) return -1;
+            fn(h, arg);
+        }
+    }
+}
+
+// Finds attribute `type` in [p, end); NULL if absent.
+static const struct rtattr *nl_attr(const char *p, const char *end, unsigned short type) {
+    while (p + sizeof(struct rtattr) <= end) {
+        const struct rtattr *a = (const struct rtattr *)p;
+        if (a->rta_len < sizeof(*a) || p + a->rta_len > end) break;
+        if (a->rta_type == type) return a;
+        p += RTA_ALIGN(a->rta_len);
+    }
+    return NULL;
+}
+
+static void on_stats(const struct nlmsghdr *h, void *arg) {
+    if (h->nlmsg_type != RTM_NEWSTATS) return;
+    const struct if_stats_msg *m = NLMSG_DATA(h);
+    const struct rtattr *a = nl_attr((const char *)m + NLMSG_ALIGN(sizeof(*m)), (const char *)h + h->nlmsg_len,
+                                     IFLA_STATS_LINK_64);
+    if (!a || RTA_PAYLOAD(a) < offsetof(struct rtnl_link_stats64, tx_bytes) + sizeof(uint64_t)) return;
+    uint64_t rx, tx;
+    memcpy(&rx, (const char *)RTA_DATA(a) + offsetof(struct rtnl_link_stats64, rx_bytes), sizeof(rx));
+    memcpy(&tx, (const char *)RTA_DATA(a) + offsetof(struct rtnl_link_stats64, tx_bytes), sizeof(tx));
+    scan_row(arg, m->ifindex, NULL, 0, rx, tx);
+}
+
+typedef struct { dev_table_t *t; row_index_t ix; } names_arg_t;
+
+static void on_link(const struct nlmsghdr *h, void *arg) {
+    names_arg_t *na = arg;
+    if (h->nlmsg_type != RTM_NEWLINK) return;
+    const struct ifinfomsg *ifi = NLMSG_DATA(h);
+    const struct rtattr *a = nl_attr((const char *)ifi + NLMSG_ALIGN(sizeof(*ifi)), (const char *)h + h->nlmsg_len, IFLA_IFNAME);
+    int r = index_find(&na->ix, na->t, (uint32_t)ifi->ifi_index, NULL);
+    if (!a || r < 0 || na->t->name[r][0]) return;
+    size_t len = strnlen(RTA_DATA(a), RTA_PAYLOAD(a));
+    if (len >= DEV_NAME_MAX) len = DEV_NAME_MAX - 1;
+    memcpy(na->t->name[r], RTA_DATA(a), len);
+    na->t->name[r][len] = '\0';
+}
+
+int dev_netlink_read(dev_netlink_t *nl, dev_table_t *t) {
+    struct { struct nlmsghdr h; struct if_stats_msg m; } req = {
+        .h = { .nlmsg_len = sizeof(req), .nlmsg_type = RTM_GETSTATS, .nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP },
+        .m = { .family = AF_UNSPEC, .filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64) },
+    };
+    uint64_t rebuilds = t->rebuilds;
+    scan_begin(t, false);
+    if (nl_dump(nl, &req.h, on_stats, t) != 0 || scan_end(t) != 0) return -1;
+    if (t->rebuilds != rebuilds) nl->need_names = true;
+    if (!nl->need_names) return 0;
+
+    // New interfaces: one link dump for their names, then the filter.
+    struct { struct nlmsghdr h; struct ifinfomsg m; } lreq = {
+        .h = { .nlmsg_len = sizeof(lreq), .nlmsg_type = RTM_GETLINK, .nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP },
+        .m = { .ifi_family = AF_UNSPEC },
+    };
+    names_arg_t na = { .t = t };
+    if (index_build(&na.ix, t, 0, t->n, false) != 0) return 0;
+    int rc = nl_dump(nl, &lreq.h, on_link, &na);
+    free(na.ix.slot);
+    if (rc != 0) return 0; // counters are fine; names are retried next tick
+    nl->need_names = false;
+    for (int i = 0; i < t->n; i++) nl->need_names |= !t->name[i][0];
+    classify(t);
+    return 0;
+}
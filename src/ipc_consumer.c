@@ -1,4 +1,9 @@
+#define _GNU_SOURCE
+#include "shm_metrics.h"
+#include "metric_format.h"
+
 #include <mqueue.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,13 +11,15 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
-// Simple consumer that reads summaries from the POSIX MQ used by the monitor
-int main(int argc, char **argv) {
-    const char *name = (argc > 1) ? argv[1] : "/sysmon_queue";
+static volatile sig_atomic_t g_stop = 0;
+static void on_sigint(int sig) { (void)sig; g_stop = 1; }
+
+// Legacy path: reads the text summaries the monitor sends with --mq-summary
+static int run_mq(const char *name) {
     mqd_t q = mq_open(name, O_RDONLY);
     if (q == (mqd_t)-1) {
         perror("mq_open");
-        fprintf(stderr, "Ensure the monitor is running and created %s\n", name);
+        fprintf(stderr, "Ensure the monitor is running with --mq-summary and created %s\n", name);
         return 1;
     }
     struct mq_attr attr;
@@ -20,13 +27,13 @@ int main(int argc, char **argv) {
     char *buf = malloc(attr.mq_msgsize);
     if (!buf) { perror("malloc"); mq_close(q); return 1; }
     printf("Listening on MQ %s (Ctrl+C to stop)\n", name);
-    while (1) {
+    while (!g_stop) {
         ssize_t n = mq_receive(q, buf, attr.mq_msgsize, NULL);
         if (n >= 0) {
             printf("[Summary] %s\n", buf);
             fflush(stdout);
         } else {
-            perror("mq_receive");
+            if (!g_stop) perror("mq_receive");
             break;
         }
     }
@@ -34,3 +41,109 @@ int main(int argc, char **argv) {
     mq_close(q);
     return 0;
 }
+
+// Default path: prints a summary from the monitor's rolling aggregates every interval_s
+static void run_summary(const shm_metrics_t *shm, int interval_s) {
+    while (!g_stop) {
+        agg_summary_t cpu, mem;
+        if (shm_metrics_aggregates(shm, METRIC_CPU, &cpu) && shm_metrics_aggregates(shm, METRIC_MEM, &mem)) {
+            printf("[Summary] CPU=%.1f%% MEM=%.1f%% (10s avg)  CPU 1m p95=%.1f%% max=%.1f%%  MEM 5m max=%.1f%%\n",
+                   cpu.win[AGG_10S].mean, mem.win[AGG_10S].mean, cpu.win[AGG_1M].p95, cpu.win[AGG_1M].max,
+                   mem.win[AGG_5M].max);
+        } else {
+            printf("[Summary] waiting for aggregates\n");
+        }
+        fflush(stdout);
+        sleep((unsigned)interval_s);
+    }
+}
+
+// --aggregates: one table of every window for every kind with data, then exit
+static void print_aggregates(const shm_metrics_t *shm) {
+    printf("%-14s %-4s %8s %12s %12s %12s %12s %12s %12s\n",
+           "KIND", "WIN", "COUNT", "MIN", "MEAN", "MAX", "P50", "P95", "P99");
+    for (int k = 0; k < METRIC_KIND_COUNT; k++) {
+        agg_summary_t s;
+        const char *name = metric_kind_name((metric_kind_t)k);
+        if (!name || !shm_metrics_aggregates(shm, (metric_kind_t)k, &s)) continue;
+        for (int w = 0; w < AGG_WINDOWS; w++) {
+            const agg_stats_t *st = &s.win[w];
+            printf("%-14s %-4s %8llu %12.2f %12.2f %12.2f %12.2f %12.2f %12.2f\n", name,
+                   agg_window_name((agg_window_t)w), (unsigned long long)st->count,
+                   st->min, st->mean, st->max, st->p50, st->p95, st->p99);
+        }
+        printf("%-14s ewma=%.2f last=%.2f\n", name, s.ewma, s.last);
+    }
+}
+
+// --follow: streams every sample of one kind from the ring, sleeping on the futex in between
+static void run_follow(const shm_metrics_t *shm, metric_kind_t kind) {
+    uint64_t cursor = atomic_load(&shm->kinds[kind].head);
+    uint32_t gen = atomic_load(&shm->gen);
+    shm_sample_t batch[64];
+    char line[METRIC_LINE_MAX];
+    while (!g_stop) {
+        size_t n;
+        while ((n = shm_metrics_read(shm, kind, &cursor, batch, 64)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                metric_t m = { kind, batch[i].id, batch[i].v1, batch[i].v2, batch[i].ts_ms, batch[i].interval_ms };
+                if (metric_format_csv(line, sizeof(line), &m) > 0) fputs(line, stdout);
+            }
+            fflush(stdout);
+        }
+        gen = shm_metrics_wait(shm, gen, 1000);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *mq_name = NULL;
+    const char *follow = NULL;
+    bool aggregates = false;
+    const char *shm_name = SHM_METRICS_NAME;
+    int interval_s = 3;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mq") == 0) mq_name = (i + 1 < argc && argv[i+1][0] == '/') ? argv[++i] : "/sysmon_queue";
+        else if (strcmp(argv[i], "--follow") == 0 && i + 1 < argc) follow = argv[++i];
+        else if (strcmp(argv[i], "--aggregates") == 0) aggregates = true;
+        else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) interval_s = atoi(argv[++i]);
+        else if (strncmp(argv[i], "--shm-name=", 11) == 0) shm_name = argv[i] + 11; // as bin/monitor takes it
+        else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) shm_name = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--interval S] [--follow KIND] [--aggregates] [--shm-name NAME] [--mq [/name]]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (interval_s < 1) interval_s = 1;
+
+    struct sigaction sa = {0};
+    sa.sa_handler = on_sigint;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if (mq_name) return run_mq(mq_name);
+
+    const shm_metrics_t *shm = shm_metrics_attach(shm_name);
+    if (!shm) {
+        perror("shm_metrics_attach");
+        fprintf(stderr, "Ensure the monitor is running and created %s\n", shm_name);
+        return 1;
+    }
+    if (aggregates) {
+        print_aggregates(shm);
+    } else if (follow) {
+        int kind = metric_kind_from_name(follow);
+        if (kind < 0 || kind == METRIC_ALERT) {
+            fprintf(stderr, "Unknown metric kind: %s\n", follow);
+            shm_metrics_detach(shm);
+            return 1;
+        }
+        printf("Following %s on %s (Ctrl+C to stop)\n", metric_kind_name(kind), shm_name);
+        run_follow(shm, (metric_kind_t)kind);
+    } else {
+        printf("Reading %s (Ctrl+C to stop)\n", shm_name);
+        run_summary(shm, interval_s);
+    }
+    shm_metrics_detach(shm);
+    return 0;
+}
@@ -0,0 +1,411 @@
+#define _GNU_SOURCE
+#include "log_archive.h"
+#include "binlog.h"
+#include "log_sink.h"
+#include "metric_format.h"
+#include "selfstat.h"
+#include "tsdb.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <zlib.h>
+
+#define STAMP_LEN 19            // YYYYmmdd-HHMMSS-mmm
+#define ROLLUP_BATCH 262144     // metrics handed to tsdb_rollup at a time
+#define IOPRIO_IDLE (3 << 13)   // IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0)
+#define ROLLUP_PENDING "rollup.pending" // in PATH.tsdb while a segment is rolled up
+
+struct log_archive {
+    monitor_config_t cfg; // under lock
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool pending, stop; // under lock
+    _Atomic bool abort; // checked between buffers while compressing
+};
+
+// A live text or binary log, the names its segments take (DIR/BASE-STAMP EXT[.gz])
+// and the store its old segments are rolled up into (PATH.tsdb, whose raw tier stays
+// empty, so its 1m and 1h tiers answer for every time they cover).
+typedef struct {
+    char dir[PATH_MAX];
+    char base[NAME_MAX + 1];
+    const char *ext;
+    char store[PATH_MAX];
+    bool binary;
+} log_name_t;
+
+static void log_name(log_name_t *ln, const char *path, bool binary) {
+    if (snprintf(ln->store, sizeof(ln->store), "%s.tsdb", path) >= (int)sizeof(ln->store)) ln->store[0] = '\0';
+    const char *slash = strrchr(path, '/');
+    const char *file = slash ? slash + 1 : path;
+    const char *dot = strrchr(file, '.');
+    snprintf(ln->dir, sizeof(ln->dir), "%.*s", slash ? (int)(slash - path) : 1, slash ? path : ".");
+    snprintf(ln->base, sizeof(ln->base), "%.*s", dot ? (int)(dot - file) : (int)strlen(file), file);
+    ln->ext = dot ? dot : "";
+    ln->binary = binary;
+}
+
+// The live logs a config writes: text and binary (either may have segments left
+// from an earlier run in the other format), and the segment store.
+static void live_logs(const monitor_config_t *cfg, log_name_t ln[2], const char **tsdb_dir) {
+    log_name(&ln[0], cfg->log_format == LOG_TEXT && cfg->log_path ? cfg->log_path : TEXT_LOG_PATH, false);
+    log_name(&ln[1], cfg->log_format == LOG_BINARY && cfg->log_path ? cfg->log_path : BINARY_LOG_PATH, true);
+    *tsdb_dir = cfg->log_format == LOG_TSDB && cfg->log_path ? cfg->log_path : TSDB_DEFAULT_DIR;
+}
+
+int log_archive_rotate(const char *path, char *out, size_t cap) {
+    log_name_t ln;
+    log_name(&ln, path, false);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t ms = (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+    // A name is never reused: on a clash the stamp moves on by a millisecond.
+    for (int tries = 0; tries < 1000; tries++, ms++) {
+        time_t sec = (time_t)(ms / 1000);
+        struct tm tm;
+        gmtime_r(&sec, &tm);
+        int n = snprintf(out, cap, "%s/%s-%04d%02d%02d-%02d%02d%02d-%03u%s", ln.dir, ln.base, tm.tm_year + 1900,
+                         tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, (unsigned)(ms % 1000), ln.ext);
+        if (n < 0 || (size_t)n >= cap) { errno = ENAMETOOLONG; return -1; }
+        if (renameat2(AT_FDCWD, path, AT_FDCWD, out, RENAME_NOREPLACE) == 0) return 0;
+        if (errno == EINVAL || errno == ENOSYS) {
+            // No RENAME_NOREPLACE here: link(2) refuses an existing name just the same.
+            if (link(path, out) == 0) return unlink(path);
+        }
+        if (errno != EEXIST) return -1;
+    }
+    errno = EEXIST;
+    return -1;
+}
+
+// 1 for a compressed segment of ln, 0 for an uncompressed one, -1 otherwise. Stray
+// temporary files from an interrupted compression come back as -2.
+static int segment_kind(const log_name_t *ln, const char *name) {
+    size_t blen = strlen(ln->base), elen = strlen(ln->ext);
+    if (strncmp(name, ln->base, blen) != 0 || name[blen] != '-') return -1;
+    const char *p = name + blen + 1;
+    for (int i = 0; i < STAMP_LEN; i++)
+        if (!(i == 8 || i == 15 ? p[i] == '-' : p[i] >= '0' && p[i] <= '9')) return -1;
+    p += STAMP_LEN;
+    if (strncmp(p, ln->ext, elen) != 0) return -1;
+    p += elen;
+    if (*p == '\0') return 0;
+    if (strcmp(p, ".gz") == 0) return 1;
+    if (strcmp(p, ".gz.tmp") == 0) return -2;
+    return -1;
+}
+
+static int cmp_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Sorted (oldest first) segment names of ln; caller frees each and the array.
+static int list_segments(const log_name_t *ln, char ***out) {
+    *out = NULL;
+    DIR *d = opendir(ln->dir);
+    if (!d) return -1;
+    char **v = NULL;
+    size_t n = 0, cap = 0;
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        int k = segment_kind(ln, e->d_name);
+        if (k == -2) unlinkat(dirfd(d), e->d_name, 0);
+        if (k < 0) continue;
+        if (n == cap) {
+            char **nv = realloc(v, (cap = cap ? 2 * cap : 16) * sizeof(*v));
+            if (!nv) break;
+            v = nv;
+        }
+        if (!(v[n] = strdup(e->d_name))) break;
+        n++;
+    }
+    closedir(d);
+    if (n) qsort(v, n, sizeof(*v), cmp_names);
+    *out = v;
+    return (int)n;
+}
+
+// Streams src through deflate into src.gz, via a temporary name. Stops early (and
+// leaves src as it was) when *abort is set.
+static int gzip_file(const char *src, uint8_t *in, uint8_t *out, _Atomic bool *abort) {
+    char dst[PATH_MAX], tmp[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s.gz.tmp", src) >= (int)sizeof(tmp)) { errno = ENAMETOOLONG; return -1; }
+    snprintf(dst, sizeof(dst), "%.*s", (int)strlen(tmp) - 4, tmp);
+    int ifd = open(src, O_RDONLY | O_CLOEXEC);
+    if (ifd < 0) return -1;
+    int ofd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (ofd < 0) { close(ifd); return -1; }
+    posix_fadvise(ifd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    z_stream z = {0};
+    int rc = deflateInit2(&z, ARCHIVE_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK ? 0 : -1; // +16: gzip
+    for (int flush = Z_NO_FLUSH; rc == 0 && flush != Z_FINISH;) {
+        if (abort && atomic_load_explicit(abort, memory_order_relaxed)) { rc = -1; break; }
+        ssize_t n = read(ifd, in, ARCHIVE_BUF);
+        if (n < 0) { if (errno == EINTR) continue; rc = -1; break; }
+        if (n == 0) flush = Z_FINISH;
+        z.next_in = in;
+        z.avail_in = (uInt)n;
+        do {
+            z.next_out = out;
+            z.avail_out = ARCHIVE_BUF;
+            if (deflate(&z, flush) == Z_STREAM_ERROR) { rc = -1; break; }
+            size_t have = ARCHIVE_BUF - z.avail_out;
+            if (have && write(ofd, out, have) != (ssize_t)have) { rc = -1; break; }
+        } while (z.avail_out == 0);
+    }
+    deflateEnd(&z);
+    // The page cache has no use for either copy.
+    posix_fadvise(ifd, 0, 0, POSIX_FADV_DONTNEED);
+    close(ifd);
+    if (rc == 0 && fsync(ofd) != 0) rc = -1;
+    close(ofd);
+    if (rc == 0 && rename(tmp, dst) == 0) return unlink(src);
+    unlink(tmp);
+    return -1;
+}
+
+static int flush_rollup(const char *store, metric_t *v, size_t *n) {
+    int rc = tsdb_rollup(store, 1, v, *n);
+    *n = 0;
+    return rc;
+}
+
+// Reads a compressed text or binary segment back and rolls it up into tier 1.
+static int rollup_archive(const char *path, bool binary, const char *store) {
+    gzFile gz = gzopen(path, "rb");
+    if (!gz) return -1;
+    gzbuffer(gz, ARCHIVE_BUF);
+    metric_t *v = malloc(ROLLUP_BATCH * sizeof(*v));
+    uint8_t *block = malloc(BINLOG_BLOCK_SIZE);
+    int rc = v && block ? 0 : -1;
+    size_t n = 0;
+    if (binary) {
+        while (rc == 0 && gzread(gz, block, BINLOG_BLOCK_SIZE) == BINLOG_BLOCK_SIZE) {
+            if (n + BINLOG_MAX_PER_BLOCK > ROLLUP_BATCH) rc = flush_rollup(store, v, &n);
+            int k = binlog_decode_block(block, v + n, BINLOG_MAX_PER_BLOCK);
+            if (k > 0) n += (size_t)k; // a torn block is skipped, as binlog_decode does
+        }
+    } else {
+        char line[METRIC_LINE_MAX];
+        while (rc == 0 && gzgets(gz, line, sizeof(line))) {
+            if (metric_parse_csv(line, &v[n]) == 0 && ++n == ROLLUP_BATCH) rc = flush_rollup(store, v, &n);
+        }
+    }
+    if (rc == 0 && n > 0) rc = flush_rollup(store, v, &n);
+    gzclose(gz);
+    free(block);
+    free(v);
+    return rc;
+}
+
+static bool segment_path(const log_name_t *ln, const char *name, char *path) {
+    return snprintf(path, PATH_MAX, "%s/%s", ln->dir, name) < PATH_MAX;
+}
+
+// A segment's rollup commits as a whole. Before it starts, PATH.tsdb/rollup.pending
+// records the segment's name and where tier 1 ends (tsdb_tier_mark); it goes once the
+// segment is deleted. A rollup that failed, or that a crash cut short, is rewound to
+// that mark before the segment is rolled again, so none of its samples count twice.
+static bool pending_path(const log_name_t *ln, char *path) {
+    return snprintf(path, PATH_MAX, "%s/" ROLLUP_PENDING, ln->store) < PATH_MAX;
+}
+
+static int rollup_begin(const log_name_t *ln, const char *name) {
+    char path[PATH_MAX], tmp[PATH_MAX + 4];
+    tsdb_mark_t m;
+    if (!pending_path(ln, path)) { errno = ENAMETOOLONG; return -1; }
+    if (tsdb_tier_mark(ln->store, 1, &m) != 0) return -1;
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) return -1;
+    int rc = fprintf(f, "%u %" PRIu64 " %s\n", m.seg, m.count, name) < 0 ? -1 : 0;
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) rc = -1;
+    if (fclose(f) != 0) rc = -1;
+    if (rc == 0 && rename(tmp, path) == 0) return 0;
+    unlink(tmp);
+    return -1;
+}
+
+// Undoes an unfinished rollup whose segment is still there to be rolled again (one
+// whose segment is gone had finished). 0 once nothing is pending.
+static int rollup_undo(const log_name_t *ln) {
+    char path[PATH_MAX], name[NAME_MAX + 1], seg[PATH_MAX];
+    if (!pending_path(ln, path)) return 0; // rollup_begin never got this far
+    FILE *f = fopen(path, "r");
+    if (!f) return errno == ENOENT ? 0 : -1;
+    tsdb_mark_t m;
+    bool ok = fscanf(f, "%u %" SCNu64 " %255[^\n]", &m.seg, &m.count, name) == 3;
+    fclose(f);
+    if (ok && segment_path(ln, name, seg) && access(seg, F_OK) == 0 && tsdb_tier_rewind(ln->store, 1, &m) != 0)
+        return -1;
+    return unlink(path);
+}
+
+// Locks dir for this pass; -1 if another process holds it.
+static int lock_dir(const char *dir) {
+    int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) != 0) { close(fd); fd = -1; }
+    return fd;
+}
+
+static int archive_log(const log_name_t *ln, unsigned int keep, uint8_t *bufs, _Atomic bool *abort) {
+    int lock = lock_dir(ln->dir);
+    if (lock < 0) return 0;
+    char **names;
+    int n = list_segments(ln, &names), done = 0;
+    int gz = 0;
+    for (int i = 0; i < n; i++) {
+        char path[PATH_MAX];
+        if (segment_kind(ln, names[i]) == 1) { gz++; continue; }
+        if (!segment_path(ln, names[i], path) || gzip_file(path, bufs, bufs + ARCHIVE_BUF, abort) != 0) {
+            if (!abort || !atomic_load(abort)) perror(path);
+            break;
+        }
+        char *named = malloc(strlen(names[i]) + 4);
+        if (named) { sprintf(named, "%s.gz", names[i]); free(names[i]); names[i] = named; }
+        gz++;
+        done++;
+    }
+    // Until an unfinished rollup is undone, the store is left as it is.
+    bool clean = ln->store[0] && rollup_undo(ln) == 0;
+    if (ln->store[0] && !clean) perror(ln->store);
+    // Names sort by their stamp, so the first compressed ones are the oldest.
+    if (gz > (int)keep && (!clean || (mkdir(ln->store, 0755) != 0 && errno != EEXIST))) gz = 0;
+    for (int i = 0; i < n && gz > (int)keep && !(abort && atomic_load(abort)); i++) {
+        if (segment_kind(ln, names[i]) != 1) continue;
+        char path[PATH_MAX];
+        if (!segment_path(ln, names[i], path) || rollup_begin(ln, names[i]) != 0) { perror(path); break; }
+        if (rollup_archive(path, ln->binary, ln->store) != 0 || unlink(path) != 0) {
+            perror(path);
+            clean = rollup_undo(ln) == 0;
+            break;
+        }
+        char pending[PATH_MAX];
+        if (pending_path(ln, pending)) unlink(pending);
+        gz--;
+        done++;
+    }
+    for (int i = 0; i < n; i++) free(names[i]);
+    free(names);
+    int retired = clean ? tsdb_compact(ln->store, TSDB_TIER_MAX_SEGMENTS) : 0;
+    if (retired > 0) done += retired;
+    close(lock);
+    return done;
+}
+
+static int archive_pass(const monitor_config_t *cfg, _Atomic bool *abort) {
+    log_name_t ln[2];
+    const char *tsdb_dir;
+    live_logs(cfg, ln, &tsdb_dir);
+    uint8_t *bufs = malloc(2 * ARCHIVE_BUF);
+    if (!bufs) return -1;
+    int done = 0;
+    for (int i = 0; i < 2 && !(abort && atomic_load(abort)); i++) done += archive_log(&ln[i], cfg->log_keep, bufs, abort);
+    free(bufs);
+    int lock = lock_dir(tsdb_dir);
+    if (lock >= 0) {
+        int retired = tsdb_compact(tsdb_dir, cfg->log_segments);
+        if (retired > 0) done += retired;
+        close(lock);
+    }
+    return done;
+}
+
+static void *archive_thread(void *arg) {
+    log_archive_t *a = arg;
+    SELF_THREAD("archive");
+    struct sched_param sp = { .sched_priority = 0 };
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &sp);
+    syscall(SYS_ioprio_set, 1 /* IOPRIO_WHO_PROCESS: this thread */, 0, IOPRIO_IDLE);
+    pthread_mutex_lock(&a->lock);
+    while (!a->stop) {
+        a->pending = false;
+        monitor_config_t cfg = a->cfg;
+        pthread_mutex_unlock(&a->lock);
+        archive_pass(&cfg, &a->abort);
+        pthread_mutex_lock(&a->lock);
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += ARCHIVE_PERIOD_S;
+        while (!a->pending && !a->stop)
+            if (pthread_cond_timedwait(&a->cond, &a->lock, &deadline) == ETIMEDOUT) break;
+    }
+    pthread_mutex_unlock(&a->lock);
+    return NULL;
+}
+
+log_archive_t *log_archive_start(const monitor_config_t *cfg) {
+    log_archive_t *a = calloc(1, sizeof(*a));
+    if (!a) return NULL;
+    a->cfg = *cfg;
+    pthread_mutex_init(&a->lock, NULL);
+    pthread_cond_init(&a->cond, NULL);
+    int err = pthread_create(&a->thread, NULL, archive_thread, a);
+    if (err != 0) {
+        pthread_cond_destroy(&a->cond);
+        pthread_mutex_destroy(&a->lock);
+        free(a);
+        errno = err;
+        return NULL;
+    }
+    return a;
+}
+
+void log_archive_notify(log_archive_t *a) {
+    if (!a) return;
+    pthread_mutex_lock(&a->lock);
+    a->pending = true;
+    pthread_cond_signal(&a->cond);
+    pthread_mutex_unlock(&a->lock);
+}
+
+void log_archive_configure(log_archive_t *a, const monitor_config_t *cfg) {
+    if (!a) return;
+    pthread_mutex_lock(&a->lock);
+    a->cfg.log_keep = cfg->log_keep;
+    a->cfg.log_segments = cfg->log_segments;
+    pthread_mutex_unlock(&a->lock);
+}
+
+void log_archive_stop(log_archive_t *a) {
+    if (!a) return;
+    pthread_mutex_lock(&a->lock);
+    a->stop = true;
+    atomic_store(&a->abort, true);
+    pthread_cond_signal(&a->cond);
+    pthread_mutex_unlock(&a->lock);
+    pthread_join(a->thread, NULL);
+    pthread_cond_destroy(&a->cond);
+    pthread_mutex_destroy(&a->lock);
+    free(a);
+}
+
+int log_archive_run(const monitor_config_t *cfg, bool rotate_live) {
+    if (rotate_live && cfg->log_rotate_mb) {
+        const char *paths[] = {
+            cfg->log_format == LOG_TEXT && cfg->log_path ? cfg->log_path : TEXT_LOG_PATH,
+            cfg->log_format == LOG_BINARY && cfg->log_path ? cfg->log_path : BINARY_LOG_PATH,
+        };
+        for (int i = 0; i < 2; i++) {
+            struct stat st;
+            char rotated[PATH_MAX];
+            if (stat(paths[i], &st) == 0 && (uint64_t)st.st_size >= (uint64_t)cfg->log_rotate_mb << 20 &&
+                log_archive_rotate(paths[i], rotated, sizeof(rotated)) != 0)
+                perror(paths[i]);
+        }
+    }
+    return archive_pass(cfg, NULL);
+}
@@ -0,0 +1,129 @@
+#define _GNU_SOURCE
+#include "log_sink.h"
+#include "binlog.h"
+#include "log_archive.h"
+#include "metric_format.h"
+#include "tsdb.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static int text_open(const char *path, uint64_t *bytes) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd >= 0) *bytes = fstat(fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+    return fd;
+}
+
+int log_sink_open(log_sink_t *s, const monitor_config_t *cfg) {
+    s->text_fd = -1; s->text_buf = NULL; s->text_len = 0; s->bin = NULL; s->tsdb = NULL;
+    s->sync_ms = cfg->log_flush_ms; s->last_sync = now_ms();
+    s->text_bytes = 0; s->opened_ms = now_ms(); s->archive = NULL; s->path = NULL;
+    s->rotate_bytes = (uint64_t)cfg->log_rotate_mb << 20; s->rotate_ms = (uint64_t)cfg->log_rotate_s * 1000;
+    s->flush_ms = cfg->log_flush_ms; s->direct = cfg->log_direct;
+    if (cfg->log_format == LOG_TSDB) {
+        // With the archiver running, raw segments are rolled up by tsdb_compact rather
+        // than deleted by the store.
+        s->tsdb = tsdb_open(cfg->log_path ? cfg->log_path : TSDB_DEFAULT_DIR, TSDB_DEFAULT_SEGMENT_BYTES,
+                            cfg->log_archive ? TSDB_KEEP_ALL : cfg->log_segments ? cfg->log_segments : TSDB_DEFAULT_MAX_SEGMENTS);
+        if (!s->tsdb) { perror("tsdb_open"); return -1; }
+    } else if (cfg->log_format == LOG_BINARY) {
+        s->path = cfg->log_path ? cfg->log_path : BINARY_LOG_PATH;
+        s->bin = binlog_open(s->path, cfg->log_flush_ms, cfg->log_direct);
+        if (!s->bin) { perror("binlog_open"); return -1; }
+    } else {
+        s->path = cfg->log_path ? cfg->log_path : TEXT_LOG_PATH;
+        s->text_fd = text_open(s->path, &s->text_bytes);
+        if (s->text_fd < 0) { perror("open log"); return -1; }
+        if (!(s->text_buf = malloc(TEXT_LOG_BUF))) { perror("malloc"); close(s->text_fd); s->text_fd = -1; return -1; }
+    }
+    if (cfg->log_archive && !(s->archive = log_archive_start(cfg))) perror("log_archive_start"); // logging goes on without it
+    return 0;
+}
+
+static void text_write(log_sink_t *s) {
+    size_t off = 0;
+    while (off < s->text_len) {
+        ssize_t n = write(s->text_fd, s->text_buf + off, s->text_len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) { perror("write log"); break; } // the lines are dropped, as fwrite would
+        off += (size_t)n;
+    }
+    s->text_bytes += off;
+    s->text_len = 0;
+}
+
+void log_sink_metric(log_sink_t *s, const metric_t *m) {
+    if (s->tsdb) { tsdb_append(s->tsdb, m); return; }
+    if (s->bin) { binlog_append(s->bin, m); return; }
+    if (!s->text_buf) return;
+    if (TEXT_LOG_BUF - s->text_len < METRIC_LINE_MAX) text_write(s);
+    s->text_len += (size_t)metric_format_csv(s->text_buf + s->text_len, TEXT_LOG_BUF - s->text_len, m);
+}
+
+void log_sink_alert(log_sink_t *s, const metric_t *alert) {
+    if (s->bin) return;
+    log_sink_metric(s, alert);
+}
+
+// Renames the live log away and starts a new one at the same path. The binary log is
+// closed first so its open block is written out whole; the text log swaps fds. If the
+// new file cannot be opened the old one is renamed back and rotation is turned off,
+// as it is when the rename itself fails, rather than retried on every batch.
+static void rotate(log_sink_t *s) {
+    char rotated[PATH_MAX];
+    if (s->bin) {
+        binlog_close(s->bin);
+        bool moved = log_archive_rotate(s->path, rotated, sizeof(rotated)) == 0;
+        if (!moved) perror("rotate log");
+        s->bin = binlog_open(s->path, s->flush_ms, s->direct);
+        if (!s->bin && moved) {
+            perror("binlog_open");
+            moved = false;
+            if (rename(rotated, s->path) == 0) s->bin = binlog_open(s->path, s->flush_ms, s->direct);
+        }
+        if (!moved) s->rotate_bytes = s->rotate_ms = 0;
+        if (!s->bin) { perror("binlog_open"); return; } // metrics are dropped from here on
+        if (!moved) return;
+    } else {
+        if (log_archive_rotate(s->path, rotated, sizeof(rotated)) != 0) { perror("rotate log"); s->rotate_bytes = s->rotate_ms = 0; return; }
+        uint64_t bytes;
+        int fd = text_open(s->path, &bytes);
+        if (fd < 0) {
+            perror("open log");
+            rename(rotated, s->path); // keep writing the old file under its live name
+            s->rotate_bytes = s->rotate_ms = 0;
+            return;
+        }
+        close(s->text_fd);
+        s->text_fd = fd;
+        s->text_bytes = bytes;
+    }
+    s->opened_ms = now_ms();
+    log_archive_notify(s->archive);
+}
+
+void log_sink_flush(log_sink_t *s) {
+    if (s->bin) binlog_tick(s->bin, now_ms());
+    else if (s->text_fd >= 0) text_write(s);
+    else if (s->tsdb && now_ms() - s->last_sync >= s->sync_ms) { s->last_sync = now_ms(); tsdb_sync(s->tsdb); }
+    if (!s->bin && s->text_fd < 0) return;
+    uint64_t size = s->bin ? binlog_size(s->bin) : s->text_bytes;
+    if ((s->rotate_bytes && size >= s->rotate_bytes) || (s->rotate_ms && size && now_ms() - s->opened_ms >= s->rotate_ms)) rotate(s);
+}
+
+void log_sink_close(log_sink_t *s) {
+    log_archive_stop(s->archive);
+    if (s->tsdb) tsdb_close(s->tsdb);
+    if (s->bin) binlog_close(s->bin);
+    if (s->text_fd >= 0) {
+        text_write(s);
+        close(s->text_fd);
+    }
+    free(s->text_buf);
+}
@@ -8,7 +8,7 @@ static void menu() {
     std::cout << "1. Start Monitor\n";
     std::cout << "2. Run Scheduler (FCFS demo)\n";
     std::cout << "3. Generate Report\n";
-    std::cout << "4. Cleanup Logs\n";
+    std::cout << "4. Compact Logs\n";
     std::cout << "5. Exit\n> ";
 }
 
@@ -26,8 +26,8 @@ int main(){
             std::cout << "Generating report...\n";
             std::system("bash scripts/generate_report.sh");
         } else if (ch==4) {
-            std::cout << "Cleanup logs...\n";
-            std::system("bash scripts/cleanup_logs.sh 5");
+            std::cout << "Compacting logs...\n";
+            std::system("./bin/monitor --compact");
         } else if (ch==5) {
             break;
         }
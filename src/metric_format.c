@@ -0,0 +1,248 @@
+#define _GNU_SOURCE
+#include "metric_format.h"
+#include "dev_stats.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+const char *metric_kind_name(metric_kind_t kind) {
+    switch (kind) {
+        case METRIC_CPU: return "CPU";
+        case METRIC_MEM: return "MEM";
+        case METRIC_DISK: return "DISK";
+        case METRIC_NET: return "NET";
+        case METRIC_CPU_CORE: return "CPU_CORE";
+        case METRIC_CPU_CORE_WAIT: return "CPU_CORE_WAIT";
+        case METRIC_ALERT: return "ALERT";
+        case METRIC_PROC_CPU: return "PROC_CPU";
+        case METRIC_PROC_RSS: return "PROC_RSS";
+        case METRIC_PROC_IO: return "PROC_IO";
+        case METRIC_SELF: return "SELF";
+        case METRIC_DISK_DEV: return "DISK_DEV";
+        case METRIC_NET_DEV: return "NET_DEV";
+        case METRIC_PSI_CPU: return "PSI_CPU";
+        case METRIC_PSI_MEM: return "PSI_MEM";
+        case METRIC_PSI_IO: return "PSI_IO";
+        case METRIC_CGROUP_CPU: return "CGROUP_CPU";
+        case METRIC_CGROUP_MEM: return "CGROUP_MEM";
+        case METRIC_CGROUP_IO: return "CGROUP_IO";
+        default: return NULL;
+    }
+}
+
+int metric_kind_from_name(const char *name) {
+    for (int k = 0; k < METRIC_KIND_COUNT; k++) {
+        const char *n = metric_kind_name((metric_kind_t)k);
+        if (n && strcasecmp(n, name) == 0) return k;
+    }
+    return -1;
+}
+
+// ---- Fixed-point output ----
+//
+// The log carries a few shapes of number, so lines are built by hand instead of
+// through snprintf: no format string to parse, no locale, no stdio. put_fixed prints
+// exactly what "%.*f" would (see there); the rare values it cannot do exactly fall back
+// to snprintf.
+
+typedef struct { char *p, *end; } out_t;
+
+static void put_str(out_t *o, const char *s) {
+    while (*s && o->p < o->end) *o->p++ = *s++;
+    if (*s) o->p = o->end + 1; // overflowed; metric_format_csv returns 0
+}
+
+static void put_u64(out_t *o, uint64_t v) {
+    char tmp[20];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    if (o->end - o->p < n) { o->p = o->end + 1; return; }
+    while (n) *o->p++ = tmp[--n];
+}
+
+// |v| * 10^dec is computed with one rounded multiply. Below 2^52 every x.5 is
+// representable, so the product lands on the same side of each rounding boundary as
+// the exact value, and rint (round half to even, like printf) picks the digit printf
+// does; only a product of exactly x.5 is ambiguous, and goes to snprintf, as do
+// NaN, infinities and anything too large.
+static void put_fixed(out_t *o, double v, int dec) {
+    static const uint64_t scale[] = { 1, 10, 100 };
+    if (o->p > o->end) return;
+    double a = fabs(v) * (double)scale[dec];
+    if (!(a < 4503599627370496.0) || (dec > 0 && a - floor(a) == 0.5)) {
+        size_t cap = o->p <= o->end ? (size_t)(o->end - o->p) : 0;
+        int n = snprintf(o->p, cap + 1, "%.*f", dec, v);
+        o->p = (n < 0 || (size_t)n > cap) ? o->end + 1 : o->p + n;
+        return;
+    }
+    uint64_t u = (uint64_t)rint(a);
+    if (signbit(v)) put_str(o, "-");
+    put_u64(o, u / scale[dec]);
+    if (!dec) return;
+    if (o->end - o->p < dec + 1) { o->p = o->end + 1; return; }
+    *o->p++ = '.';
+    uint64_t f = u % scale[dec];
+    for (int i = dec - 1; i >= 0; i--) { o->p[i] = (char)('0' + f % 10); f /= 10; }
+    o->p += dec;
+}
+
+static void put_pair(out_t *o, const metric_t *m, int dec) {
+    put_str(o, ",");
+    put_fixed(o, m->v1, dec);
+    put_str(o, ",");
+    put_fixed(o, m->v2, dec);
+}
+
+int metric_format_csv(char *buf, size_t cap, const metric_t *m) {
+    if (cap == 0) return 0;
+    out_t o = { buf, buf + cap - 1 }; // room for the terminating NUL
+    const char *name = metric_kind_name(m->kind);
+    if (!name) return 0;
+    put_u64(&o, m->ts_ms);
+    put_str(&o, ",");
+    put_str(&o, name);
+    switch (m->kind) {
+        case METRIC_CPU:
+        case METRIC_MEM:
+            put_str(&o, ",");
+            put_fixed(&o, m->v1, 2);
+            break;
+        case METRIC_DISK:
+        case METRIC_NET:
+            put_pair(&o, m, 0);
+            break;
+        case METRIC_CPU_CORE:
+        case METRIC_CPU_CORE_WAIT:
+        case METRIC_CGROUP_CPU:
+            put_str(&o, ",");
+            put_u64(&o, m->id);
+            put_pair(&o, m, 2);
+            break;
+        case METRIC_PROC_CPU:
+            put_str(&o, ",");
+            put_u64(&o, m->id);
+            put_str(&o, ",");
+            put_fixed(&o, m->v1, 2);
+            break;
+        case METRIC_PROC_RSS:
+        case METRIC_CGROUP_MEM:
+            put_str(&o, ",");
+            put_u64(&o, m->id);
+            put_str(&o, ",");
+            put_fixed(&o, m->v1, 0);
+            break;
+        case METRIC_PROC_IO:
+        case METRIC_NET_DEV:
+        case METRIC_CGROUP_IO:
+            put_str(&o, ",");
+            put_u64(&o, m->id);
+            put_pair(&o, m, 0);
+            break;
+        case METRIC_DISK_DEV:
+            put_str(&o, ",");
+            put_u64(&o, DEV_MAJOR(m->id));
+            put_str(&o, ":");
+            put_u64(&o, DEV_MINOR(m->id));
+            put_pair(&o, m, 0);
+            break;
+        case METRIC_PSI_CPU:
+        case METRIC_PSI_MEM:
+        case METRIC_PSI_IO:
+            put_pair(&o, m, 2);
+            break;
+        case METRIC_SELF:
+            put_str(&o, ",");
+            put_u64(&o, m->id);
+            put_str(&o, ",");
+            put_fixed(&o, m->v1, 1);
+            put_str(&o, ",");
+            put_fixed(&o, m->v2, 1);
+            break;
+        case METRIC_ALERT: {
+            const char *what = metric_kind_name((metric_kind_t)m->id);
+            put_str(&o, ",");
+            put_str(&o, what ? what : "UNKNOWN");
+            put_str(&o, m->v2 != 0 ? "_CLEAR," : "_HIGH,");
+            put_fixed(&o, m->v1, 2);
+            break;
+        }
+        default: return 0;
+    }
+    if (m->interval_ms) {
+        put_str(&o, ",");
+        put_u64(&o, m->interval_ms);
+    }
+    put_str(&o, "\n");
+    if (o.p > o.end) return 0;
+    *o.p = '\0';
+    return (int)(o.p - buf);
+}
+
+// Kinds whose lines carry an id after the kind name.
+static bool has_id(metric_kind_t kind) {
+    switch (kind) {
+        case METRIC_CPU_CORE: case METRIC_CPU_CORE_WAIT: case METRIC_CGROUP_CPU:
+        case METRIC_PROC_CPU: case METRIC_PROC_RSS: case METRIC_CGROUP_MEM:
+        case METRIC_PROC_IO: case METRIC_NET_DEV: case METRIC_CGROUP_IO:
+        case METRIC_DISK_DEV: case METRIC_SELF:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Kinds whose lines carry v2 as well as v1.
+static bool has_v2(metric_kind_t kind) {
+    switch (kind) {
+        case METRIC_CPU: case METRIC_MEM: case METRIC_PROC_CPU: case METRIC_PROC_RSS:
+        case METRIC_CGROUP_MEM: case METRIC_ALERT:
+            return false;
+        default:
+            return true;
+    }
+}
+
+int metric_parse_csv(const char *line, metric_t *out) {
+    char *p, name[32];
+    *out = (metric_t){0};
+    out->ts_ms = strtoull(line, &p, 10);
+    if (p == line || *p++ != ',') return -1;
+    size_t len = strcspn(p, ",\n");
+    if (len == 0 || len >= sizeof(name)) return -1;
+    memcpy(name, p, len);
+    name[len] = '\0';
+    int kind = metric_kind_from_name(name);
+    if (kind < 0 || p[len] != ',') return -1;
+    out->kind = (metric_kind_t)kind;
+    p += len + 1;
+    if (kind == METRIC_ALERT) {
+        // WHAT_HIGH or WHAT_CLEAR, where WHAT may itself contain underscores.
+        len = strcspn(p, ",\n");
+        if (len >= sizeof(name) || p[len] != ',') return -1;
+        memcpy(name, p, len);
+        name[len] = '\0';
+        char *suffix = strrchr(name, '_');
+        if (!suffix) return -1;
+        *suffix++ = '\0';
+        int what = metric_kind_from_name(name);
+        if (what < 0 || (strcmp(suffix, "HIGH") != 0 && strcmp(suffix, "CLEAR") != 0)) return -1;
+        out->id = (uint32_t)what;
+        out->v2 = suffix[0] == 'C';
+        p += len + 1;
+    } else if (has_id(out->kind)) {
+        char *end;
+        unsigned long id = strtoul(p, &end, 10);
+        if (end == p) return -1;
+        if (kind == METRIC_DISK_DEV && *end == ':') id = DEV_KEY(id, strtoul(end + 1, &end, 10));
+        if (*end != ',') return -1;
+        out->id = (uint32_t)id;
+        p = end + 1;
+    }
+    out->v1 = strtod(p, &p);
+    if (has_v2(out->kind) && *p == ',') out->v2 = strtod(p + 1, &p);
+    if (*p == ',') out->interval_ms = (uint32_t)strtoul(p + 1, &p, 10);
+    return *p == '\0' || *p == '\n' ? 0 : -1;
+}
@@ -0,0 +1,158 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "selfstat.h"
+
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+_Static_assert((QUEUE_CAP & (QUEUE_CAP - 1)) == 0, "QUEUE_CAP must be a power of two");
+#define QUEUE_MASK ((uint64_t)QUEUE_CAP - 1)
+#define MQ_SPIN_BEFORE_PARK 64 // empty polls before the consumer sleeps on the futex
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+static void futex_wait(_Atomic uint32_t *addr, uint32_t expected) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *addr, int n) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+void mq_init(metric_queue_t *q) {
+    atomic_init(&q->head, 0);
+    q->tail = 0;
+    atomic_init(&q->items_seq, 0);
+    atomic_init(&q->consumer_parked, 0);
+    atomic_init(&q->space_seq, 0);
+    atomic_init(&q->producers_parked, 0);
+    atomic_init(&q->closed, false);
+    for (uint64_t i = 0; i < QUEUE_CAP; i++) atomic_init(&q->buf[i].seq, i);
+}
+
+void mq_destroy(metric_queue_t *q) {
+    (void)q;
+}
+
+void mq_shutdown(metric_queue_t *q) {
+    atomic_store(&q->closed, true);
+    atomic_fetch_add(&q->items_seq, 1);
+    atomic_fetch_add(&q->space_seq, 1);
+    futex_wake(&q->items_seq, INT_MAX);
+    futex_wake(&q->space_seq, INT_MAX);
+}
+
+// Claims a slot; returns NULL if the ring is full at the observed head.
+static mq_slot_t *try_claim(metric_queue_t *q, uint64_t *pos_out) {
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    for (;;) {
+        mq_slot_t *s = &q->buf[pos & QUEUE_MASK];
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - pos);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *pos_out = pos;
+                return s;
+            }
+        } else if (dif < 0) {
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+}
+
+bool mq_push(metric_queue_t *q, const metric_t *m) {
+    uint64_t pos;
+    mq_slot_t *s;
+    if (atomic_load_explicit(&q->closed, memory_order_relaxed)) return false;
+    if (!(s = try_claim(q, &pos))) {
+        SELF_COUNT(SELF_C_PUSH_BLOCKED);
+        SELF_TIME_START(blocked);
+        do {
+            if (atomic_load(&q->closed)) return false;
+            // Full: park until the consumer frees a slot. The re-check after announcing
+            // ourselves closes the race with a concurrent pop: the fence pairs with the one
+            // in wake_producers, so either the pop sees the flag or the re-check sees the
+            // freed slot.
+            uint32_t v = atomic_load(&q->space_seq);
+            atomic_store(&q->producers_parked, 1);
+            atomic_thread_fence(memory_order_seq_cst);
+            if ((s = try_claim(q, &pos))) break;
+            if (!atomic_load(&q->closed)) futex_wait(&q->space_seq, v);
+        } while (!(s = try_claim(q, &pos)));
+        SELF_TIME_END(SELF_H_PUSH_WAIT, blocked);
+    }
+    s->m = *m;
+    SELF_STAMP(s->pushed_ns);
+    atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    // Only the first producer to see the parked consumer pays for the wake syscall.
+    if (atomic_load_explicit(&q->consumer_parked, memory_order_relaxed) &&
+        atomic_exchange(&q->consumer_parked, 0)) {
+        SELF_COUNT(SELF_C_PUSH_WAKE);
+        atomic_fetch_add(&q->items_seq, 1);
+        futex_wake(&q->items_seq, 1);
+    }
+    return true;
+}
+
+// Takes the slot at tail if it is published; the caller then runs wake_producers.
+static bool take(metric_queue_t *q, metric_t *out) {
+    mq_slot_t *s = &q->buf[q->tail & QUEUE_MASK];
+    uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+    if (seq != q->tail + 1) return false;
+    *out = s->m;
+    SELF_TIME_END(SELF_H_QUEUE, s->pushed_ns);
+    atomic_store_explicit(&s->seq, q->tail + QUEUE_CAP, memory_order_release);
+    q->tail++;
+    return true;
+}
+
+static void wake_producers(metric_queue_t *q) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&q->producers_parked, memory_order_relaxed) &&
+        atomic_exchange(&q->producers_parked, 0)) {
+        atomic_fetch_add(&q->space_seq, 1);
+        futex_wake(&q->space_seq, INT_MAX);
+    }
+}
+
+static bool try_take(metric_queue_t *q, metric_t *out) {
+    if (!take(q, out)) return false;
+    wake_producers(q);
+    return true;
+}
+
+bool mq_pop(metric_queue_t *q, metric_t *out) {
+    for (;;) {
+        for (int spin = 0; spin < MQ_SPIN_BEFORE_PARK; spin++) {
+            if (try_take(q, out)) return true;
+            cpu_relax();
+        }
+        if (atomic_load(&q->closed)) return false;
+        uint32_t v = atomic_load(&q->items_seq);
+        atomic_store(&q->consumer_parked, 1);
+        atomic_thread_fence(memory_order_seq_cst); // pairs with the fence in mq_push
+        if (try_take(q, out)) { atomic_store(&q->consumer_parked, 0); return true; }
+        if (atomic_load(&q->closed)) { atomic_store(&q->consumer_parked, 0); return false; }
+        SELF_COUNT(SELF_C_CONSUMER_PARK);
+        futex_wait(&q->items_seq, v);
+        atomic_store(&q->consumer_parked, 0);
+    }
+}
+
+size_t mq_pop_batch(metric_queue_t *q, metric_t *out, size_t max) {
+    if (max == 0 || !mq_pop(q, out)) return 0;
+    size_t n = 1;
+    while (n < max && take(q, &out[n])) n++;
+    if (n > 1) wake_producers(q); // one fence and parked check for the whole batch
+    return n;
+}
@@ -0,0 +1,525 @@
+#define _GNU_SOURCE
+#include "metrics_server.h"
+#include "dev_stats.h"
+#include "metric_format.h"
+#include "selfstat.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define EV_LISTEN (UINT32_MAX - 1)
+#define EV_STOP UINT32_MAX
+#define CONN_IN 512 // one binary request, or an HTTP request head (the rest is ignored)
+
+// A response; the cached snapshot and exposition are shared by every connection
+// still sending them, range answers have one owner.
+typedef struct {
+    int refs;
+    size_t len, cap;
+    char data[];
+} buf_t;
+
+typedef struct {
+    int fd;              // -1 when the slot is free
+    bool http;
+    size_t in_len;
+    char in[CONN_IN];
+    buf_t *out;          // being sent, from out_off
+    size_t out_off;
+    bool close_after;
+    bool want_out;       // watched for EPOLLOUT rather than EPOLLIN
+} conn_t;
+
+typedef struct {
+    uint64_t key; // kind << 32 | id
+    shm_sample_t s;
+} series_t;
+
+struct metrics_server {
+    const shm_metrics_t *shm;
+    char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    int lfd, ep, stop_fd;
+    pthread_t th;
+    // Latest sample per series, sorted by key, with an open-addressing index.
+    uint64_t cursor[METRIC_KIND_COUNT];
+    series_t *series;
+    int nseries, capseries;
+    int32_t *index;
+    uint32_t index_mask;
+    uint64_t expired_ms;
+    // Responses for `gen`.
+    bool built;
+    uint32_t gen;
+    buf_t *snap, *prom;
+    conn_t conns[MSRV_MAX_CLIENTS];
+    int free_conns[MSRV_MAX_CLIENTS], nfree;
+};
+
+// ---- Buffers ----
+
+static buf_t *buf_new(size_t cap) {
+    buf_t *b = malloc(sizeof(*b) + cap);
+    if (!b) return NULL;
+    b->refs = 1;
+    b->len = 0;
+    b->cap = cap;
+    return b;
+}
+
+static void buf_unref(buf_t *b) {
+    if (b && --b->refs == 0) free(b);
+}
+
+static bool buf_reserve(buf_t **bp, size_t more) {
+    buf_t *b = *bp;
+    if (b->len + more <= b->cap) return true;
+    size_t cap = b->cap * 2 > b->len + more ? b->cap * 2 : b->len + more;
+    buf_t *nb = realloc(b, sizeof(*b) + cap);
+    if (!nb) return false;
+    nb->cap = cap;
+    *bp = nb;
+    return true;
+}
+
+// ---- Series table ----
+
+static uint32_t key_hash(uint64_t key) {
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(key >> 32);
+}
+
+static void reindex(metrics_server_t *srv) {
+    for (uint32_t i = 0; i <= srv->index_mask; i++) srv->index[i] = -1;
+    for (int s = 0; s < srv->nseries; s++) {
+        uint32_t i = key_hash(srv->series[s].key) & srv->index_mask;
+        while (srv->index[i] >= 0) i = (i + 1) & srv->index_mask;
+        srv->index[i] = s;
+    }
+}
+
+static int cmp_series(const void *a, const void *b) {
+    uint64_t x = ((const series_t *)a)->key, y = ((const series_t *)b)->key;
+    return (x > y) - (x < y);
+}
+
+// The index cell holding `key`, or the empty one where it would go.
+static int32_t *find(metrics_server_t *srv, uint64_t key) {
+    uint32_t i = key_hash(key) & srv->index_mask;
+    while (srv->index[i] >= 0 && srv->series[srv->index[i]].key != key) i = (i + 1) & srv->index_mask;
+    return &srv->index[i];
+}
+
+// Returns true if the series is new (the table then needs sorting).
+static bool upsert(metrics_server_t *srv, metric_kind_t kind, const shm_sample_t *s) {
+    uint64_t key = (uint64_t)kind << 32 | s->id;
+    int32_t *cell = srv->index ? find(srv, key) : NULL;
+    if (cell && *cell >= 0) { srv->series[*cell].s = *s; return false; }
+    if (srv->nseries == srv->capseries) {
+        int cap = srv->capseries ? 2 * srv->capseries : 256;
+        series_t *ns = realloc(srv->series, (size_t)cap * sizeof(*ns));
+        if (ns) srv->series = ns;
+        int32_t *ni = ns ? malloc((size_t)cap * 2 * sizeof(*ni)) : NULL;
+        if (!ni) return false; // dropped until memory frees up
+        free(srv->index);
+        srv->capseries = cap;
+        srv->index = ni;
+        srv->index_mask = (uint32_t)cap * 2 - 1;
+        reindex(srv);
+        cell = find(srv, key);
+    }
+    *cell = srv->nseries;
+    srv->series[srv->nseries++] = (series_t){ key, *s };
+    return true;
+}
+
+// Pulls what the monitor published since the last call into the series table.
+static void pull(metrics_server_t *srv, uint64_t now) {
+    shm_sample_t got[SHM_RING_LEN];
+    bool changed = false;
+    for (int k = 0; k < METRIC_KIND_COUNT; k++) {
+        size_t n = shm_metrics_read(srv->shm, (metric_kind_t)k, &srv->cursor[k], got, SHM_RING_LEN);
+        for (size_t i = 0; i < n; i++) changed |= upsert(srv, (metric_kind_t)k, &got[i]);
+    }
+    if (now - srv->expired_ms >= 1000) {
+        srv->expired_ms = now;
+        int w = 0;
+        for (int s = 0; s < srv->nseries; s++)
+            if (now < srv->series[s].s.ts_ms + MSRV_SERIES_TTL_MS) srv->series[w++] = srv->series[s];
+        changed |= w != srv->nseries;
+        srv->nseries = w;
+    }
+    if (!changed) return;
+    qsort(srv->series, (size_t)srv->nseries, sizeof(series_t), cmp_series);
+    reindex(srv);
+}
+
+// ---- Responses ----
+
+static void put_header(buf_t *b, uint8_t op, uint32_t count, uint32_t gen, uint64_t updated) {
+    msrv_response_t h = { .len = (uint32_t)(sizeof(h) - 4 + count * sizeof(msrv_record_t)), .op = op,
+                          .version = MSRV_VERSION, .count = count, .gen = gen, .updated_ms = updated };
+    memcpy(b->data, &h, sizeof(h));
+    b->len = sizeof(h);
+}
+
+static void put_record(buf_t *b, metric_kind_t kind, const shm_sample_t *s) {
+    msrv_record_t r = { .kind = (uint8_t)kind, .id = s->id, .ts_ms = s->ts_ms, .interval_ms = s->interval_ms,
+                        .v1 = s->v1, .v2 = s->v2 };
+    memcpy(b->data + b->len, &r, sizeof(r));
+    b->len += sizeof(r);
+}
+
+static buf_t *build_snapshot(const metrics_server_t *srv, uint64_t updated) {
+    buf_t *b = buf_new(sizeof(msrv_response_t) + (size_t)srv->nseries * sizeof(msrv_record_t));
+    if (!b) return NULL;
+    put_header(b, MSRV_SNAPSHOT, (uint32_t)srv->nseries, srv->gen, updated);
+    for (int s = 0; s < srv->nseries; s++) put_record(b, (metric_kind_t)(srv->series[s].key >> 32), &srv->series[s].s);
+    return b;
+}
+
+static buf_t *build_range(const metrics_server_t *srv, const msrv_request_t *rq, uint64_t updated) {
+    shm_sample_t got[SHM_RING_LEN];
+    uint64_t cursor = 0;
+    size_t n = rq->kind < METRIC_KIND_COUNT ? shm_metrics_read(srv->shm, (metric_kind_t)rq->kind, &cursor, got, SHM_RING_LEN) : 0;
+    buf_t *b = buf_new(sizeof(msrv_response_t) + n * sizeof(msrv_record_t));
+    if (!b) return NULL;
+    uint32_t count = 0;
+    b->len = sizeof(msrv_response_t);
+    for (size_t i = 0; i < n; i++) {
+        if (got[i].ts_ms < rq->from_ms || (rq->id != MSRV_ANY_ID && got[i].id != rq->id)) continue;
+        put_record(b, (metric_kind_t)rq->kind, &got[i]);
+        count++;
+    }
+    size_t len = b->len;
+    put_header(b, MSRV_RANGE, count, srv->gen, updated);
+    b->len = len;
+    return b;
+}
+
+static buf_t *build_error(void) {
+    buf_t *b = buf_new(sizeof(msrv_response_t));
+    if (b) put_header(b, MSRV_ERROR, 0, 0, 0);
+    return b;
+}
+
+// Prometheus names per kind: one gauge family for v1 and, where it means something,
+// one for v2, labelled with the series id. SELF and SUMMARY are not exported.
+typedef struct { const char *v1, *help1, *v2, *help2, *label; } prom_kind_t;
+
+static const prom_kind_t prom_kinds[METRIC_KIND_COUNT] = {
+    [METRIC_CPU] = { "sysmon_cpu_usage_percent", "CPU busy time over the last interval.", NULL, NULL, NULL },
+    [METRIC_MEM] = { "sysmon_memory_used_percent", "Memory in use.", NULL, NULL, NULL },
+    [METRIC_DISK] = { "sysmon_disk_read_sectors", "Sectors read by all disks over the last interval.",
+                      "sysmon_disk_written_sectors", "Sectors written by all disks over the last interval.", NULL },
+    [METRIC_NET] = { "sysmon_network_received_bytes", "Bytes received by all interfaces over the last interval.",
+                     "sysmon_network_sent_bytes", "Bytes sent by all interfaces over the last interval.", NULL },
+    [METRIC_CPU_CORE] = { "sysmon_core_user_percent", "Per-core user time.", "sysmon_core_system_percent", "Per-core system time.", "core" },
+    [METRIC_CPU_CORE_WAIT] = { "sysmon_core_iowait_percent", "Per-core iowait.", "sysmon_core_steal_percent", "Per-core steal.", "core" },
+    [METRIC_ALERT] = { "sysmon_alert_firing", "1 while the metric's threshold alert is raised.", NULL, NULL, "metric" },
+    [METRIC_PROC_CPU] = { "sysmon_process_cpu_percent", "Top-K processes by CPU.", NULL, NULL, "pid" },
+    [METRIC_PROC_RSS] = { "sysmon_process_resident_bytes", "Top-K processes by resident memory.", NULL, NULL, "pid" },
+    [METRIC_PROC_IO] = { "sysmon_process_read_bytes_per_second", "Top-K processes by I/O, reads.",
+                         "sysmon_process_write_bytes_per_second", "Top-K processes by I/O, writes.", "pid" },
+    [METRIC_DISK_DEV] = { "sysmon_device_read_sectors", "Sectors read per disk over the last interval.",
+                          "sysmon_device_written_sectors", "Sectors written per disk over the last interval.", "device" },
+    [METRIC_NET_DEV] = { "sysmon_interface_received_bytes", "Bytes received per interface over the last interval.",
+                         "sysmon_interface_sent_bytes", "Bytes sent per interface over the last interval.", "ifindex" },
+    [METRIC_PSI_CPU] = { "sysmon_pressure_cpu_some_percent", "Time some tasks stalled on CPU.",
+                         "sysmon_pressure_cpu_full_percent", "Time all tasks stalled on CPU.", NULL },
+    [METRIC_PSI_MEM] = { "sysmon_pressure_memory_some_percent", "Time some tasks stalled on memory.",
+                         "sysmon_pressure_memory_full_percent", "Time all tasks stalled on memory.", NULL },
+    [METRIC_PSI_IO] = { "sysmon_pressure_io_some_percent", "Time some tasks stalled on I/O.",
+                        "sysmon_pressure_io_full_percent", "Time all tasks stalled on I/O.", NULL },
+    [METRIC_CGROUP_CPU] = { "sysmon_cgroup_cpu_percent", "Per-cgroup CPU, % of one CPU.",
+                            "sysmon_cgroup_throttled_percent", "Per-cgroup time throttled by cpu.max.", "cgroup" },
+    [METRIC_CGROUP_MEM] = { "sysmon_cgroup_memory_bytes", "Per-cgroup memory.current.", NULL, NULL, "cgroup" },
+    [METRIC_CGROUP_IO] = { "sysmon_cgroup_read_bytes", "Per-cgroup bytes read over the last interval.",
+                           "sysmon_cgroup_written_bytes", "Per-cgroup bytes written over the last interval.", "cgroup" },
+};
+
+static bool put_text(buf_t **b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static bool put_text(buf_t **b, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf((*b)->data + (*b)->len, (*b)->cap - (*b)->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) return false;
+        if ((size_t)n < (*b)->cap - (*b)->len) { (*b)->len += (size_t)n; return true; }
+        if (!buf_reserve(b, (size_t)n + 1)) return false;
+    }
+}
+
+// The HTTP head goes in front once the body length is known.
+#define HTTP_HEAD_MAX 128
+
+static buf_t *build_prometheus(const metrics_server_t *srv) {
+    buf_t *b = buf_new(HTTP_HEAD_MAX + 4096 + (size_t)srv->nseries * 64);
+    if (!b) return NULL;
+    b->len = HTTP_HEAD_MAX;
+    bool ok = true;
+    for (int s = 0; s < srv->nseries && ok;) {
+        metric_kind_t kind = (metric_kind_t)(srv->series[s].key >> 32);
+        int end = s;
+        while (end < srv->nseries && (metric_kind_t)(srv->series[end].key >> 32) == kind) end++;
+        const prom_kind_t *pk = &prom_kinds[kind];
+        for (int v = 0; v < 2 && pk->v1 && ok; v++) {
+            const char *name = v ? pk->v2 : pk->v1;
+            if (!name) break;
+            ok = put_text(&b, "# HELP %s %s\n# TYPE %s gauge\n", name, v ? pk->help2 : pk->help1, name);
+            for (int i = s; i < end && ok; i++) {
+                const shm_sample_t *x = &srv->series[i].s;
+                double val = kind == METRIC_ALERT ? (x->v2 == 0) : v ? x->v2 : x->v1;
+                char label[64] = "";
+                if (kind == METRIC_ALERT) {
+                    const char *what = metric_kind_name((metric_kind_t)x->id);
+                    snprintf(label, sizeof(label), "{metric=\"%s\"}", what ? what : "UNKNOWN");
+                } else if (kind == METRIC_DISK_DEV) {
+                    snprintf(label, sizeof(label), "{device=\"%u:%u\"}", DEV_MAJOR(x->id), DEV_MINOR(x->id));
+                } else if (pk->label) {
+                    snprintf(label, sizeof(label), "{%s=\"%u\"}", pk->label, x->id);
+                }
+                ok = put_text(&b, "%s%s %.15g %llu\n", name, label, val, (unsigned long long)x->ts_ms);
+            }
+        }
+        s = end;
+    }
+    if (!ok) { buf_unref(b); return NULL; }
+    char head[HTTP_HEAD_MAX];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n",
+                     b->len - HTTP_HEAD_MAX);
+    // Slide the body down to meet the head; it is built once per update.
+    memmove(b->data + n, b->data + HTTP_HEAD_MAX, b->len - HTTP_HEAD_MAX);
+    memcpy(b->data, head, (size_t)n);
+    b->len = b->len - HTTP_HEAD_MAX + (size_t)n;
+    return b;
+}
+
+// Brings the series table and the cached snapshot up to the region's current gen.
+static void refresh(metrics_server_t *srv) {
+    uint32_t gen = atomic_load_explicit(&srv->shm->gen, memory_order_acquire);
+    if (srv->built && gen == srv->gen) return;
+    uint64_t updated = atomic_load_explicit(&srv->shm->updated_ms, memory_order_relaxed);
+    pull(srv, updated ? updated : now_ms());
+    srv->gen = gen;
+    buf_t *snap = build_snapshot(srv, updated);
+    if (!snap) return; // keep serving the previous one
+    buf_unref(srv->snap);
+    buf_unref(srv->prom);
+    srv->snap = snap;
+    srv->prom = NULL;
+    srv->built = true;
+}
+
+// ---- Connections ----
+
+static void conn_close(metrics_server_t *srv, int slot) {
+    conn_t *c = &srv->conns[slot];
+    close(c->fd); // also drops it from the epoll set
+    buf_unref(c->out);
+    c->out = NULL;
+    c->fd = -1;
+    srv->free_conns[srv->nfree++] = slot;
+}
+
+static void conn_watch(metrics_server_t *srv, int slot, bool out) {
+    conn_t *c = &srv->conns[slot];
+    if (c->want_out == out) return;
+    c->want_out = out;
+    struct epoll_event ev = { .events = out ? EPOLLOUT : EPOLLIN, .data.u32 = (uint32_t)slot };
+    epoll_ctl(srv->ep, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+// Picks the response to the request at the front of `in`, if complete. Returns false
+// when there is nothing (yet) to send.
+static bool conn_request(metrics_server_t *srv, conn_t *c) {
+    if (c->in_len >= 4 && memcmp(c->in, "GET ", 4) == 0) c->http = true;
+    if (c->http) {
+        if (!memmem(c->in, c->in_len, "\r\n\r\n", 4)) return false;
+        refresh(srv);
+        if (!srv->prom) srv->prom = build_prometheus(srv);
+        if (!srv->prom) return false;
+        srv->prom->refs++;
+        c->out = srv->prom;
+        c->close_after = true;
+        return true;
+    }
+    uint32_t len;
+    if (c->in_len < sizeof(len)) return false;
+    memcpy(&len, c->in, sizeof(len));
+    if (len != sizeof(msrv_request_t) - 4) {
+        c->out = build_error();
+        c->close_after = true;
+        return c->out != NULL;
+    }
+    if (c->in_len < sizeof(msrv_request_t)) return false;
+    msrv_request_t rq;
+    memcpy(&rq, c->in, sizeof(rq));
+    c->in_len -= sizeof(rq);
+    memmove(c->in, c->in + sizeof(rq), c->in_len);
+    refresh(srv);
+    if (rq.op == MSRV_SNAPSHOT && srv->snap) {
+        srv->snap->refs++;
+        c->out = srv->snap;
+    } else if (rq.op == MSRV_RANGE) {
+        c->out = build_range(srv, &rq, atomic_load_explicit(&srv->shm->updated_ms, memory_order_relaxed));
+    } else {
+        c->out = build_error();
+    }
+    return c->out != NULL;
+}
+
+// Sends what it can; answers pipelined requests in turn. Returns false once closed.
+static bool conn_pump(metrics_server_t *srv, int slot) {
+    conn_t *c = &srv->conns[slot];
+    for (;;) {
+        if (!c->out) {
+            c->out_off = 0;
+            if (!conn_request(srv, c)) return true;
+        }
+        while (c->out_off < c->out->len) {
+            ssize_t n = send(c->fd, c->out->data + c->out_off, c->out->len - c->out_off, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno == EAGAIN) { conn_watch(srv, slot, true); return true; }
+            if (n <= 0) { conn_close(srv, slot); return false; }
+            c->out_off += (size_t)n;
+        }
+        buf_unref(c->out);
+        c->out = NULL;
+        if (c->close_after) { conn_close(srv, slot); return false; }
+        conn_watch(srv, slot, false);
+    }
+}
+
+static void conn_readable(metrics_server_t *srv, int slot) {
+    conn_t *c = &srv->conns[slot];
+    if (c->out) { conn_pump(srv, slot); return; } // EPOLLOUT
+    for (;;) {
+        if (c->in_len == CONN_IN && c->http) {
+            // Long request head: only where it ends matters. Answering before it is
+            // all read would close on unread data and reset the connection.
+            memmove(c->in, c->in + CONN_IN - 3, 3);
+            c->in_len = 3;
+        } else if (c->in_len == CONN_IN) {
+            // Pipelined binary requests filled the buffer: answer those first.
+            if (!conn_pump(srv, slot) || c->out) return; // closed, or waiting to send
+            if (c->in_len == CONN_IN) { conn_close(srv, slot); return; }
+        }
+        ssize_t n = recv(c->fd, c->in + c->in_len, CONN_IN - c->in_len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) break;
+        if (n <= 0) { conn_close(srv, slot); return; }
+        c->in_len += (size_t)n;
+        if (c->in_len >= 4 && memcmp(c->in, "GET ", 4) == 0) c->http = true;
+    }
+    conn_pump(srv, slot);
+}
+
+static void accept_all(metrics_server_t *srv) {
+    for (;;) {
+        int fd = accept4(srv->lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        if (srv->nfree == 0) { close(fd); continue; } // full: the client sees EOF
+        int slot = srv->free_conns[--srv->nfree];
+        srv->conns[slot] = (conn_t){ .fd = fd };
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)slot };
+        if (epoll_ctl(srv->ep, EPOLL_CTL_ADD, fd, &ev) != 0) conn_close(srv, slot);
+    }
+}
+
+static void *server_thread(void *arg) {
+    metrics_server_t *srv = arg;
+    SELF_THREAD("server");
+    struct epoll_event events[64];
+    for (;;) {
+        int k = epoll_wait(srv->ep, events, 64, -1);
+        if (k < 0 && errno == EINTR) continue;
+        if (k < 0) { perror("metrics server: epoll_wait"); return NULL; }
+        for (int e = 0; e < k; e++) {
+            uint32_t id = events[e].data.u32;
+            if (id == EV_STOP) return NULL;
+            if (id == EV_LISTEN) accept_all(srv);
+            else if (srv->conns[id].fd >= 0) conn_readable(srv, (int)id);
+        }
+    }
+}
+
+// ---- Lifecycle ----
+
+metrics_server_t *metrics_server_start(const char *path, const shm_metrics_t *shm) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) { errno = ENAMETOOLONG; return NULL; }
+    strcpy(addr.sun_path, path);
+    metrics_server_t *srv = calloc(1, sizeof(*srv));
+    if (!srv) return NULL;
+    srv->shm = shm;
+    strcpy(srv->path, path);
+    srv->lfd = srv->ep = srv->stop_fd = -1;
+    for (int i = 0; i < MSRV_MAX_CLIENTS; i++) {
+        srv->conns[i].fd = -1;
+        srv->free_conns[srv->nfree++] = MSRV_MAX_CLIENTS - 1 - i;
+    }
+    srv->lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (srv->lfd < 0) goto fail;
+    // A socket file nobody accepts on is left over from a monitor that died; one that
+    // answers belongs to a running monitor.
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+        if (probe >= 0) close(probe);
+        if (live) { errno = EADDRINUSE; goto fail; }
+        unlink(path);
+    }
+    if (bind(srv->lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(srv->lfd, SOMAXCONN) != 0) goto fail;
+    srv->ep = epoll_create1(EPOLL_CLOEXEC);
+    srv->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (srv->ep < 0 || srv->stop_fd < 0) goto fail_bound;
+    struct epoll_event lev = { .events = EPOLLIN, .data.u32 = EV_LISTEN }, sev = { .events = EPOLLIN, .data.u32 = EV_STOP };
+    if (epoll_ctl(srv->ep, EPOLL_CTL_ADD, srv->lfd, &lev) != 0 || epoll_ctl(srv->ep, EPOLL_CTL_ADD, srv->stop_fd, &sev) != 0)
+        goto fail_bound;
+    int err = pthread_create(&srv->th, NULL, server_thread, srv);
+    if (err) { errno = err; goto fail_bound; }
+    return srv;
+fail_bound:
+    unlink(path);
+fail: {
+        int saved = errno;
+        if (srv->stop_fd >= 0) close(srv->stop_fd);
+        if (srv->ep >= 0) close(srv->ep);
+        if (srv->lfd >= 0) close(srv->lfd);
+        free(srv);
+        errno = saved;
+        return NULL;
+    }
+}
+
+void metrics_server_stop(metrics_server_t *srv) {
+    if (!srv) return;
+    uint64_t one = 1;
+    if (write(srv->stop_fd, &one, sizeof(one)) != sizeof(one)) perror("metrics server: eventfd");
+    pthread_join(srv->th, NULL);
+    for (int i = 0; i < MSRV_MAX_CLIENTS; i++)
+        if (srv->conns[i].fd >= 0) conn_close(srv, i);
+    close(srv->stop_fd);
+    close(srv->ep);
+    close(srv->lfd);
+    unlink(srv->path);
+    buf_unref(srv->snap);
+    buf_unref(srv->prom);
+    free(srv->series);
+    free(srv->index);
+    free(srv);
+}
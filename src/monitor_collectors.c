@@ -0,0 +1,567 @@
+#define _GNU_SOURCE
+#include "collector.h"
+#include "collectors.h"
+#include "cgroup_stats.h"
+#include "cpu_cores.h"
+#include "dev_stats.h"
+#include "proc_scan.h"
+#include "pressure.h"
+#include "proc_trace.h"
+#include "selfstat.h"
+
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Built-in /proc collectors. Each keeps its proc_file_t and previous counters in its
+// state block so one tick is exactly one pread + parse + push.
+
+typedef struct {
+    proc_file_t pf;
+    bool per_core;
+    cpu_times_t prev;
+    uint64_t prev_ts;
+    bool have_prev;
+    cpu_cores_t cores[2];
+    int cur_core;
+    cpu_core_pct_t pct;
+} cpu_state_t;
+
+static int cpu_init(collector_t *c, monitor_ctx_t *ctx) {
+    cpu_state_t *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    if (pf_open(&s->pf, "/proc/stat", 4096) != 0) { perror("open /proc/stat"); free(s); return -1; }
+    s->per_core = ctx->cfg.per_core_cpu;
+    cpu_cores_init(&s->cores[0]); cpu_cores_init(&s->cores[1]); cpu_core_pct_init(&s->pct);
+    // Delta against the previous tick: one /proc read per sample.
+    s->prev_ts = now_ms();
+    s->have_prev = read_cpu_times(&s->pf, &s->prev) == 0;
+    if (s->per_core && s->have_prev) parse_cpu_cores(s->pf.buf, &s->cores[0]);
+    c->state = s;
+    return 0;
+}
+
+static void push_core_metrics(monitor_ctx_t *ctx, const cpu_core_pct_t *pct, uint64_t ts, uint32_t interval) {
+    for (int i = 0; i < pct->ncores; i++) {
+        metric_t us = { .kind = METRIC_CPU_CORE, .id = (uint32_t)i, .v1 = pct->user[i], .v2 = pct->system[i],
+                        .ts_ms = ts, .interval_ms = interval };
+        metric_t ws = { .kind = METRIC_CPU_CORE_WAIT, .id = (uint32_t)i, .v1 = pct->iowait[i], .v2 = pct->steal[i],
+                        .ts_ms = ts, .interval_ms = interval };
+        if (!mq_push(&ctx->queue, &us) || !mq_push(&ctx->queue, &ws)) return;
+    }
+}
+
+static void cpu_sample(collector_t *c, monitor_ctx_t *ctx) {
+    cpu_state_t *s = c->state;
+    cpu_times_t cur;
+    uint64_t ts = now_ms();
+    if (read_cpu_times(&s->pf, &cur) != 0) { s->have_prev = false; return; }
+    bool cores_ok = s->per_core && parse_cpu_cores(s->pf.buf, &s->cores[s->cur_core ^ 1]) == 0;
+    if (s->have_prev) {
+        // Stamp the middle of the measured window.
+        uint64_t mid = s->prev_ts + (ts - s->prev_ts) / 2;
+        metric_t m = { .kind = METRIC_CPU, .v1 = cpu_busy_percent(&s->prev, &cur), .v2 = 0, .ts_ms = mid,
+                       .interval_ms = (uint32_t)(ts - s->prev_ts) };
+        c->level = m.v1;
+        mq_push(&ctx->queue, &m);
+        if (cores_ok && cpu_cores_delta(&s->cores[s->cur_core], &s->cores[s->cur_core ^ 1], &s->pct) == 0)
+            push_core_metrics(ctx, &s->pct, mid, m.interval_ms);
+    }
+    if (cores_ok) s->cur_core ^= 1;
+    s->prev = cur; s->prev_ts = ts; s->have_prev = true;
+}
+
+static void cpu_fini(collector_t *c) {
+    cpu_state_t *s = c->state;
+    if (!s) return;
+    cpu_cores_free(&s->cores[0]); cpu_cores_free(&s->cores[1]); cpu_core_pct_free(&s->pct);
+    pf_close(&s->pf);
+    free(s);
+    c->state = NULL;
+}
+
+typedef struct { proc_file_t pf; } mem_state_t;
+
+static int mem_init(collector_t *c, monitor_ctx_t *ctx) {
+    (void)ctx;
+    mem_state_t *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    if (pf_open(&s->pf, "/proc/meminfo", 4096) != 0) { perror("open /proc/meminfo"); free(s); return -1; }
+    c->state = s;
+    return 0;
+}
+
+static void mem_sample(collector_t *c, monitor_ctx_t *ctx) {
+    mem_state_t *s = c->state;
+    metric_t m = { .kind = METRIC_MEM, .v1 = read_mem_usage_percent(&s->pf), .v2 = 0, .ts_ms = now_ms(),
+                   .interval_ms = c->tick_ms };
+    if (m.v1 >= 0) c->level = m.v1;
+    mq_push(&ctx->queue, &m);
+}
+
+static void mem_fini(collector_t *c) {
+    mem_state_t *s = c->state;
+    if (!s) return;
+    pf_close(&s->pf);
+    free(s);
+    c->state = NULL;
+}
+
+// Shared by disk and net: a device table (dev_stats.h) turned into per-interval deltas,
+// pushed as one total over the devices the filter counts and, with cfg.per_device, one
+// metric per device that moved (plus a zero on the tick after it stops). Idle devices
+// cost a compare per tick and nothing in the queue, however many veths the host has.
+typedef struct {
+    proc_file_t pf;
+    dev_table_t t;
+    dev_netlink_t *nl; // net with cfg.net_netlink
+    metric_kind_t kind, dev_kind;
+    bool per_device;
+} dev_state_t;
+
+static int dev_read(dev_state_t *s) {
+    if (s->nl) return dev_netlink_read(s->nl, &s->t);
+    if (pf_read(&s->pf) < 0) return -1;
+    return s->t.cls == DEV_DISK ? dev_parse_diskstats(&s->t, s->pf.buf) : dev_parse_net_dev(&s->t, s->pf.buf);
+}
+
+static int dev_state_init(collector_t *c, monitor_ctx_t *ctx, dev_class_t cls) {
+    dev_state_t *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    const char *path = cls == DEV_DISK ? "/proc/diskstats" : "/proc/net/dev";
+    s->pf.fd = -1;
+    dev_table_init(&s->t, cls, cls == DEV_DISK ? ctx->cfg.disk_filter : ctx->cfg.net_filter);
+    s->kind = cls == DEV_DISK ? METRIC_DISK : METRIC_NET;
+    s->dev_kind = cls == DEV_DISK ? METRIC_DISK_DEV : METRIC_NET_DEV;
+    s->per_device = ctx->cfg.per_device;
+    if (cls == DEV_NET && ctx->cfg.net_netlink) {
+        s->nl = dev_netlink_open();
+        if (s->nl && dev_netlink_read(s->nl, &s->t) != 0) { dev_netlink_close(s->nl); s->nl = NULL; }
+        if (!s->nl) fprintf(stderr, "rtnetlink stats unavailable, reading %s\n", path);
+    }
+    if (!s->nl && pf_open(&s->pf, path, 4096) != 0) {
+        fprintf(stderr, "open %s failed\n", path);
+        dev_table_free(&s->t);
+        free(s);
+        return -1;
+    }
+    if (!s->nl) dev_read(s); // baseline: new rows start with a0 = a
+    c->state = s;
+    return 0;
+}
+
+static int disk_init(collector_t *c, monitor_ctx_t *ctx) {
+    return dev_state_init(c, ctx, DEV_DISK);
+}
+
+static int net_init(collector_t *c, monitor_ctx_t *ctx) {
+    return dev_state_init(c, ctx, DEV_NET);
+}
+
+static void dev_sample(collector_t *c, monitor_ctx_t *ctx) {
+    dev_state_t *s = c->state;
+    if (dev_read(s) != 0) return;
+    // Adaptive ticks vary in length: report deltas per base interval, so values keep
+    // the same scale as fixed-interval runs and average correctly by interval_ms.
+    double k = c->adaptive && c->tick_ms > 0 ? (double)c->adapt.base_ms / (double)c->tick_ms : 1.0;
+    uint64_t ts = now_ms(), sa = 0, sb = 0;
+    dev_table_t *t = &s->t;
+    bool pushing = s->per_device;
+    for (int i = 0; i < t->n; i++) {
+        // A counter that went backwards belongs to a device re-created under the same key.
+        uint64_t da = t->a[i] >= t->a0[i] ? t->a[i] - t->a0[i] : 0;
+        uint64_t db = t->b[i] >= t->b0[i] ? t->b[i] - t->b0[i] : 0;
+        t->a0[i] = t->a[i]; t->b0[i] = t->b[i];
+        if (!t->use[i]) continue;
+        sa += da; sb += db;
+        bool moved = da || db;
+        if (pushing && (moved || t->moved[i])) {
+            metric_t m = { .kind = s->dev_kind, .id = t->key[i], .v1 = (double)da * k, .v2 = (double)db * k,
+                           .ts_ms = ts, .interval_ms = c->tick_ms };
+            pushing = mq_push(&ctx->queue, &m);
+        }
+        t->moved[i] = moved;
+    }
+    metric_t m = { .kind = s->kind, .v1 = (double)sa * k, .v2 = (double)sb * k, .ts_ms = ts, .interval_ms = c->tick_ms };
+    c->level = m.v1 + m.v2;
+    mq_push(&ctx->queue, &m);
+}
+
+static void dev_fini(collector_t *c) {
+    dev_state_t *s = c->state;
+    if (!s) return;
+    pf_close(&s->pf);
+    dev_netlink_close(s->nl);
+    dev_table_free(&s->t);
+    free(s);
+    c->state = NULL;
+}
+
+// Per-process top-K and workload capture. The scan itself is bounded by
+// cfg.proc_budget_us; pids it did not reach are picked up first on the next tick. With
+// cfg.trace_path every tick's CPU bursts are appended to the trace, so capture costs one
+// small write on top of the scan.
+typedef struct {
+    proc_scan_t *ps;
+    uint64_t budget_us;
+    proc_trace_t *trace;
+    uint64_t trace_t0_ns;
+    long hz;
+} procs_state_t;
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int procs_init(collector_t *c, monitor_ctx_t *ctx) {
+    procs_state_t *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    s->ps = proc_scan_open(PROC_SCAN_DEFAULT_ROOT, (int)ctx->cfg.proc_top_k, 0);
+    if (!s->ps) { perror("open /proc"); free(s); return -1; }
+    s->budget_us = ctx->cfg.proc_budget_us;
+    s->hz = proc_scan_hz(s->ps);
+    if (ctx->cfg.trace_path) {
+        s->trace = proc_trace_open(ctx->cfg.trace_path, (uint32_t)s->hz);
+        if (!s->trace) { perror(ctx->cfg.trace_path); proc_scan_close(s->ps); free(s); return -1; }
+        proc_scan_track_bursts(s->ps, true);
+    }
+    proc_scan_tick(s->ps, s->budget_us); // baseline counters
+    s->trace_t0_ns = mono_ns();
+    c->state = s;
+    return 0;
+}
+
+static void procs_sample(collector_t *c, monitor_ctx_t *ctx) {
+    procs_state_t *s = c->state;
+    if (proc_scan_tick(s->ps, s->budget_us) < 0) return;
+    if (s->trace) {
+        const proc_burst_t *b;
+        size_t nb = proc_scan_bursts(s->ps, &b);
+        uint64_t ticks = (mono_ns() - s->trace_t0_ns) * (uint64_t)s->hz / 1000000000ULL;
+        if (proc_trace_append(s->trace, ticks, b, nb) != 0) {
+            perror("trace write");
+            proc_trace_close(s->trace);
+            s->trace = NULL;
+        }
+    }
+    if (ctx->cfg.proc_top_k == 0) return;
+    uint64_t ts = now_ms();
+    static const metric_kind_t kinds[PROC_RANK_COUNT] = { METRIC_PROC_CPU, METRIC_PROC_RSS, METRIC_PROC_IO };
+    for (int r = 0; r < PROC_RANK_COUNT; r++) {
+        const proc_top_t *top;
+        size_t n = proc_scan_top(s->ps, (proc_rank_t)r, &top);
+        for (size_t i = 0; i < n; i++) {
+            metric_t m = { .kind = kinds[r], .id = top[i].pid, .ts_ms = ts, .interval_ms = c->tick_ms };
+            if (r == PROC_BY_CPU) m.v1 = top[i].cpu_pct;
+            else if (r == PROC_BY_RSS) m.v1 = (double)top[i].rss_bytes;
+            else { m.v1 = top[i].read_bps; m.v2 = top[i].write_bps; }
+            if (!mq_push(&ctx->queue, &m)) return;
+        }
+    }
+}
+
+static void procs_fini(collector_t *c) {
+    procs_state_t *s = c->state;
+    if (!s) return;
+    if (s->trace) {
+        fprintf(stderr, "trace: %llu bursts, %llu bytes\n", (unsigned long long)proc_trace_records(s->trace),
+                (unsigned long long)proc_trace_bytes(s->trace));
+        proc_trace_close(s->trace);
+    }
+    proc_scan_close(s->ps);
+    free(s);
+    c->state = NULL;
+}
+
+// Pressure stall: the share of each tick in which some (and all) tasks stalled on CPU,
+// memory and I/O, from the cumulative totals. With cfg.psi_window_ms the kernel also
+// watches "some" stall itself (psi_trigger_open). The trigger fds are the collector's
+// event_fds, so a breach ticks the collector at once and raises its METRIC_ALERT
+// within the trigger window rather than at the next alert-window mean. The kernel
+// fires at most once per window while the breach lasts, so the alert clears once two
+// windows pass without a trigger and the tick's stall is below the trigger's ratio
+// minus cfg.alert_hysteresis.
+typedef struct {
+    proc_file_t pf[PSI_RESOURCES];
+    psi_totals_t prev[PSI_RESOURCES];
+    uint64_t prev_ns;
+    int trig[PSI_RESOURCES];
+    uint8_t trig_res[COLLECTOR_EVENT_FDS]; // event_fds[j] watches trig_res[j]
+    double threshold;  // the trigger as a % of its window
+    double hysteresis;
+    uint64_t window_ns; // as the kernel took it
+    uint64_t armed_ns;  // events before this are ignored, see psi_init
+    uint64_t fired_ns[PSI_RESOURCES];
+    bool alerting[PSI_RESOURCES];
+} psi_state_t;
+
+static void psi_fini(collector_t *c) {
+    psi_state_t *s = c->state;
+    if (!s) return;
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        pf_close(&s->pf[r]);
+        if (s->trig[r] >= 0) close(s->trig[r]);
+    }
+    free(s);
+    c->state = NULL;
+    c->nevent_fds = 0;
+}
+
+static int psi_init(collector_t *c, monitor_ctx_t *ctx) {
+    psi_state_t *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    const monitor_config_t *cfg = &ctx->cfg;
+    char path[64];
+    int opened = 0;
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        s->trig[r] = -1;
+        snprintf(path, sizeof(path), PSI_DIR "/%s", psi_file((psi_resource_t)r));
+        if (pf_open(&s->pf[r], path, 256) != 0) continue;
+        opened++;
+        if (pf_read(&s->pf[r]) >= 0) parse_psi(s->pf[r].buf, &s->prev[r]);
+    }
+    s->prev_ns = mono_ns();
+    c->state = s;
+    if (!opened) {
+        fprintf(stderr, "open %s failed (needs Linux 4.20+ with CONFIG_PSI)\n", PSI_DIR);
+        psi_fini(c);
+        return -1;
+    }
+    if (cfg->psi_window_ms && cfg->psi_stall_ms) {
+        s->threshold = 100.0 * cfg->psi_stall_ms / cfg->psi_window_ms;
+        s->hysteresis = cfg->alert_hysteresis;
+        for (int r = 0; r < PSI_RESOURCES; r++) {
+            if (s->pf[r].fd < 0) continue;
+            snprintf(path, sizeof(path), PSI_DIR "/%s", psi_file((psi_resource_t)r));
+            unsigned int window_us = cfg->psi_window_ms * 1000;
+            s->trig[r] = psi_trigger_open(path, false, cfg->psi_stall_ms * 1000, &window_us);
+            if (s->trig[r] < 0) { perror("psi trigger"); continue; }
+            s->window_ns = (uint64_t)window_us * 1000;
+            s->trig_res[c->nevent_fds] = (uint8_t)r;
+            c->event_fds[c->nevent_fds++] = s->trig[r];
+            c->event_mask = POLLPRI; // the fd always polls readable
+        }
+        // The kernel measures a new trigger's first window against a stale total, so
+        // it can fire at once; a breach that is real fires again in the next window.
+        s->armed_ns = s->prev_ns + s->window_ns;
+    }
+    return 0;
+}
+
+static void psi_sample(collector_t *c, monitor_ctx_t *ctx) {
+    psi_state_t *s = c->state;
+    uint64_t now = mono_ns(), ts = now_ms();
+    bool fired[PSI_RESOURCES] = { false };
+    for (int j = 0; j < c->nevent_fds; j++) {
+        if (!(c->events & (1u << j)) || now < s->armed_ns) continue;
+        fired[s->trig_res[j]] = true;
+        s->fired_ns[s->trig_res[j]] = now;
+    }
+    double us = (double)(now - s->prev_ns) / 1e3;
+    s->prev_ns = now;
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        psi_totals_t cur;
+        if (s->pf[r].fd < 0 || pf_read(&s->pf[r]) < 0 || parse_psi(s->pf[r].buf, &cur) != 0) continue;
+        double some = us > 0 ? fmin(100.0, 100.0 * (double)(cur.some_us - s->prev[r].some_us) / us) : 0;
+        double full = us > 0 ? fmin(100.0, 100.0 * (double)(cur.full_us - s->prev[r].full_us) / us) : 0;
+        s->prev[r] = cur;
+        metric_kind_t kind = (metric_kind_t)(METRIC_PSI_CPU + r);
+        metric_t m = { .kind = kind, .v1 = some, .v2 = full, .ts_ms = ts, .interval_ms = c->tick_ms };
+        mq_push(&ctx->queue, &m);
+        bool raise = fired[r] && !s->alerting[r];
+        bool clear = s->alerting[r] && now - s->fired_ns[r] >= 2 * s->window_ns && some < s->threshold - s->hysteresis;
+        if (!raise && !clear) continue;
+        s->alerting[r] = raise;
+        // The tick that a trigger cuts short may hold little of the stall: a raise
+        // reports at least the trigger's own ratio.
+        metric_t a = { .kind = METRIC_ALERT, .id = (uint32_t)kind, .v1 = raise ? fmax(some, s->threshold) : some,
+                       .v2 = raise ? 0.0 : 1.0, .ts_ms = ts };
+        mq_push(&ctx->queue, &a);
+    }
+}
+
+// Per-cgroup CPU, memory and I/O (cgroup_stats.h): one metric of each for every
+// cgroup whose counters moved.
+typedef struct { monitor_ctx_t *ctx; uint64_t ts; uint32_t interval; bool open; } cgroup_push_t;
+
+static void cgroup_push(const cgroup_sample_t *s, void *arg) {
+    cgroup_push_t *p = arg;
+    metric_t m = { .kind = METRIC_CGROUP_CPU, .id = s->id, .v1 = s->cpu_pct, .v2 = s->throttled_pct,
+                   .ts_ms = p->ts, .interval_ms = p->interval };
+    if (p->open) p->open = mq_push(&p->ctx->queue, &m);
+    if (p->open && s->has_mem) {
+        m.kind = METRIC_CGROUP_MEM; m.v1 = (double)s->mem_bytes; m.v2 = 0;
+        p->open = mq_push(&p->ctx->queue, &m);
+    }
+    if (p->open && s->has_io) {
+        m.kind = METRIC_CGROUP_IO; m.v1 = (double)s->read_bytes; m.v2 = (double)s->write_bytes;
+        p->open = mq_push(&p->ctx->queue, &m);
+    }
+}
+
+static int cgroup_init(collector_t *c, monitor_ctx_t *ctx) {
+    cgroup_tree_t *t = cgroup_tree_open(ctx->cfg.cgroup_root, CGROUP_MAX_TRACKED);
+    if (!t) {
+        if (errno == ENOTSUP) fprintf(stderr, "%s is not a cgroup v2 hierarchy\n", ctx->cfg.cgroup_root);
+        else perror(ctx->cfg.cgroup_root);
+        return -1;
+    }
+    cgroup_tree_sample(t, NULL, NULL); // baseline
+    c->state = t;
+    return 0;
+}
+
+static void cgroup_sample(collector_t *c, monitor_ctx_t *ctx) {
+    cgroup_push_t p = { .ctx = ctx, .ts = now_ms(), .interval = c->tick_ms, .open = true };
+    cgroup_tree_sample(c->state, cgroup_push, &p);
+}
+
+static void cgroup_fini(collector_t *c) {
+    cgroup_tree_close(c->state);
+    c->state = NULL;
+}
+
+#ifdef MONITOR_SELFSTAT
+// METRIC_SELF: every second, the p50/p99 of each latency histogram over the last
+// interval and each counter's delta and total. These metrics go through the queue
+// they measure, so they show up in its figures too.
+#define SELF_INTERVAL_MS 1000
+
+typedef struct { self_snapshot_t snap[2]; int cur; } self_state_t;
+
+static int self_init(collector_t *c, monitor_ctx_t *ctx) {
+    (void)ctx;
+    self_state_t *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    self_snapshot(&s->snap[0]);
+    c->state = s;
+    return 0;
+}
+
+static void self_sample(collector_t *c, monitor_ctx_t *ctx) {
+    self_state_t *s = c->state;
+    const self_snapshot_t *prev = &s->snap[s->cur];
+    self_snapshot_t *cur = &s->snap[s->cur ^ 1];
+    self_snapshot(cur);
+    s->cur ^= 1;
+    uint64_t ts = now_ms();
+    for (int h = 0; h < SELF_H_COUNT; h++) {
+        uint64_t p50 = self_quantile(cur->hist[h], prev->hist[h], 0.5);
+        if (!p50) continue;
+        metric_t m = { .kind = METRIC_SELF, .id = (uint32_t)h, .v1 = p50 / 1e3,
+                       .v2 = self_quantile(cur->hist[h], prev->hist[h], 0.99) / 1e3, .ts_ms = ts, .interval_ms = c->tick_ms };
+        if (!mq_push(&ctx->queue, &m)) return;
+    }
+    for (int k = 0; k < SELF_C_COUNT; k++) {
+        metric_t m = { .kind = METRIC_SELF, .id = SELF_COUNTER_ID(k),
+                       .v1 = (double)(cur->counters[k] - prev->counters[k]), .v2 = (double)cur->counters[k], .ts_ms = ts,
+                       .interval_ms = c->tick_ms };
+        if (!mq_push(&ctx->queue, &m)) return;
+    }
+}
+
+static void self_fini(collector_t *c) {
+    free(c->state);
+    c->state = NULL;
+}
+#endif
+
+// ---- Registry ----
+// Every collector the monitor can run, in start order. `wanted` says whether the
+// options ask for it (NULL = always); `period` picks the interval setting it follows.
+// Adaptive entries also name the alert threshold their interval tightens towards and
+// the smallest change that is not noise: CPU % moves in jiffies (5 points is one
+// 10 ms jiffy in 200 ms on one CPU), disk in 512-byte sectors, net in bytes.
+
+typedef enum { EVERY_SAMPLE, EVERY_PROC, EVERY_SELF } period_t;
+typedef enum { FIXED, ADAPT_CPU, ADAPT_MEM, ADAPT } adapt_kind_t;
+
+static bool want_psi(const monitor_config_t *cfg) { return cfg->psi; }
+static bool want_cgroup(const monitor_config_t *cfg) { return cfg->cgroup_root != NULL; }
+static bool want_procs(const monitor_config_t *cfg) { return cfg->proc_top_k > 0 || cfg->trace_path; }
+
+static const struct {
+    const char *name;
+    int  (*init)(collector_t *c, monitor_ctx_t *ctx);
+    void (*sample)(collector_t *c, monitor_ctx_t *ctx);
+    void (*fini)(collector_t *c);
+    bool (*wanted)(const monitor_config_t *cfg);
+    period_t period;
+    adapt_kind_t adapt;
+    double min_step;
+} registry[] = {
+    { "cpu",    cpu_init,    cpu_sample,    cpu_fini,    NULL,        EVERY_SAMPLE, ADAPT_CPU, 5.0 },
+    { "mem",    mem_init,    mem_sample,    mem_fini,    NULL,        EVERY_SAMPLE, ADAPT_MEM, 1.0 },
+    { "disk",   disk_init,   dev_sample,    dev_fini,    NULL,        EVERY_SAMPLE, ADAPT,     64 },
+    { "net",    net_init,    dev_sample,    dev_fini,    NULL,        EVERY_SAMPLE, ADAPT,     4096 },
+    { "psi",    psi_init,    psi_sample,    psi_fini,    want_psi,    EVERY_SAMPLE, FIXED,     0 },
+    { "cgroup", cgroup_init, cgroup_sample, cgroup_fini, want_cgroup, EVERY_PROC,   FIXED,     0 },
+    { "procs",  procs_init,  procs_sample,  procs_fini,  want_procs,  EVERY_PROC,   FIXED,     0 },
+#ifdef MONITOR_SELFSTAT
+    { "self",   self_init,   self_sample,   self_fini,   NULL,        EVERY_SELF,   FIXED,     0 },
+#endif
+};
+#define REGISTRY_LEN ((int)(sizeof(registry) / sizeof(registry[0])))
+
+int collector_find(const char *name) {
+    for (int r = 0; r < REGISTRY_LEN; r++)
+        if (strcmp(registry[r].name, name) == 0) return r;
+    return -1;
+}
+
+// The item of a "name,..." or "name=value,..." list that is `name`: a pointer just past
+// the name, or NULL.
+static const char *list_item(const char *list, const char *name) {
+    size_t len = strlen(name);
+    for (const char *p = list; p && *p; p = strchr(p, ',') ? strchr(p, ',') + 1 : NULL)
+        if (strncmp(p, name, len) == 0 && (p[len] == ',' || p[len] == '=' || p[len] == '\0')) return p + len;
+    return NULL;
+}
+
+static bool same_bounds(const adapt_t *a, const adapt_t *b) {
+    return a->floor_ms == b->floor_ms && a->base_ms == b->base_ms && a->ceil_ms == b->ceil_ms && a->near == b->near &&
+           (a->threshold == b->threshold || (isnan(a->threshold) && isnan(b->threshold)));
+}
+
+void collector_configure(collector_t *c, const monitor_config_t *cfg) {
+    const char *o = list_item(cfg->intervals, registry[c->reg].name);
+    unsigned int ms = cfg->sample_interval_ms;
+    if (o && *o == '=') ms = (unsigned int)strtoul(o + 1, NULL, 10);
+    else if (registry[c->reg].period == EVERY_PROC && cfg->proc_interval_ms) ms = cfg->proc_interval_ms;
+#ifdef MONITOR_SELFSTAT
+    else if (registry[c->reg].period == EVERY_SELF) ms = SELF_INTERVAL_MS;
+#endif
+    adapt_kind_t k = registry[c->reg].adapt;
+    bool was = c->adaptive;
+    c->adaptive = cfg->adaptive && k != FIXED;
+    if (!c->adaptive) { c->interval_ms = ms; return; }
+    double threshold = k == ADAPT_CPU ? cfg->cpu_alert_threshold : k == ADAPT_MEM ? cfg->mem_alert_threshold : NAN;
+    adapt_t next;
+    adapt_init(&next, cfg->sample_min_ms, ms, cfg->sample_max_ms, threshold, 2 * cfg->alert_hysteresis,
+               registry[c->reg].min_step);
+    // A reload that leaves the bounds and threshold alone keeps the learned signal
+    // statistics and the interval the collector has settled on.
+    if (was && same_bounds(&next, &c->adapt)) return;
+    c->adapt = next;
+    c->interval_ms = ms;
+}
+
+int monitor_collectors(collector_t *out, int max, const monitor_config_t *cfg) {
+    int n = 0;
+    for (int r = 0; r < REGISTRY_LEN && n < max; r++) {
+        if (registry[r].wanted && !registry[r].wanted(cfg)) continue;
+        if (cfg->collectors && !list_item(cfg->collectors, registry[r].name)) continue;
+        out[n] = (collector_t){ .name = registry[r].name, .init = registry[r].init, .sample = registry[r].sample,
+                                .fini = registry[r].fini, .reg = r };
+        collector_configure(&out[n], cfg);
+        n++;
+    }
+    return n;
+}
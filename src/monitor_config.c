@@ -0,0 +1,342 @@
+#define _GNU_SOURCE
+#include "monitor_config.h"
+#include "aggregate.h"
+#include "cgroup_stats.h"
+#include "collector.h"
+#include "metrics_server.h"
+#include "tsdb.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The key table: each key names one monitor_config_t field and how its value parses.
+// `live` keys are the ones a reload may change under running threads.
+
+typedef enum {
+    T_UINT,      // unsigned integer
+    T_POS,       // unsigned integer > 0
+    T_PCT,       // double
+    T_ON,        // bool flag
+    T_OFF,       // bool flag, stored inverted (no-psi ...)
+    T_STR,       // non-empty string
+    T_NULL,      // flag that clears a string (no-cgroups)
+    T_WINDOW,    // agg window in seconds: 1, 10, 60 or 300
+    T_FORMAT,    // log_format_t by name
+    T_PSI,       // STALL_MS/WINDOW_MS or off, into psi_stall_ms and psi_window_ms
+    T_SOCKET,    // optional path, MSRV_DEFAULT_PATH without one
+    T_NAMES,     // "name,..." of registry collectors
+    T_INTERVALS, // "name=ms,..." of registry collectors
+} key_type_t;
+
+typedef struct {
+    const char *key;
+    key_type_t type;
+    size_t off;
+    bool live;
+} setting_t;
+
+#define F(field) offsetof(monitor_config_t, field)
+static const setting_t keys[] = {
+    { "cpu-alert",        T_PCT,       F(cpu_alert_threshold), true },
+    { "mem-alert",        T_PCT,       F(mem_alert_threshold), true },
+    { "alert-window",     T_WINDOW,    F(alert_window),        true },
+    { "alert-hysteresis", T_PCT,       F(alert_hysteresis),    true },
+    { "sample-ms",        T_POS,       F(sample_interval_ms),  true },
+    { "adaptive",         T_ON,        F(adaptive),            true },
+    { "sample-min-ms",    T_UINT,      F(sample_min_ms),       true },
+    { "sample-max-ms",    T_UINT,      F(sample_max_ms),       true },
+    { "intervals",        T_INTERVALS, F(intervals),           true },
+    { "proc-interval-ms", T_UINT,      F(proc_interval_ms),    true },
+    { "summary-s",        T_POS,       F(summary_interval_s),  true },
+    { "collectors",       T_NAMES,     F(collectors),          false },
+    { "no-per-core",      T_OFF,       F(per_core_cpu),        false },
+    { "no-per-device",    T_OFF,       F(per_device),          false },
+    { "disks",            T_STR,       F(disk_filter),         false },
+    { "ifaces",           T_STR,       F(net_filter),          false },
+    { "netlink",          T_ON,        F(net_netlink),         false },
+    { "no-psi",           T_OFF,       F(psi),                 false },
+    { "psi-trigger",      T_PSI,       F(psi_stall_ms),        false },
+    { "cgroup-root",      T_STR,       F(cgroup_root),         false },
+    { "no-cgroups",       T_NULL,      F(cgroup_root),         false },
+    { "event-loop",       T_ON,        F(event_loop),          false },
+    { "log-format",       T_FORMAT,    F(log_format),          false },
+    { "log-path",         T_STR,       F(log_path),            false },
+    { "log-flush-ms",     T_UINT,      F(log_flush_ms),        false },
+    { "log-direct",       T_ON,        F(log_direct),          false },
+    { "no-log-archive",   T_OFF,       F(log_archive),         false },
+    { "log-rotate-mb",    T_UINT,      F(log_rotate_mb),       false },
+    { "log-rotate-s",     T_UINT,      F(log_rotate_s),        false },
+    { "log-keep",         T_UINT,      F(log_keep),            true },
+    { "log-segments",     T_POS,       F(log_segments),        true },
+    { "mq-summary",       T_ON,        F(mq_summary),          false },
+    { "socket",           T_SOCKET,    F(metrics_socket),      false },
+    { "proc-top",         T_UINT,      F(proc_top_k),          false },
+    { "proc-budget-us",   T_UINT,      F(proc_budget_us),      false },
+    { "trace",            T_STR,       F(trace_path),          false },
+    { "shm-name",         T_STR,       F(shm_name),            false },
+};
+#define NKEYS (sizeof(keys) / sizeof(keys[0]))
+#define AT(cfg, k, T) ((T *)((char *)(cfg) + (k)->off))
+
+void monitor_config_defaults(monitor_config_t *cfg) {
+    *cfg = (monitor_config_t){
+        .cpu_alert_threshold = 85.0,
+        .mem_alert_threshold = 85.0,
+        .alert_window = AGG_10S,
+        .alert_hysteresis = 5.0,
+        .sample_interval_ms = 500,
+        .sample_min_ms = 100,
+        .sample_max_ms = 4000,
+        .summary_interval_s = 3,
+        .per_core_cpu = true,
+        .per_device = true,
+        .psi = true,
+        .psi_stall_ms = 100,
+        .psi_window_ms = 1000,
+        .cgroup_root = CGROUP_DEFAULT_ROOT,
+        .log_format = LOG_TSDB,
+        .log_flush_ms = 1000,
+        .log_archive = true,
+        .log_rotate_mb = 64,
+        .log_keep = 16,
+        .log_segments = TSDB_DEFAULT_MAX_SEGMENTS,
+        .proc_top_k = 10,
+        .proc_interval_ms = 2000,
+        .proc_budget_us = 20000,
+    };
+}
+
+static bool parse_uint(const char *s, unsigned int *out) {
+    if (!s || !isdigit((unsigned char)*s)) return false;
+    char *end;
+    errno = 0;
+    unsigned long v = strtoul(s, &end, 10);
+    if (*end || errno || v > UINT32_MAX) return false;
+    *out = (unsigned int)v;
+    return true;
+}
+
+static bool parse_bool(const char *s, bool *out) {
+    if (!s || !strcmp(s, "true") || !strcmp(s, "yes") || !strcmp(s, "on") || !strcmp(s, "1")) *out = true;
+    else if (!strcmp(s, "false") || !strcmp(s, "no") || !strcmp(s, "off") || !strcmp(s, "0")) *out = false;
+    else return false;
+    return true;
+}
+
+// Every item of a comma-separated list is a registry name, followed by =MS with `ms`.
+static bool valid_list(const char *s, bool ms) {
+    if (!s || !*s) return false;
+    for (;;) {
+        size_t len = strcspn(s, ms ? "=," : ",");
+        char name[32];
+        if (len == 0 || len >= sizeof(name)) return false;
+        memcpy(name, s, len);
+        name[len] = '\0';
+        if (collector_find(name) < 0) return false;
+        s += len;
+        if (ms) {
+            if (*s++ != '=' || !isdigit((unsigned char)*s)) return false;
+            unsigned long v = strtoul(s, (char **)&s, 10);
+            if (v == 0 || v > UINT32_MAX) return false;
+        }
+        if (*s == '\0') return true;
+        if (*s++ != ',') return false;
+    }
+}
+
+static bool set_key(monitor_config_t *cfg, const setting_t *k, const char *v) {
+    unsigned int u;
+    bool b;
+    switch (k->type) {
+    case T_UINT: return parse_uint(v, AT(cfg, k, unsigned int));
+    case T_POS:
+        if (!parse_uint(v, &u) || u == 0) return false;
+        *AT(cfg, k, unsigned int) = u;
+        return true;
+    case T_PCT: {
+        char *end;
+        if (!v || !*v) return false;
+        double d = strtod(v, &end);
+        if (*end || d != d) return false;
+        *AT(cfg, k, double) = d;
+        return true;
+    }
+    case T_ON:
+    case T_OFF:
+        if (!parse_bool(v, &b)) return false;
+        *AT(cfg, k, bool) = k->type == T_ON ? b : !b;
+        return true;
+    case T_STR:
+        if (!v || !*v) return false;
+        *AT(cfg, k, const char *) = v;
+        return true;
+    case T_NULL:
+        if (!parse_bool(v, &b) || !b) return false;
+        *AT(cfg, k, const char *) = NULL;
+        return true;
+    case T_WINDOW: {
+        int w;
+        if (!parse_uint(v, &u) || (w = agg_window_from_seconds(u)) < 0) return false;
+        *AT(cfg, k, unsigned int) = (unsigned int)w;
+        return true;
+    }
+    case T_FORMAT:
+        if (!v) return false;
+        if (!strcmp(v, "tsdb")) cfg->log_format = LOG_TSDB;
+        else if (!strcmp(v, "text")) cfg->log_format = LOG_TEXT;
+        else if (!strcmp(v, "binary")) cfg->log_format = LOG_BINARY;
+        else return false;
+        return true;
+    case T_PSI: {
+        unsigned int stall, window;
+        char tail;
+        if (v && !strcmp(v, "off")) { cfg->psi_window_ms = 0; return true; }
+        if (!v || sscanf(v, "%u/%u%c", &stall, &window, &tail) != 2) return false;
+        cfg->psi_stall_ms = stall;
+        cfg->psi_window_ms = window;
+        return true;
+    }
+    case T_SOCKET:
+        if (v && !*v) return false;
+        cfg->metrics_socket = v ? v : MSRV_DEFAULT_PATH;
+        return true;
+    case T_NAMES:
+    case T_INTERVALS:
+        if (!valid_list(v, k->type == T_INTERVALS)) return false;
+        *AT(cfg, k, const char *) = v;
+        return true;
+    }
+    return false;
+}
+
+int monitor_config_set(monitor_config_t *cfg, const char *key, const char *value) {
+    for (size_t i = 0; i < NKEYS; i++) {
+        if (strcmp(keys[i].key, key) != 0) continue;
+        if (set_key(cfg, &keys[i], value)) return 0;
+        errno = EINVAL;
+        return -1;
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+int monitor_config_arg(monitor_config_t *cfg, const char *arg) {
+    char key[32];
+    if (strncmp(arg, "--", 2) != 0) { errno = ENOENT; return -1; }
+    const char *eq = strchr(arg, '=');
+    size_t len = eq ? (size_t)(eq - arg) - 2 : strlen(arg + 2);
+    if (len >= sizeof(key)) { errno = ENOENT; return -1; }
+    memcpy(key, arg + 2, len);
+    key[len] = '\0';
+    return monitor_config_set(cfg, key, eq ? eq + 1 : NULL);
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+    return s;
+}
+
+int monitor_config_load(monitor_config_t *cfg, const char *path, char **text) {
+    *text = NULL;
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return -1; }
+    size_t len = 0, cap = 4096;
+    char *buf = malloc(cap);
+    for (size_t n; buf && (n = fread(buf + len, 1, cap - 1 - len, f)) > 0;) {
+        len += n;
+        if (cap - 1 - len == 0) {
+            char *grown = realloc(buf, cap *= 2);
+            if (!grown) { free(buf); buf = NULL; break; }
+            buf = grown;
+        }
+    }
+    bool failed = ferror(f);
+    fclose(f);
+    if (!buf || failed) { perror(path); free(buf); return -1; }
+    buf[len] = '\0';
+    *text = buf;
+
+    int lineno = 0;
+    for (char *line = buf, *next; line; line = next) {
+        lineno++;
+        if ((next = strchr(line, '\n'))) *next++ = '\0';
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *eq = strchr(line, '=');
+        if (eq) *eq = '\0';
+        char *key = trim(line), *value = eq ? trim(eq + 1) : NULL;
+        if (!*key) continue;
+        if (monitor_config_set(cfg, key, value) != 0) {
+            fprintf(stderr, "%s:%d: %s '%s'\n", path, lineno, errno == ENOENT ? "unknown setting" : "bad value for", key);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static bool same_str(const char *a, const char *b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+static bool same(const setting_t *k, const monitor_config_t *a, const monitor_config_t *b) {
+    switch (k->type) {
+    case T_PCT: return *AT(a, k, double) == *AT(b, k, double);
+    case T_ON:
+    case T_OFF: return *AT(a, k, bool) == *AT(b, k, bool);
+    case T_STR:
+    case T_NULL:
+    case T_SOCKET:
+    case T_NAMES:
+    case T_INTERVALS: return same_str(*AT(a, k, const char *), *AT(b, k, const char *));
+    case T_FORMAT: return a->log_format == b->log_format;
+    case T_PSI: return a->psi_stall_ms == b->psi_stall_ms && a->psi_window_ms == b->psi_window_ms;
+    default: return *AT(a, k, unsigned int) == *AT(b, k, unsigned int);
+    }
+}
+
+int monitor_config_reload(monitor_ctx_t *ctx) {
+    static char *intervals; // the reloaded `intervals`, owned here once a reload sets it
+    const char *path = ctx->cfg.config_path;
+    monitor_config_t next;
+    monitor_config_defaults(&next);
+    next.config_path = path;
+    char *text;
+    if (monitor_config_load(&next, path, &text) != 0) {
+        fprintf(stderr, "%s: reload failed, keeping the running config\n", path);
+        free(text);
+        return -1;
+    }
+    for (int i = 0; i < ctx->noverrides; i++) monitor_config_arg(&next, ctx->overrides[i]); // checked at startup
+    char *iv = next.intervals ? strdup(next.intervals) : NULL;
+    if (next.intervals && !iv) { perror("strdup"); free(text); return -1; }
+
+    pthread_mutex_lock(&ctx->cfg_lock);
+    for (size_t i = 0; i < NKEYS; i++) {
+        const setting_t *k = &keys[i];
+        if (same(k, &ctx->cfg, &next)) continue;
+        if (k->live) {
+            switch (k->type) {
+            case T_PCT: *AT(&ctx->cfg, k, double) = *AT(&next, k, double); break;
+            case T_ON: *AT(&ctx->cfg, k, bool) = *AT(&next, k, bool); break;
+            case T_INTERVALS: break; // below
+            default: *AT(&ctx->cfg, k, unsigned int) = *AT(&next, k, unsigned int); break;
+            }
+            continue;
+        }
+        bool reported = false; // no-psi / no-cgroups share their field with another key
+        for (size_t j = 0; j < i; j++) reported |= keys[j].off == k->off;
+        if (!reported) fprintf(stderr, "%s: %s changed, restart to apply\n", path, k->key);
+    }
+    ctx->cfg.intervals = iv;
+    free(intervals);
+    intervals = iv;
+    atomic_fetch_add_explicit(&ctx->cfg_gen, 1, memory_order_release);
+    pthread_mutex_unlock(&ctx->cfg_lock);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,103 @@
+#define _GNU_SOURCE
+#include "monitor.h"
+#include "log_archive.h"
+#include "log_sink.h"
+#include "monitor_config.h"
+#include "shm_metrics.h"
+#include "tsdb.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+// Standalone monitor: a config file and command-line options (monitor_config.h) on
+// top of libsysmon's monitor_run. Options override the file; SIGHUP re-reads it.
+// --compact runs one log archive pass (log_archive.h) and exits.
+
+static int usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--config=FILE] [--compact] [--event-loop] [--log-format=tsdb|text|binary] [--log-path=PATH] [--log-flush-ms=N] [--log-direct]\n"
+                    "       [--log-rotate-mb=N] [--log-rotate-s=N] [--log-keep=N] [--log-segments=N] [--no-log-archive]\n"
+                    "       [--mq-summary] [--socket[=PATH]] [--shm-name=NAME] [--collectors=NAME,...] [--intervals=NAME=MS,...]\n"
+                    "       [--sample-ms=N] [--adaptive] [--sample-min-ms=N] [--sample-max-ms=N] [--summary-s=N] [--no-per-core]\n"
+                    "       [--disks=PATTERNS] [--ifaces=PATTERNS] [--no-per-device] [--netlink]\n"
+                    "       [--no-psi] [--psi-trigger=STALL_MS/WINDOW_MS|off] [--cgroup-root=DIR] [--no-cgroups]\n"
+                    "       [--cpu-alert=PCT] [--mem-alert=PCT] [--alert-window=1|10|60|300] [--alert-hysteresis=PCT]\n"
+                    "       [--proc-top=K] [--proc-interval-ms=N] [--proc-budget-us=N] [--trace=FILE]\n", argv0);
+    return 2;
+}
+
+// Whether data/monitor.pid names a live process, which then owns the live logs.
+static bool monitor_running(void) {
+    FILE *f = fopen("data/monitor.pid", "r");
+    int pid = 0;
+    if (f) {
+        if (fscanf(f, "%d", &pid) != 1) pid = 0;
+        fclose(f);
+    }
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+int main(int argc, char **argv) {
+    monitor_ctx_t ctx = {0};
+    monitor_config_defaults(&ctx.cfg);
+    bool compact = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--config=", 9) == 0 && argv[i][9]) ctx.cfg.config_path = argv[i] + 9;
+        else if (strncmp(argv[i], "--config", 8) == 0) return usage(argv[0]);
+    }
+    if (!ctx.cfg.config_path && access(MONITOR_CONFIG_DEFAULT_PATH, F_OK) == 0) ctx.cfg.config_path = MONITOR_CONFIG_DEFAULT_PATH;
+    char *config_text = NULL;
+    if (ctx.cfg.config_path && monitor_config_load(&ctx.cfg, ctx.cfg.config_path, &config_text) != 0) return 2;
+    // Kept for SIGHUP, which re-applies them over the re-read file.
+    const char **overrides = calloc((size_t)argc, sizeof(*overrides));
+    if (!overrides) { perror("calloc"); return 1; }
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--config=", 9) == 0) continue;
+        if (strcmp(argv[i], "--compact") == 0) { compact = true; continue; }
+        if (monitor_config_arg(&ctx.cfg, argv[i]) != 0) {
+            if (errno == EINVAL) fprintf(stderr, "bad value: %s\n", argv[i]);
+            return usage(argv[0]);
+        }
+        overrides[ctx.noverrides++] = argv[i];
+    }
+    ctx.overrides = overrides;
+    if (compact) {
+        // A running monitor rotates its own logs; only segments it has closed are touched.
+        int n = log_archive_run(&ctx.cfg, !monitor_running());
+        if (n >= 0) printf("Compacted %d log files\n", n);
+        free(config_text);
+        free(overrides);
+        return n < 0 ? 1 : 0;
+    }
+    snprintf(ctx.mq_name, sizeof(ctx.mq_name), "/sysmon_queue");
+
+    // Populated cgroups hold three fds each and the process scan keeps up to half the
+    // soft limit open, so both get the hard limit to work with.
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    // Ensure log directory exists
+    mkdir("data", 0755);
+    mkdir("data/logs", 0755);
+
+    printf("Resource Monitor started. Press Ctrl+C to stop.\n");
+    if (ctx.cfg.config_path) printf("Config %s (kill -HUP %d to reload)\n", ctx.cfg.config_path, (int)getpid());
+    printf("Logging to %s\n", ctx.cfg.log_path ? ctx.cfg.log_path : ctx.cfg.log_format == LOG_BINARY ? BINARY_LOG_PATH :
+                               ctx.cfg.log_format == LOG_TEXT ? TEXT_LOG_PATH : TSDB_DEFAULT_DIR);
+    printf("Publishing live metrics to shared memory %s\n", ctx.cfg.shm_name ? ctx.cfg.shm_name : SHM_METRICS_NAME);
+    if (ctx.cfg.trace_path) printf("Capturing CPU bursts to %s\n", ctx.cfg.trace_path);
+    if (ctx.cfg.metrics_socket) printf("Serving metrics on %s\n", ctx.cfg.metrics_socket);
+    if (ctx.cfg.mq_summary) printf("Sending summaries to POSIX mq %s (if available)\n", ctx.mq_name);
+    int rc = monitor_run(&ctx);
+    free(config_text);
+    free(overrides);
+    return rc;
+}
@@ -0,0 +1,54 @@
+#define _GNU_SOURCE
+#include "pressure.h"
+#include "proc_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+const char *psi_file(psi_resource_t r) {
+    static const char *names[PSI_RESOURCES] = { "cpu", "memory", "io" };
+    return (unsigned)r < PSI_RESOURCES ? names[r] : NULL;
+}
+
+// The "total=" field of each line; "full" is absent for cpu before Linux 5.13.
+int parse_psi(const char *buf, psi_totals_t *t) {
+    int found = 0;
+    t->some_us = t->full_us = 0;
+    for (const char *p = buf; *p; p = pr_next_line(p)) {
+        unsigned long long *dst = pr_starts_with(p, "some ") ? &t->some_us : pr_starts_with(p, "full ") ? &t->full_us : NULL;
+        if (!dst) continue;
+        for (const char *q = p; *q && *q != '\n'; q = pr_skip_token(q)) {
+            q = pr_skip_blanks(q);
+            if (!pr_starts_with(q, "total=")) continue;
+            q += 6;
+            found += pr_next_u64(&q, dst);
+            break;
+        }
+    }
+    return found > 0 ? 0 : -1;
+}
+
+static int write_trigger(int fd, bool full, unsigned int stall_us, unsigned int window_us) {
+    char req[64];
+    int n = snprintf(req, sizeof(req), "%s %u %u", full ? "full" : "some", stall_us, window_us);
+    return write(fd, req, (size_t)n + 1) < 0 ? -1 : 0; // the NUL is part of the request
+}
+
+int psi_trigger_open(const char *path, bool full, unsigned int stall_us, unsigned int *window_us) {
+    int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) return -1;
+    if (write_trigger(fd, full, stall_us, *window_us) == 0) return fd;
+    // Without CAP_SYS_RESOURCE the window must be a multiple of 2 s: round it up and
+    // scale the stall to keep the ratio.
+    unsigned int w = (*window_us + 1999999) / 2000000 * 2000000;
+    if (errno == EINVAL && w != *window_us &&
+        write_trigger(fd, full, (unsigned int)((unsigned long long)stall_us * w / *window_us), w) == 0) {
+        *window_us = w;
+        return fd;
+    }
+    close(fd);
+    return -1;
+}
@@ -0,0 +1,46 @@
+#define _GNU_SOURCE
+#include "proc_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int pf_open(proc_file_t *pf, const char *path, size_t initial_cap) {
+    pf->fd = -1; pf->buf = NULL; pf->cap = 0; pf->len = 0;
+    if (initial_cap < 256) initial_cap = 256;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    char *buf = malloc(initial_cap);
+    if (!buf) { close(fd); return -1; }
+    pf->fd = fd; pf->buf = buf; pf->cap = initial_cap;
+    buf[0] = '\0';
+    return 0;
+}
+
+ssize_t pf_read(proc_file_t *pf) {
+    if (pf->fd < 0) return -1;
+    for (;;) {
+        ssize_t n = pread(pf->fd, pf->buf, pf->cap - 1, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        // A full buffer means the file may have been truncated: grow and re-read.
+        if ((size_t)n == pf->cap - 1) {
+            char *nb = realloc(pf->buf, pf->cap * 2);
+            if (!nb) return -1;
+            pf->buf = nb; pf->cap *= 2;
+            continue;
+        }
+        pf->buf[n] = '\0';
+        pf->len = (size_t)n;
+        return n;
+    }
+}
+
+void pf_close(proc_file_t *pf) {
+    if (pf->fd >= 0) close(pf->fd);
+    free(pf->buf);
+    pf->fd = -1; pf->buf = NULL; pf->cap = pf->len = 0;
+}
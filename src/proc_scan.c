@@ -0,0 +1,442 @@
+#define _GNU_SOURCE
+#include "proc_scan.h"
+#include "proc_reader.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#define FD_NONE   (-1) // not open; opened on the next sample
+#define FD_DENIED (-2) // io is not readable for this pid (other user's process)
+
+#define DENTS_BUF (64 * 1024)
+#define CLOCK_EVERY 32 // entries sampled between budget checks
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+typedef struct {
+    uint32_t pid;
+    uint32_t seen;       // listing generation the pid was last present in
+    int stat_fd, io_fd;
+    uint64_t start;      // starttime, to notice pid reuse
+    uint64_t ticks;      // utime + stime
+    uint64_t rd, wr;     // read_bytes, write_bytes
+    uint64_t ts_ns;      // when the counters above were read
+    uint64_t rss_bytes;
+    double cpu_pct, read_bps, write_bps;
+    int32_t nice;
+    bool have_prev, have_rate;
+    bool born;           // appeared after the first listing, so it started during the scan
+} proc_entry_t;
+
+typedef struct { double key; uint32_t idx; } heap_item_t;
+
+struct proc_scan {
+    int root_fd;
+    int top_k;
+    size_t max_fds, open_fds;
+    long hz;
+    uint64_t page_size;
+    char *dents;
+    int32_t *slots;      // open-addressing pid -> entry index, -1 = empty
+    size_t slot_mask;
+    proc_entry_t *ent;
+    size_t n, cap;
+    size_t cursor;       // round-robin position for budget-limited ticks
+    uint32_t gen;
+    heap_item_t *heap;
+    proc_top_t *top[PROC_RANK_COUNT];
+    size_t ntop[PROC_RANK_COUNT];
+    bool track_bursts;
+    proc_burst_t *bursts;
+    size_t nbursts, bursts_cap;
+    proc_scan_stats_t stats;
+    char buf[4096];
+};
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// ---- pid hash ----
+
+static size_t pid_hash(const proc_scan_t *ps, uint32_t pid) {
+    return (size_t)(pid * 2654435761u) & ps->slot_mask;
+}
+
+static size_t slot_find(const proc_scan_t *ps, uint32_t pid) {
+    size_t i = pid_hash(ps, pid);
+    while (ps->slots[i] >= 0 && ps->ent[ps->slots[i]].pid != pid) i = (i + 1) & ps->slot_mask;
+    return i;
+}
+
+static int slots_resize(proc_scan_t *ps, size_t nslots) {
+    int32_t *s = malloc(nslots * sizeof(*s));
+    if (!s) return -1;
+    memset(s, 0xff, nslots * sizeof(*s));
+    free(ps->slots);
+    ps->slots = s;
+    ps->slot_mask = nslots - 1;
+    for (size_t i = 0; i < ps->n; i++) ps->slots[slot_find(ps, ps->ent[i].pid)] = (int32_t)i;
+    return 0;
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones.
+static void slot_erase(proc_scan_t *ps, size_t i) {
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & ps->slot_mask;
+        if (ps->slots[j] < 0) break;
+        size_t k = pid_hash(ps, ps->ent[ps->slots[j]].pid);
+        bool movable = (i <= j) ? (k <= i || k > j) : (k <= i && k > j);
+        if (movable) { ps->slots[i] = ps->slots[j]; i = j; }
+    }
+    ps->slots[i] = -1;
+}
+
+static void close_entry_fds(proc_scan_t *ps, proc_entry_t *e) {
+    if (e->stat_fd >= 0) { close(e->stat_fd); ps->open_fds--; }
+    if (e->io_fd >= 0) { close(e->io_fd); ps->open_fds--; }
+}
+
+static int entry_add(proc_scan_t *ps, size_t slot, uint32_t pid) {
+    if (ps->n == ps->cap) {
+        size_t nc = ps->cap ? ps->cap * 2 : 1024;
+        proc_entry_t *ne = realloc(ps->ent, nc * sizeof(*ne));
+        if (!ne) return -1;
+        ps->ent = ne; ps->cap = nc;
+    }
+    if ((ps->n + 1) * 2 > ps->slot_mask + 1) {
+        if (slots_resize(ps, (ps->slot_mask + 1) * 2) != 0) return -1;
+        slot = slot_find(ps, pid);
+    }
+    proc_entry_t *e = &ps->ent[ps->n];
+    memset(e, 0, sizeof(*e));
+    e->pid = pid; e->seen = ps->gen;
+    e->born = ps->gen > 1;
+    e->stat_fd = e->io_fd = FD_NONE;
+    ps->slots[slot] = (int32_t)ps->n++;
+    return 0;
+}
+
+// Drops entry idx and moves the last entry into its place.
+static void entry_remove(proc_scan_t *ps, size_t idx) {
+    proc_entry_t *e = &ps->ent[idx];
+    close_entry_fds(ps, e);
+    slot_erase(ps, slot_find(ps, e->pid));
+    size_t last = --ps->n;
+    if (idx != last) {
+        ps->ent[idx] = ps->ent[last];
+        ps->slots[slot_find(ps, ps->ent[idx].pid)] = (int32_t)idx;
+    }
+}
+
+// ---- listing ----
+
+static bool parse_pid(const char *name, uint32_t *pid) {
+    uint32_t v = 0;
+    if (*name < '1' || *name > '9') return false;
+    for (; *name; name++) {
+        if (*name < '0' || *name > '9') return false;
+        v = v * 10 + (uint32_t)(*name - '0');
+    }
+    *pid = v;
+    return true;
+}
+
+static int list_pids(proc_scan_t *ps) {
+    if (lseek(ps->root_fd, 0, SEEK_SET) < 0) return -1;
+    ps->gen++;
+    for (;;) {
+        long nread = syscall(SYS_getdents64, ps->root_fd, ps->dents, DENTS_BUF);
+        if (nread < 0) { if (errno == EINTR) continue; return -1; }
+        if (nread == 0) break;
+        for (long off = 0; off < nread;) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(ps->dents + off);
+            off += d->d_reclen;
+            uint32_t pid;
+            if ((d->d_type != DT_DIR && d->d_type != DT_UNKNOWN) || !parse_pid(d->d_name, &pid)) continue;
+            size_t slot = slot_find(ps, pid);
+            if (ps->slots[slot] >= 0) ps->ent[ps->slots[slot]].seen = ps->gen;
+            else if (entry_add(ps, slot, pid) != 0) return -1;
+        }
+    }
+    // Backwards, so the entry swapped into a hole has already been checked.
+    for (size_t i = ps->n; i-- > 0;)
+        if (ps->ent[i].seen != ps->gen) entry_remove(ps, i);
+    if (ps->cursor >= ps->n) ps->cursor = 0;
+    return 0;
+}
+
+// ---- sampling ----
+
+// Reads /proc/<pid>/<name> into ps->buf. Cached fds are re-read with pread; otherwise
+// the file is opened relative to the root fd and kept if the fd budget allows. A cached
+// fd that fails belongs to a process that exited, so it is dropped and the path opened
+// again, which finds a new process that has taken the pid since.
+static ssize_t read_pid_file(proc_scan_t *ps, int *fd, uint32_t pid, const char *name) {
+    ssize_t n = -1;
+    if (*fd >= 0) {
+        n = pread(*fd, ps->buf, sizeof(ps->buf) - 1, 0);
+        if (n <= 0) { close(*fd); *fd = FD_NONE; ps->open_fds--; }
+    }
+    if (*fd < 0) {
+        char path[32];
+        snprintf(path, sizeof(path), "%u/%s", pid, name);
+        int f = openat(ps->root_fd, path, O_RDONLY | O_CLOEXEC);
+        if (f < 0) return -1;
+        n = pread(f, ps->buf, sizeof(ps->buf) - 1, 0);
+        if (n > 0 && ps->open_fds < ps->max_fds) { *fd = f; ps->open_fds++; }
+        else close(f);
+    }
+    if (n < 0) return -1;
+    ps->buf[n] = '\0';
+    return n;
+}
+
+typedef struct {
+    uint64_t ticks, start, rss_pages;
+    int32_t nice;
+} stat_fields_t;
+
+// utime, stime, nice, starttime and rss from /proc/<pid>/stat. comm may contain spaces
+// and parentheses, so fields are counted from the last ')'.
+static bool parse_stat(const char *buf, stat_fields_t *out) {
+    const char *p = strrchr(buf, ')');
+    if (!p) return false;
+    p++;
+    for (int f = 3; f <= 13; f++) p = pr_skip_token(p);
+    unsigned long long ut, st, nice, sv, rss;
+    if (!pr_next_u64(&p, &ut) || !pr_next_u64(&p, &st)) return false;
+    for (int f = 16; f <= 18; f++) p = pr_skip_token(p);
+    p = pr_skip_blanks(p);
+    bool neg = *p == '-';
+    if (neg) p++;
+    if (!pr_next_u64(&p, &nice)) return false;
+    for (int f = 20; f <= 21; f++) p = pr_skip_token(p);
+    if (!pr_next_u64(&p, &sv)) return false;
+    p = pr_skip_token(p); // vsize
+    if (!pr_next_u64(&p, &rss)) return false;
+    out->ticks = ut + st; out->start = sv; out->rss_pages = rss;
+    out->nice = neg ? -(int32_t)nice : (int32_t)nice;
+    return true;
+}
+
+static void parse_io(const char *p, uint64_t *rd, uint64_t *wr) {
+    unsigned long long v;
+    for (; *p; p = pr_next_line(p)) {
+        if (pr_starts_with(p, "read_bytes:")) {
+            p += 11;
+            if (pr_next_u64(&p, &v)) *rd = v;
+        } else if (pr_starts_with(p, "write_bytes:")) {
+            p += 12;
+            if (pr_next_u64(&p, &v)) *wr = v;
+            return;
+        }
+    }
+}
+
+static void add_burst(proc_scan_t *ps, uint32_t pid, uint64_t ticks, int32_t nice) {
+    if (ps->nbursts == ps->bursts_cap) {
+        size_t nc = ps->bursts_cap ? ps->bursts_cap * 2 : 256;
+        proc_burst_t *nb = realloc(ps->bursts, nc * sizeof(*nb));
+        if (!nb) return;
+        ps->bursts = nb; ps->bursts_cap = nc;
+    }
+    ps->bursts[ps->nbursts++] = (proc_burst_t){ pid, ticks > UINT32_MAX ? UINT32_MAX : (uint32_t)ticks, nice };
+}
+
+static void sample_entry(proc_scan_t *ps, proc_entry_t *e, uint64_t now) {
+    stat_fields_t sf;
+    if (read_pid_file(ps, &e->stat_fd, e->pid, "stat") <= 0 || !parse_stat(ps->buf, &sf)) {
+        e->have_prev = e->have_rate = false; // exited; dropped by the next listing
+        return;
+    }
+    uint64_t rd = e->rd, wr = e->wr;
+    if (e->io_fd != FD_DENIED) {
+        if (read_pid_file(ps, &e->io_fd, e->pid, "io") > 0) parse_io(ps->buf, &rd, &wr);
+        else if (errno == EACCES || errno == EPERM) e->io_fd = FD_DENIED;
+    }
+    bool same = e->have_prev && e->start == sf.start;
+    if (ps->track_bursts) {
+        // A pid seen before the scan started only gives a baseline; one that started
+        // since (or reused a pid) counts all its CPU time.
+        uint64_t used = same ? sf.ticks - e->ticks : (e->born || e->have_prev) ? sf.ticks : 0;
+        if (used > 0) add_burst(ps, e->pid, used, sf.nice);
+    }
+    if (same && now > e->ts_ns) {
+        double dt = (double)(now - e->ts_ns) / 1e9;
+        e->cpu_pct = (double)(sf.ticks - e->ticks) / (double)ps->hz / dt * 100.0;
+        e->read_bps = (double)(rd - e->rd) / dt;
+        e->write_bps = (double)(wr - e->wr) / dt;
+        e->have_rate = true;
+    } else {
+        e->have_rate = false; // first sight, or the pid was reused
+    }
+    e->start = sf.start; e->ticks = sf.ticks; e->rd = rd; e->wr = wr; e->ts_ns = now;
+    e->nice = sf.nice;
+    e->rss_bytes = sf.rss_pages * ps->page_size;
+    e->have_prev = true;
+}
+
+// ---- top-K ----
+
+static void heap_sift_down(heap_item_t *h, size_t n, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, m = i;
+        if (l < n && h[l].key < h[m].key) m = l;
+        if (l + 1 < n && h[l + 1].key < h[m].key) m = l + 1;
+        if (m == i) return;
+        heap_item_t t = h[i]; h[i] = h[m]; h[m] = t;
+        i = m;
+    }
+}
+
+static void heap_offer(heap_item_t *h, size_t *n, size_t k, double key, uint32_t idx) {
+    if (*n < k) {
+        size_t i = (*n)++;
+        h[i] = (heap_item_t){ key, idx };
+        while (i > 0 && h[(i - 1) / 2].key > h[i].key) {
+            heap_item_t t = h[i]; h[i] = h[(i - 1) / 2]; h[(i - 1) / 2] = t;
+            i = (i - 1) / 2;
+        }
+    } else if (key > h[0].key) {
+        h[0] = (heap_item_t){ key, idx };
+        heap_sift_down(h, *n, 0);
+    }
+}
+
+static double rank_key(const proc_entry_t *e, proc_rank_t by) {
+    switch (by) {
+        case PROC_BY_CPU: return e->have_rate ? e->cpu_pct : 0.0;
+        case PROC_BY_RSS: return e->have_prev ? (double)e->rss_bytes : 0.0;
+        case PROC_BY_IO:  return e->have_rate ? e->read_bps + e->write_bps : 0.0;
+        default: return 0.0;
+    }
+}
+
+static void rank(proc_scan_t *ps, proc_rank_t by) {
+    size_t k = (size_t)ps->top_k, n = 0;
+    for (size_t i = 0; i < ps->n; i++) {
+        double key = rank_key(&ps->ent[i], by);
+        if (key > 0) heap_offer(ps->heap, &n, k, key, (uint32_t)i);
+    }
+    // Pop the min-heap from the back of the output so it ends up highest first.
+    ps->ntop[by] = n;
+    while (n > 0) {
+        const proc_entry_t *e = &ps->ent[ps->heap[0].idx];
+        ps->top[by][--n] = (proc_top_t){ e->pid, e->cpu_pct, e->rss_bytes, e->read_bps, e->write_bps };
+        ps->heap[0] = ps->heap[n];
+        heap_sift_down(ps->heap, n, 0);
+    }
+}
+
+// ---- API ----
+
+proc_scan_t *proc_scan_open(const char *root, int top_k, size_t max_fds) {
+    if (top_k < 1) top_k = 1;
+    proc_scan_t *ps = calloc(1, sizeof(*ps));
+    if (!ps) return NULL;
+    ps->root_fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    ps->dents = malloc(DENTS_BUF);
+    ps->heap = calloc((size_t)top_k, sizeof(heap_item_t));
+    for (int r = 0; r < PROC_RANK_COUNT; r++) ps->top[r] = calloc((size_t)top_k, sizeof(proc_top_t));
+    if (ps->root_fd < 0 || !ps->dents || !ps->heap || !ps->top[PROC_BY_CPU] || !ps->top[PROC_BY_RSS] ||
+        !ps->top[PROC_BY_IO] || slots_resize(ps, 4096) != 0) {
+        proc_scan_close(ps);
+        return NULL;
+    }
+    if (max_fds == 0) {
+        struct rlimit rl;
+        max_fds = (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) ? rl.rlim_cur / 2 : 512;
+    }
+    ps->top_k = top_k;
+    ps->max_fds = max_fds;
+    ps->hz = sysconf(_SC_CLK_TCK);
+    if (ps->hz <= 0) ps->hz = 100;
+    long pg = sysconf(_SC_PAGESIZE);
+    ps->page_size = pg > 0 ? (uint64_t)pg : 4096;
+    return ps;
+}
+
+int proc_scan_tick(proc_scan_t *ps, uint64_t budget_us) {
+    uint64_t t0 = mono_ns();
+    if (list_pids(ps) != 0) return -1;
+    uint64_t t1 = mono_ns();
+    uint64_t deadline = budget_us ? t0 + budget_us * 1000ULL : UINT64_MAX;
+    ps->nbursts = 0;
+
+    size_t done = 0, n = ps->n;
+    uint64_t now = t1;
+    while (done < n) {
+        if (done % CLOCK_EVERY == 0 && done > 0) {
+            now = mono_ns();
+            if (now >= deadline) break;
+        }
+        sample_entry(ps, &ps->ent[ps->cursor], now);
+        if (++ps->cursor >= n) ps->cursor = 0;
+        done++;
+    }
+    uint64_t t2 = mono_ns();
+    for (int r = 0; r < PROC_RANK_COUNT; r++) rank(ps, (proc_rank_t)r);
+
+    ps->stats.npids = n;
+    ps->stats.sampled = done;
+    ps->stats.cached_fds = ps->open_fds;
+    ps->stats.list_ns = t1 - t0;
+    ps->stats.sample_ns = t2 - t1;
+    ps->stats.rank_ns = mono_ns() - t2;
+    ps->stats.budget_hit = done < n;
+    return (int)done;
+}
+
+size_t proc_scan_top(const proc_scan_t *ps, proc_rank_t by, const proc_top_t **out) {
+    if ((unsigned)by >= PROC_RANK_COUNT) { *out = NULL; return 0; }
+    *out = ps->top[by];
+    return ps->ntop[by];
+}
+
+void proc_scan_track_bursts(proc_scan_t *ps, bool on) {
+    ps->track_bursts = on;
+}
+
+size_t proc_scan_bursts(const proc_scan_t *ps, const proc_burst_t **out) {
+    *out = ps->bursts;
+    return ps->nbursts;
+}
+
+long proc_scan_hz(const proc_scan_t *ps) {
+    return ps->hz;
+}
+
+void proc_scan_get_stats(const proc_scan_t *ps, proc_scan_stats_t *out) {
+    *out = ps->stats;
+}
+
+void proc_scan_close(proc_scan_t *ps) {
+    if (!ps) return;
+    for (size_t i = 0; i < ps->n; i++) close_entry_fds(ps, &ps->ent[i]);
+    if (ps->root_fd >= 0) close(ps->root_fd);
+    for (int r = 0; r < PROC_RANK_COUNT; r++) free(ps->top[r]);
+    free(ps->dents);
+    free(ps->slots);
+    free(ps->ent);
+    free(ps->heap);
+    free(ps->bursts);
+    free(ps);
+}
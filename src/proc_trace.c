@@ -0,0 +1,85 @@
+#define _GNU_SOURCE
+#include "proc_trace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct proc_trace {
+    int fd;
+    uint64_t last;     // time of the last block
+    uint64_t records, bytes;
+    uint8_t *buf;
+    size_t cap;
+};
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v) {
+    while (v >= 0x80) { *p++ = (uint8_t)(v | 0x80); v >>= 7; }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int write_all(proc_trace_t *t, const uint8_t *p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(t->fd, p, n);
+        if (w < 0) { if (errno == EINTR) continue; return -1; }
+        p += w; n -= (size_t)w;
+        t->bytes += (uint64_t)w;
+    }
+    return 0;
+}
+
+proc_trace_t *proc_trace_open(const char *path, uint32_t hz) {
+    proc_trace_t *t = calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    t->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    uint8_t hdr[12];
+    memcpy(hdr, PROC_TRACE_MAGIC, 8);
+    for (int i = 0; i < 4; i++) hdr[8 + i] = (uint8_t)(hz >> (8 * i));
+    if (t->fd < 0 || write_all(t, hdr, sizeof(hdr)) != 0) {
+        if (t->fd >= 0) close(t->fd);
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+int proc_trace_append(proc_trace_t *t, uint64_t ticks, const proc_burst_t *b, size_t n) {
+    if (n == 0) return 0;
+    // Worst case 10 bytes per varint: two for the block, three per record.
+    size_t need = 20 + n * 30;
+    if (need > t->cap) {
+        uint8_t *nb = realloc(t->buf, need);
+        if (!nb) return -1;
+        t->buf = nb; t->cap = need;
+    }
+    if (ticks < t->last) ticks = t->last;
+    uint8_t *p = put_varint(t->buf, ticks - t->last);
+    p = put_varint(p, n);
+    for (size_t i = 0; i < n; i++) {
+        p = put_varint(p, b[i].pid);
+        p = put_varint(p, b[i].ticks);
+        p = put_varint(p, zigzag(b[i].nice));
+    }
+    if (write_all(t, t->buf, (size_t)(p - t->buf)) != 0) return -1;
+    t->last = ticks;
+    t->records += n;
+    return 0;
+}
+
+uint64_t proc_trace_records(const proc_trace_t *t) { return t->records; }
+uint64_t proc_trace_bytes(const proc_trace_t *t) { return t->bytes; }
+
+int proc_trace_close(proc_trace_t *t) {
+    if (!t) return 0;
+    int rc = close(t->fd);
+    free(t->buf);
+    free(t);
+    return rc;
+}
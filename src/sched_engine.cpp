@@ -0,0 +1,326 @@
+#include "sched_engine.h"
+#include "indexed_heap.h"
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace {
+
+std::vector<Process> sortedByArrival(const std::vector<Process>& procs) {
+    std::vector<Process> p = procs;
+    std::sort(p.begin(), p.end(), [](auto&a, auto&b){return a.arrival < b.arrival;});
+    return p;
+}
+
+// Appends dispatches to a timeline according to the Gantt mode.
+class GanttWriter {
+public:
+    GanttWriter(std::vector<GanttSlice>& out, GanttMode mode, size_t expected) : out_(&out), mode_(mode) {
+        if (mode_ == GanttMode::Full) out_->reserve(expected);
+    }
+    void add(int pid, int start, int end) {
+        if (mode_ == GanttMode::None) return;
+        auto& g = *out_;
+        if (mode_ == GanttMode::Merged && !g.empty() && g.back().pid == pid && g.back().end == start) {
+            g.back().end = end;
+            return;
+        }
+        g.push_back({pid, start, end});
+    }
+private:
+    std::vector<GanttSlice>* out_;
+    GanttMode mode_;
+};
+
+void finalizeReport(ScheduleReport& rep, double sumW, double sumT, int lastFinish) {
+    if (rep.completed > 0) {
+        rep.avgWaiting = sumW / rep.completed;
+        rep.avgTurnaround = sumT / rep.completed;
+        if (lastFinish>0) rep.throughput = (double)rep.completed/ (double)lastFinish;
+    }
+    for (auto& c : rep.cores)
+        if (lastFinish > 0) c.utilisation = (double)c.busy / (double)lastFinish;
+}
+
+// Batch runs: the arrival-sorted trace is the process table, index k is the k-th
+// arrival, and rows are built once everything has finished.
+class BatchSource {
+public:
+    BatchSource(const std::vector<Process>& procs, RowOrder order)
+        : p_(sortedByArrival(procs)), order_(order), finish_(p_.size()) {
+        if (order_ == RowOrder::Completion) completed_.reserve(p_.size());
+    }
+    std::vector<Process>& table() { return p_; }
+    bool peek(int& arrival) const {
+        if (i_ == p_.size()) return false;
+        arrival = p_[i_].arrival;
+        return true;
+    }
+    int admit() { return (int)i_++; }
+    void finished(int idx, int now) {
+        finish_[idx] = now;
+        if (order_ == RowOrder::Completion) completed_.push_back(idx);
+    }
+    void report(ScheduleReport& rep, int lastFinish) {
+        rep.rows.reserve(p_.size());
+        auto row = [&](int k) {
+            int tat = finish_[k] - p_[k].arrival;
+            rep.rows.push_back({p_[k].pid, tat - p_[k].burst, tat});
+        };
+        if (order_ == RowOrder::Completion) for (int k : completed_) row(k);
+        else for (size_t k = 0; k < p_.size(); k++) row((int)k);
+        double sumW=0,sumT=0;
+        for (auto &r : rep.rows) { sumW += r.waiting; sumT += r.turnaround; }
+        rep.completed = rep.rows.size();
+        finalizeReport(rep, sumW, sumT, lastFinish);
+    }
+
+private:
+    std::vector<Process> p_;
+    RowOrder order_;
+    size_t i_ = 0;
+    std::vector<int> finish_, completed_;
+};
+
+// Streaming runs: a process is pulled from `next` when its arrival comes up, and its
+// slot in the table is reused once it finishes, so the table only ever holds as many
+// processes as were live at once. Only the sums behind the averages are kept.
+class StreamSource {
+public:
+    explicit StreamSource(const std::function<bool(Process&)>& next) : next_(next) {}
+    std::vector<Process>& table() { return p_; }
+    bool peek(int& arrival) {
+        if (!have_) have_ = next_(pending_);
+        if (!have_) return false;
+        arrival = pending_.arrival;
+        return true;
+    }
+    int admit() {
+        have_ = false;
+        if (free_.empty()) { p_.push_back(pending_); return (int)p_.size() - 1; }
+        int idx = free_.back(); free_.pop_back();
+        p_[idx] = pending_;
+        return idx;
+    }
+    void finished(int idx, int now) {
+        int tat = now - p_[idx].arrival;
+        sumW_ += tat - p_[idx].burst;
+        sumT_ += tat;
+        done_++;
+        free_.push_back(idx);
+    }
+    void report(ScheduleReport& rep, int lastFinish) {
+        rep.completed = done_;
+        finalizeReport(rep, sumW_, sumT_, lastFinish);
+    }
+
+private:
+    const std::function<bool(Process&)>& next_;
+    std::vector<Process> p_;
+    std::vector<int> free_;
+    Process pending_{};
+    bool have_ = false;
+    double sumW_ = 0, sumT_ = 0;
+    std::uint64_t done_ = 0;
+};
+
+using CoreEvent = std::pair<int, int>; // (slice end, core)
+
+struct Core {
+    int idx = -1; // -1 = idle
+    int start = 0;
+    int queued = 0; // processes waiting in this CPU's run queue
+    bool dirty = false;
+};
+
+template <class Source>
+ScheduleReport run(Source& src, SchedPolicy& pol, const char* name, const SchedOptions& opt) {
+    std::vector<Process>& p = src.table();
+    ScheduleReport rep; rep.algorithm = name;
+    const int K = std::max(1, opt.cores);
+    const bool movable = K > 1 && opt.affinity == Affinity::Free;
+    const bool stealing = movable && opt.balance == Balance::Steal;
+    const bool periodic = movable && opt.balance == Balance::Periodic;
+    std::vector<int> remaining(p.size()), lastCore(p.size());
+    rep.cores.resize(K);
+    std::vector<GanttWriter> gantt;
+    gantt.reserve(K);
+    if (K == 1) gantt.emplace_back(rep.gantt, opt.gantt, p.size());
+    else for (auto& c : rep.cores) gantt.emplace_back(c.gantt, opt.gantt, p.size() / K + 1);
+    pol.init(p, K);
+
+    // The event queue is four sources merged by time: arrivals (already sorted), the
+    // policy timer, the balance timer, and slice ends in an indexed heap keyed by
+    // (time, core).
+    std::vector<Core> cores(K);
+    IndexedHeap<CoreEvent> sliceEnds(K);
+    std::vector<int> dirty;
+    dirty.reserve(K);
+    int now = 0, next = 0, lastFinish = 0, timer = kNoTimer, balanceAt = kNoTimer;
+    int idle = K;
+    size_t queued = 0;
+
+    auto touch = [&](int c) {
+        if (!cores[c].dirty) { cores[c].dirty = true; dirty.push_back(c); }
+    };
+    auto enqueueOn = [&](int c, int idx, EnqueueReason why) {
+        pol.enqueue(c, idx, now, why, remaining[idx]);
+        cores[c].queued++;
+        queued++;
+        touch(c);
+        if (periodic && balanceAt == kNoTimer) balanceAt = now + std::max(1, opt.balanceInterval);
+    };
+    auto take = [&](int c, bool steal) {
+        int idx = steal ? pol.steal(c, now) : pol.pickNext(c, now);
+        if (idx >= 0) { cores[c].queued--; queued--; }
+        return idx;
+    };
+    auto load = [&](int c) { return cores[c].queued + (cores[c].idx >= 0); };
+    auto place = [&](int idx) {
+        if (K == 1) return 0;
+        if (opt.affinity == Affinity::Pinned) return (p[idx].pid % K + K) % K;
+        int best = 0;
+        for (int c = 1; c < K && load(best) > 0; c++)
+            if (load(c) < load(best)) best = c;
+        return best;
+    };
+    auto admit = [&] {
+        int idx = src.admit();
+        if ((size_t)idx >= remaining.size()) {
+            remaining.resize(p.size());
+            lastCore.resize(p.size());
+            pol.grow(p.size());
+        }
+        remaining[idx] = p[idx].burst;
+        lastCore[idx] = -1;
+        enqueueOn(place(idx), idx, EnqueueReason::Arrival);
+    };
+    // Longest run queue other than `self`, or -1 if every other queue is empty.
+    auto busiest = [&](int self) {
+        int best = -1;
+        for (int c = 0; c < K; c++)
+            if (c != self && cores[c].queued > 0 && (best < 0 || cores[c].queued > cores[best].queued)) best = c;
+        return best;
+    };
+
+    // Ends the slice on CPU c at `now`; the process finishes or goes back to the same queue.
+    auto stop = [&](int c) {
+        Core& core = cores[c];
+        int idx = core.idx;
+        remaining[idx] -= now - core.start;
+        gantt[c].add(p[idx].pid, core.start, now);
+        rep.dispatches++;
+        rep.cores[c].dispatches++;
+        rep.cores[c].busy += now - core.start;
+        bool done = remaining[idx] <= 0;
+        pol.ran(c, idx, core.start, now, done);
+        core.idx = -1;
+        idle++;
+        touch(c);
+        if (done) {
+            lastFinish = now;
+            src.finished(idx, now);
+        } else {
+            enqueueOn(c, idx, EnqueueReason::Requeue);
+        }
+    };
+
+    auto dispatch = [&](int c) {
+        int idx = take(c, false);
+        if (idx < 0 && stealing && queued > 0) {
+            int v = busiest(c);
+            int s = v >= 0 ? take(v, true) : -1;
+            if (s >= 0) { enqueueOn(c, s, EnqueueReason::Migrate); idx = take(c, false); }
+        }
+        if (idx < 0) return;
+        if (lastCore[idx] >= 0 && lastCore[idx] != c) { rep.migrations++; rep.cores[c].migrations++; }
+        lastCore[idx] = c;
+        int run = std::max(0, std::min(pol.slice(c, idx, now), remaining[idx]));
+        cores[c].idx = idx;
+        cores[c].start = now;
+        idle--;
+        sliceEnds.push(c, {now + run, c});
+    };
+
+    // Moves queued processes from the longest queue to the least loaded CPU until the
+    // loads differ by at most one.
+    auto rebalance = [&] {
+        for (;;) {
+            int hi = 0, lo = 0;
+            for (int c = 1; c < K; c++) {
+                if (cores[c].queued > cores[hi].queued) hi = c;
+                if (load(c) < load(lo)) lo = c;
+            }
+            if (cores[hi].queued == 0 || load(hi) - load(lo) <= 1) break;
+            int idx = take(hi, true);
+            if (idx < 0) break;
+            enqueueOn(lo, idx, EnqueueReason::Migrate);
+        }
+    };
+
+    for (;;) {
+        now = INT_MAX;
+        if (src.peek(next)) now = next;
+        if (timer < now) now = timer;
+        if (balanceAt < now) now = balanceAt;
+        if (!sliceEnds.empty() && sliceEnds.topKey().first < now) now = sliceEnds.topKey().first;
+        if (now == INT_MAX) break;
+
+        while (src.peek(next) && next <= now) admit();
+        if (timer == now) {
+            pol.onTimer(now);
+            for (int c = 0; c < K; c++) if (cores[c].idx >= 0) touch(c);
+        }
+        while (!sliceEnds.empty() && sliceEnds.topKey().first == now) stop(sliceEnds.pop());
+        if (balanceAt == now) {
+            rebalance();
+            balanceAt = queued > 0 ? now + std::max(1, opt.balanceInterval) : kNoTimer;
+        }
+
+        // A CPU stays marked while it is handled, so requeues and steals onto it do not
+        // list it again.
+        for (int c : dirty) {
+            Core& core = cores[c];
+            if (core.idx >= 0) {
+                RunningView v{core.idx, core.start, remaining[core.idx] - (now - core.start)};
+                if (pol.shouldPreempt(c, v, now)) {
+                    sliceEnds.erase(c);
+                    stop(c);
+                }
+            }
+            if (core.idx < 0) dispatch(c);
+            core.dirty = false;
+        }
+        dirty.clear();
+        // Idle CPUs that were not touched this step still pick up queued work.
+        if (stealing && idle > 0 && queued > 0) {
+            for (int c = 0; c < K && queued > 0; c++) if (cores[c].idx < 0) dispatch(c);
+            for (int c : dirty) cores[c].dirty = false;
+            dirty.clear();
+        }
+
+        timer = pol.nextTimer();
+        if (timer <= now) timer = now + 1;
+    }
+
+    src.report(rep, lastFinish);
+    return rep;
+}
+
+} // namespace
+
+ScheduleReport simulate(const std::vector<Process>& procs, SchedPolicy& pol, const char* name,
+                        RowOrder order, const SchedOptions& opt) {
+    BatchSource src(procs, order);
+    return run(src, pol, name, opt);
+}
+
+ScheduleReport simulateStream(const std::function<bool(Process&)>& next, SchedPolicy& pol, const char* name,
+                              const SchedOptions& opt, size_t* peakLive) {
+    SchedOptions o = opt;
+    o.gantt = GanttMode::None;
+    StreamSource src(next);
+    ScheduleReport rep = run(src, pol, name, o);
+    if (peakLive) *peakLive = src.table().size();
+    return rep;
+}
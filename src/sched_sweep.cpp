@@ -0,0 +1,124 @@
+#include "sched_sweep.h"
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Per-worker job deques. The owner pops from the back; an idle worker steals from the
+// front of another worker's deque, so owner and thief rarely touch the same end.
+// Jobs are all known up front, which keeps termination simple: a worker exits once
+// every deque is empty.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned workers) : queues_(workers ? workers : 1) {}
+
+    void run(size_t tasks, const std::function<void(size_t)>& fn) {
+        const size_t w = queues_.size();
+        // Contiguous blocks: neighbouring jobs usually share a trace, so a worker stays
+        // on the same data until it runs dry and starts stealing.
+        for (size_t k = 0; k < w; k++)
+            for (size_t t = tasks * k / w; t < tasks * (k + 1) / w; t++) queues_[k].jobs.push_back(t);
+        std::vector<std::thread> threads;
+        threads.reserve(w);
+        for (size_t k = 0; k < w; k++) threads.emplace_back([this, k, &fn]{ worker(k, fn); });
+        for (auto& t : threads) t.join();
+    }
+
+    std::uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex mu;
+        std::deque<size_t> jobs;
+    };
+
+    bool popOwn(size_t k, size_t& out) {
+        Queue& q = queues_[k];
+        std::lock_guard<std::mutex> lk(q.mu);
+        if (q.jobs.empty()) return false;
+        out = q.jobs.back(); q.jobs.pop_back();
+        return true;
+    }
+
+    bool steal(size_t k, size_t& out) {
+        const size_t w = queues_.size();
+        for (size_t d = 1; d < w; d++) {
+            Queue& q = queues_[(k + d) % w];
+            std::lock_guard<std::mutex> lk(q.mu);
+            if (q.jobs.empty()) continue;
+            out = q.jobs.front(); q.jobs.pop_front();
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void worker(size_t k, const std::function<void(size_t)>& fn) {
+        size_t t;
+        while (popOwn(k, t) || steal(k, t)) fn(t);
+    }
+
+    std::vector<Queue> queues_;
+    std::atomic<std::uint64_t> steals_{0};
+};
+
+} // namespace
+
+std::vector<SweepJob> expandSweep(const SweepSpec& spec, size_t traces) {
+    std::vector<SweepJob> jobs;
+    for (size_t t = 0; t < traces; t++)
+        for (int k : spec.cores) {
+            auto add = [&](SweepJob j) { j.trace = t; j.cores = k; jobs.push_back(j); };
+            for (Algorithm a : {Algorithm::FCFS, Algorithm::SJF, Algorithm::Priority, Algorithm::SRTF,
+                                Algorithm::PreemptivePriority, Algorithm::Fair}) {
+                SweepJob j; j.algo = a; add(j);
+            }
+            for (int q : spec.rrQuanta) {
+                SweepJob j; j.algo = Algorithm::RoundRobin; j.quantum = q; add(j);
+            }
+            for (int c : spec.mlqCutoffs)
+                for (int q : spec.mlqQuanta) {
+                    SweepJob j; j.algo = Algorithm::MultilevelQueue; j.mlqCutoff = c; j.mlqQuantum = q; add(j);
+                }
+        }
+    return jobs;
+}
+
+ScheduleReport runJob(const SweepJob& job, const std::vector<Process>& procs, const SchedOptions& base) {
+    SchedOptions opt = base;
+    opt.mlqCutoff = job.mlqCutoff;
+    opt.mlqQuantum = job.mlqQuantum;
+    opt.cores = job.cores;
+    switch (job.algo) {
+    case Algorithm::FCFS: return runFCFS(procs, opt);
+    case Algorithm::SJF: return runSJF(procs, opt);
+    case Algorithm::RoundRobin: return runRoundRobin(procs, job.quantum, opt);
+    case Algorithm::Priority: return runPriority(procs, opt);
+    case Algorithm::MultilevelQueue: return runMultilevelQueue(procs, opt);
+    case Algorithm::SRTF: return runSRTF(procs, opt);
+    case Algorithm::PreemptivePriority: return runPreemptivePriority(procs, opt);
+    case Algorithm::Fair: return runFair(procs, opt);
+    }
+    return {};
+}
+
+SweepStats runSweep(const std::vector<TracePtr>& traces, const std::vector<SweepJob>& jobs, unsigned threads,
+                    const std::function<void(const SweepResult&)>& onResult, const SchedOptions& base) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    if (threads > jobs.size()) threads = (unsigned)std::max<size_t>(1, jobs.size());
+    SchedOptions opt = base;
+    opt.gantt = GanttMode::None;
+    std::mutex outMu;
+    WorkStealingPool pool(threads);
+    pool.run(jobs.size(), [&](size_t k){
+        const SweepJob& job = jobs[k];
+        const Trace& tr = *traces[job.trace];
+        SweepResult res{&job, &tr, runJob(job, tr.procs, opt)};
+        std::lock_guard<std::mutex> lk(outMu);
+        onResult(res);
+    });
+    return {threads, pool.steals()};
+}
@@ -0,0 +1,365 @@
+#include "scheduler.h"
+#include "sched_engine.h"
+#include "indexed_heap.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace {
+
+// FIFO of process indices. A process is in at most one run queue at a time; the ring
+// starts at the expected size and doubles if a queue outgrows it.
+class IndexRing {
+public:
+    explicit IndexRing(size_t cap = 0) : buf_(cap ? cap : 1) {}
+    bool empty() const { return size_ == 0; }
+    void push(int v) {
+        if (size_ == buf_.size()) grow();
+        buf_[tail_] = v; if (++tail_ == buf_.size()) tail_ = 0; ++size_;
+    }
+    int pop() { int v = buf_[head_]; if (++head_ == buf_.size()) head_ = 0; --size_; return v; }
+private:
+    void grow() {
+        std::vector<int> nb(buf_.size() * 2);
+        for (size_t k = 0; k < size_; k++) nb[k] = buf_[(head_ + k) % buf_.size()];
+        buf_.swap(nb);
+        head_ = 0; tail_ = size_;
+    }
+    std::vector<int> buf_;
+    size_t head_ = 0, tail_ = 0, size_ = 0;
+};
+
+// Expected run queue length per CPU.
+size_t perCore(const std::vector<Process>& p, int cores) { return (p.size() + cores - 1) / cores; }
+
+// FCFS (quantum = run to completion) and Round Robin.
+class FifoPolicy : public SchedPolicy {
+public:
+    explicit FifoPolicy(int quantum) : quantum_(quantum) {}
+    void init(const std::vector<Process>& p, int cores) override {
+        q_.assign(cores, IndexRing(perCore(p, cores)));
+    }
+    void enqueue(int c, int idx, int, EnqueueReason, int) override { q_[c].push(idx); }
+    int pickNext(int c, int) override { return q_[c].empty() ? -1 : q_[c].pop(); }
+    int slice(int, int, int) override { return quantum_; }
+private:
+    int quantum_;
+    std::vector<IndexRing> q_;
+};
+
+// SJF and Priority: run the ready process with the smallest key to completion. The heap
+// holds (key, index) pairs and uses the same push_heap/pop_heap sequence as
+// std::priority_queue, so ties resolve exactly as they always have.
+class NonPreemptiveHeapPolicy : public SchedPolicy {
+public:
+    explicit NonPreemptiveHeapPolicy(bool byBurst) : byBurst_(byBurst) {}
+    void init(const std::vector<Process>& p, int cores) override {
+        p_ = &p;
+        heaps_.assign(cores, {});
+        for (auto& h : heaps_) h.reserve(perCore(p, cores));
+    }
+    void enqueue(int c, int idx, int, EnqueueReason, int) override {
+        const Process& pr = (*p_)[idx];
+        auto& h = heaps_[c];
+        h.push_back({byBurst_ ? pr.burst : pr.priority, idx});
+        std::push_heap(h.begin(), h.end(), cmp);
+    }
+    int pickNext(int c, int) override {
+        auto& h = heaps_[c];
+        if (h.empty()) return -1;
+        std::pop_heap(h.begin(), h.end(), cmp);
+        int idx = h.back().idx; h.pop_back();
+        return idx;
+    }
+private:
+    struct Item { int key; int idx; };
+    static bool cmp(const Item& a, const Item& b) { return a.key > b.key; }
+    bool byBurst_;
+    const std::vector<Process>* p_ = nullptr;
+    std::vector<std::vector<Item>> heaps_;
+};
+
+// Two queues: priority <= cutoff is Round Robin with the given quantum, the rest FCFS;
+// the high queue always goes first but does not preempt a running low process.
+class MultilevelPolicy : public SchedPolicy {
+public:
+    MultilevelPolicy(int cutoff, int quantum) : cutoff_(cutoff), quantum_(std::max(1, quantum)) {}
+    void init(const std::vector<Process>& p, int cores) override {
+        p_ = &p;
+        high_.assign(cores, IndexRing(perCore(p, cores)));
+        low_.assign(cores, IndexRing(perCore(p, cores)));
+    }
+    void enqueue(int c, int idx, int, EnqueueReason, int) override {
+        if (isHigh(idx)) high_[c].push(idx); else low_[c].push(idx);
+    }
+    int pickNext(int c, int) override {
+        if (!high_[c].empty()) return high_[c].pop();
+        return low_[c].empty() ? -1 : low_[c].pop();
+    }
+    int slice(int, int idx, int) override { return isHigh(idx) ? quantum_ : kRunToCompletion; }
+private:
+    bool isHigh(int idx) const { return (*p_)[idx].priority <= cutoff_; }
+    int cutoff_, quantum_;
+    const std::vector<Process>* p_ = nullptr;
+    std::vector<IndexRing> high_, low_;
+};
+
+// Ready set ordered by (key, enqueue sequence): smallest key first, FIFO among equals.
+// Per-CPU heaps share one position index, since a process waits on one CPU at a time.
+using ReadyKey = std::pair<std::int64_t, std::uint64_t>;
+using ReadyHeap = IndexedHeap<ReadyKey>;
+
+// The shared index covers the whole table; streaming runs extend it through grow().
+void initReady(std::vector<ReadyHeap>& ready, ReadyHeap::PosIndex& pos, const std::vector<Process>& p, int cores) {
+    pos.assign(p.size(), ReadyHeap::kAbsent);
+    ready.clear();
+    ready.reserve(cores);
+    for (int c = 0; c < cores; c++) {
+        ready.emplace_back(pos);
+        ready.back().reserve(perCore(p, cores));
+    }
+}
+
+// Shortest remaining time first: an arrival with strictly less work left than the
+// running process preempts it.
+class SrtfPolicy : public SchedPolicy {
+public:
+    void init(const std::vector<Process>& p, int cores) override { initReady(ready_, pos_, p, cores); }
+    void grow(size_t n) override { pos_.resize(n, ReadyHeap::kAbsent); }
+    void enqueue(int c, int idx, int, EnqueueReason, int remaining) override { ready_[c].push(idx, {remaining, seq_++}); }
+    int pickNext(int c, int) override { return ready_[c].empty() ? -1 : ready_[c].pop(); }
+    bool shouldPreempt(int c, const RunningView& run, int) override {
+        return !ready_[c].empty() && ready_[c].topKey().first < run.remaining;
+    }
+private:
+    ReadyHeap::PosIndex pos_;
+    std::vector<ReadyHeap> ready_;
+    std::uint64_t seq_ = 0;
+};
+
+// Preemptive priority (lower value runs first) with aging: every `interval` time units
+// a waiting process's effective priority improves by one, down to the best priority in
+// the trace. A process keeps its effective priority while it runs or migrates and drops
+// back to its own priority when it is preempted. Aging steps are timer events, and the
+// boosted process moves up its CPU's ready heap with a decrease-key.
+class AgingPriorityPolicy : public SchedPolicy {
+public:
+    explicit AgingPriorityPolicy(int interval) : interval_(std::max(1, interval)) {}
+    void init(const std::vector<Process>& p, int cores) override {
+        p_ = &p;
+        initReady(ready_, pos_, p, cores);
+        eff_.assign(p.size(), 0);
+        gen_.assign(p.size(), 0);
+        seq_.assign(p.size(), 0);
+        on_.assign(p.size(), 0);
+        best_ = INT_MAX;
+        for (const Process& pr : p) best_ = std::min(best_, pr.priority);
+    }
+    void grow(size_t n) override {
+        pos_.resize(n, ReadyHeap::kAbsent);
+        eff_.resize(n); gen_.resize(n); seq_.resize(n); on_.resize(n);
+    }
+    void enqueue(int c, int idx, int now, EnqueueReason why, int) override {
+        // Streaming runs only learn the best priority as processes arrive.
+        if (why == EnqueueReason::Arrival) best_ = std::min(best_, (*p_)[idx].priority);
+        if (why != EnqueueReason::Migrate) eff_[idx] = (*p_)[idx].priority;
+        seq_[idx] = next_++;
+        on_[idx] = c;
+        ready_[c].push(idx, {eff_[idx], seq_[idx]});
+        if (eff_[idx] > best_) aging_.push_back({idx, ++gen_[idx], now + interval_});
+    }
+    int pickNext(int c, int) override {
+        if (ready_[c].empty()) return -1;
+        int idx = ready_[c].pop();
+        ++gen_[idx]; // drops its pending aging step
+        return idx;
+    }
+    bool shouldPreempt(int c, const RunningView& run, int) override {
+        return !ready_[c].empty() && ready_[c].topKey().first < eff_[run.idx];
+    }
+    int nextTimer() const override { return aging_.empty() ? kNoTimer : aging_.front().due; }
+    void onTimer(int now) override {
+        // Steps stay in due order: every step is queued `interval` after the current time.
+        while (!aging_.empty() && aging_.front().due <= now) {
+            Step s = aging_.front(); aging_.pop_front();
+            if (s.gen != gen_[s.idx]) continue;
+            ready_[on_[s.idx]].update(s.idx, {--eff_[s.idx], seq_[s.idx]});
+            if (eff_[s.idx] > best_) aging_.push_back({s.idx, s.gen, s.due + interval_});
+        }
+    }
+private:
+    struct Step { int idx; std::uint32_t gen; int due; };
+    int interval_;
+    int best_ = 0;
+    const std::vector<Process>* p_ = nullptr;
+    ReadyHeap::PosIndex pos_;
+    std::vector<ReadyHeap> ready_;
+    std::vector<int> eff_, on_;
+    std::vector<std::uint32_t> gen_;
+    std::vector<std::uint64_t> seq_;
+    std::uint64_t next_ = 0;
+    std::deque<Step> aging_;
+};
+
+// CFS-like fair scheduler. Priority is read as a nice value (-20..19) and mapped to the
+// kernel's load weights; each process accumulates vruntime = runtime * 1024 / weight
+// and the one with the least vruntime runs next. A slice is the process's weight share
+// of its CPU's scheduling period (latency, stretched to min_granularity per runnable
+// process). Arrivals start at the CPU's min_vruntime and preempt the running process
+// when its vruntime leads theirs by more than min_granularity's worth. A migrating
+// process keeps its vruntime relative to min_vruntime, as in the kernel.
+class FairPolicy : public SchedPolicy {
+public:
+    FairPolicy(int latency, int minGranularity)
+        : latency_(std::max(1, latency)), minGran_(std::max(1, minGranularity)) {}
+    void init(const std::vector<Process>& p, int cores) override {
+        p_ = &p;
+        initReady(ready_, pos_, p, cores);
+        weight_.assign(p.size(), 0);
+        vr_.assign(p.size(), 0);
+        rq_.assign(cores, {});
+    }
+    void grow(size_t n) override {
+        pos_.resize(n, ReadyHeap::kAbsent);
+        weight_.resize(n); vr_.resize(n);
+    }
+    void enqueue(int c, int idx, int, EnqueueReason why, int) override {
+        RunQueue& rq = rq_[c];
+        if (why == EnqueueReason::Arrival) {
+            weight_[idx] = niceWeight((*p_)[idx].priority);
+            vr_[idx] = rq.minVr;
+        }
+        if (why == EnqueueReason::Migrate) vr_[idx] += rq.minVr;
+        if (why != EnqueueReason::Requeue) { rq.load += weight_[idx]; rq.runnable++; }
+        ready_[c].push(idx, {vr_[idx], seq_++});
+    }
+    int pickNext(int c, int) override { return ready_[c].empty() ? -1 : ready_[c].pop(); }
+    int steal(int c, int) override {
+        if (ready_[c].empty()) return -1;
+        int idx = ready_[c].pop();
+        RunQueue& rq = rq_[c];
+        rq.load -= weight_[idx]; rq.runnable--;
+        vr_[idx] -= rq.minVr;
+        return idx;
+    }
+    int slice(int c, int idx, int) override {
+        const RunQueue& rq = rq_[c];
+        std::int64_t period = std::max<std::int64_t>(latency_, (std::int64_t)rq.runnable * minGran_);
+        std::int64_t s = period * weight_[idx] / std::max<std::int64_t>(1, rq.load);
+        return (int)std::max<std::int64_t>(minGran_, s);
+    }
+    bool shouldPreempt(int c, const RunningView& run, int now) override {
+        const ReadyHeap& r = ready_[c];
+        if (r.empty()) return false;
+        std::int64_t cur = vr_[run.idx] + delta(run.idx, now - run.start);
+        return r.topKey().first + delta(r.top(), minGran_) < cur;
+    }
+    void ran(int c, int idx, int start, int end, bool finished) override {
+        RunQueue& rq = rq_[c];
+        vr_[idx] += delta(idx, end - start);
+        if (finished) { rq.load -= weight_[idx]; rq.runnable--; }
+        // min_vruntime only moves forward.
+        std::int64_t m = finished ? INT64_MAX : vr_[idx];
+        if (!ready_[c].empty()) m = std::min(m, ready_[c].topKey().first);
+        if (m != INT64_MAX) rq.minVr = std::max(rq.minVr, m);
+    }
+private:
+    struct RunQueue {
+        std::int64_t load = 0, minVr = 0;
+        int runnable = 0;
+    };
+    static constexpr std::int64_t kNice0 = 1024;
+    static std::int64_t niceWeight(int nice) {
+        static const int w[40] = {
+            88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+             9548,  7620,  6100,  4904,  3906,  3121,  2501,  1991,  1586,  1277,
+             1024,   820,   655,   526,   423,   335,   272,   215,   172,   137,
+              110,    87,    70,    56,    45,    36,    29,    23,    18,    15,
+        };
+        return w[std::clamp(nice, -20, 19) + 20];
+    }
+    // vruntime is kept in 1/1024ths of a time unit so heavy processes do not round to 0.
+    std::int64_t delta(int idx, std::int64_t t) const { return t * kNice0 * 1024 / weight_[idx]; }
+
+    int latency_, minGran_;
+    const std::vector<Process>* p_ = nullptr;
+    ReadyHeap::PosIndex pos_;
+    std::vector<ReadyHeap> ready_;
+    std::vector<std::int64_t> weight_, vr_;
+    std::vector<RunQueue> rq_;
+    std::uint64_t seq_ = 0;
+};
+
+} // namespace
+
+const char* algorithmName(Algorithm a) {
+    switch (a) {
+    case Algorithm::FCFS: return "FCFS";
+    case Algorithm::SJF: return "SJF";
+    case Algorithm::RoundRobin: return "RoundRobin";
+    case Algorithm::Priority: return "Priority";
+    case Algorithm::MultilevelQueue: return "MultilevelQueue";
+    case Algorithm::SRTF: return "SRTF";
+    case Algorithm::PreemptivePriority: return "PreemptivePriority";
+    case Algorithm::Fair: return "Fair";
+    }
+    return "?";
+}
+
+ScheduleReport runFCFS(const std::vector<Process>& procs, const SchedOptions& opt) {
+    FifoPolicy pol(kRunToCompletion);
+    return simulate(procs, pol, "FCFS", RowOrder::Arrival, opt);
+}
+
+ScheduleReport runSJF(const std::vector<Process>& procs, const SchedOptions& opt){
+    NonPreemptiveHeapPolicy pol(true);
+    return simulate(procs, pol, "SJF", RowOrder::Completion, opt);
+}
+
+ScheduleReport runRoundRobin(const std::vector<Process>& procs, int quantum, const SchedOptions& opt){
+    FifoPolicy pol(std::max(1, quantum));
+    return simulate(procs, pol, "RoundRobin", RowOrder::Arrival, opt);
+}
+
+ScheduleReport runPriority(const std::vector<Process>& procs, const SchedOptions& opt){
+    NonPreemptiveHeapPolicy pol(false);
+    return simulate(procs, pol, "Priority", RowOrder::Completion, opt);
+}
+
+ScheduleReport runMultilevelQueue(const std::vector<Process>& procs, const SchedOptions& opt){
+    MultilevelPolicy pol(opt.mlqCutoff, opt.mlqQuantum);
+    return simulate(procs, pol, "MultilevelQueue", RowOrder::Arrival, opt);
+}
+
+ScheduleReport runSRTF(const std::vector<Process>& procs, const SchedOptions& opt){
+    SrtfPolicy pol;
+    return simulate(procs, pol, "SRTF", RowOrder::Arrival, opt);
+}
+
+ScheduleReport runPreemptivePriority(const std::vector<Process>& procs, const SchedOptions& opt){
+    AgingPriorityPolicy pol(opt.agingInterval);
+    return simulate(procs, pol, "PreemptivePriority", RowOrder::Arrival, opt);
+}
+
+ScheduleReport runFair(const std::vector<Process>& procs, const SchedOptions& opt){
+    FairPolicy pol(opt.cfsLatency, opt.cfsMinGranularity);
+    return simulate(procs, pol, "Fair", RowOrder::Arrival, opt);
+}
+
+ScheduleReport replayStream(Algorithm a, const std::function<bool(Process&)>& next, int quantum,
+                            const SchedOptions& opt, size_t* peakLive) {
+    auto go = [&](SchedPolicy&& pol) { return simulateStream(next, pol, algorithmName(a), opt, peakLive); };
+    switch (a) {
+    case Algorithm::FCFS: return go(FifoPolicy(kRunToCompletion));
+    case Algorithm::SJF: return go(NonPreemptiveHeapPolicy(true));
+    case Algorithm::RoundRobin: return go(FifoPolicy(std::max(1, quantum)));
+    case Algorithm::Priority: return go(NonPreemptiveHeapPolicy(false));
+    case Algorithm::MultilevelQueue: return go(MultilevelPolicy(opt.mlqCutoff, opt.mlqQuantum));
+    case Algorithm::SRTF: return go(SrtfPolicy());
+    case Algorithm::PreemptivePriority: return go(AgingPriorityPolicy(opt.agingInterval));
+    case Algorithm::Fair: return go(FairPolicy(opt.cfsLatency, opt.cfsMinGranularity));
+    }
+    return {};
+}
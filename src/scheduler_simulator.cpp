@@ -1,10 +1,11 @@
 #include "scheduler.h"
+#include "sched_sweep.h"
+#include "trace_loader.h"
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <algorithm>
-#include <queue>
-#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 static void printGantt(const std::vector<GanttSlice>& g) {
     if (g.empty()) return;
@@ -16,6 +17,17 @@ static void printGantt(const std::vector<GanttSlice>& g) {
     std::cout << "| end=" << lastEnd << "\n";
 }
 
+static void printCores(const ScheduleReport& r) {
+    if (r.cores.size() < 2) return;
+    std::cout << "Migrations: " << r.migrations << "\n";
+    for (size_t c = 0; c < r.cores.size(); c++) {
+        const CoreReport& cr = r.cores[c];
+        std::printf("CPU%zu: utilisation %.1f%%, dispatches %llu, migrations in %llu\n", c, cr.utilisation * 100,
+                    (unsigned long long)cr.dispatches, (unsigned long long)cr.migrations);
+        printGantt(cr.gantt);
+    }
+}
+
 static void printReport(const ScheduleReport& r) {
     std::cout << "Algorithm: " << r.algorithm << "\n";
     std::cout << "PID\tWaiting\tTurnaround\n";
@@ -24,153 +36,157 @@ static void printReport(const ScheduleReport& r) {
     }
     std::cout << "Avg Waiting: " << r.avgWaiting << ", Avg Turnaround: " << r.avgTurnaround << ", Throughput: " << r.throughput << "\n";
     printGantt(r.gantt);
+    printCores(r);
 }
 
-// Minimal FCFS example to make binary functional; replace with full implementations later
-static void finalizeReport(const std::vector<Process>& p, std::vector<ResultRow>& rows, ScheduleReport& rep, int lastFinish) {
-    double sumW=0,sumT=0;
-    for (auto &r : rows) { sumW += r.waiting; sumT += r.turnaround; }
-    if (!rows.empty()) {
-        rep.avgWaiting = sumW / rows.size();
-        rep.avgTurnaround = sumT / rows.size();
-        if (lastFinish>0) rep.throughput = (double)rows.size()/ (double)lastFinish;
-    }
-}
-
-ScheduleReport runFCFS(const std::vector<Process>& procs) {
-    std::vector<Process> p = procs;
-    std::sort(p.begin(), p.end(), [](auto&a, auto&b){return a.arrival < b.arrival;});
-    int time = 0; ScheduleReport rep; rep.algorithm = "FCFS";
-    std::vector<ResultRow> rows;
-    for (auto &pr : p) {
-        if (time < pr.arrival) time = pr.arrival;
-        int start = time;
-        int wait = start - pr.arrival;
-        int tat = wait + pr.burst;
-        time += pr.burst;
-        rows.push_back({pr.pid, wait, tat});
-        rep.gantt.push_back({pr.pid, start, time});
+// Replays the trace once per algorithm, reading it as it goes; only the processes that
+// are waiting or running at a time are in memory.
+static int runStreamMode(const std::string& path, const SchedOptions& opt) {
+    static const Algorithm algos[] = { Algorithm::FCFS, Algorithm::SJF, Algorithm::RoundRobin, Algorithm::Priority,
+                                       Algorithm::MultilevelQueue, Algorithm::SRTF, Algorithm::PreemptivePriority,
+                                       Algorithm::Fair };
+    for (Algorithm a : algos) {
+        TraceReader in(path);
+        size_t peak = 0;
+        ScheduleReport r = replayStream(a, [&](Process& p){ return in.next(p); }, 2, opt, &peak);
+        if (!in.error().empty()) {
+            std::cerr << path << ": " << in.error() << "\n";
+            return 1;
+        }
+        std::cout << "Algorithm: " << r.algorithm << "\n";
+        std::cout << "Processes: " << r.completed << ", Peak live: " << peak << ", Dispatches: " << r.dispatches << "\n";
+        std::cout << "Avg Waiting: " << r.avgWaiting << ", Avg Turnaround: " << r.avgTurnaround << ", Throughput: " << r.throughput << "\n";
+        printCores(r);
+        if (a == Algorithm::FCFS && in.stats().truncated) std::cerr << path << ": trace ends mid-record\n";
     }
-    rep.rows = rows; finalizeReport(p, rep.rows, rep, time);
-    return rep;
+    return 0;
 }
 
-ScheduleReport runSJF(const std::vector<Process>& procs){
-    std::vector<Process> p = procs; ScheduleReport rep; rep.algorithm = "SJF";
-    std::sort(p.begin(), p.end(), [](auto&a, auto&b){return a.arrival<b.arrival;});
-    auto cmp = [](const Process&a, const Process&b){return a.burst>b.burst;};
-    std::priority_queue<Process, std::vector<Process>, decltype(cmp)> pq(cmp);
-    int time=0, i=0; std::vector<ResultRow> rows;
-    while (i<(int)p.size() || !pq.empty()) {
-        while (i<(int)p.size() && p[i].arrival<=time) pq.push(p[i++]);
-        if (pq.empty()) { time = p[i].arrival; continue; }
-        Process cur = pq.top(); pq.pop();
-        int start = time; time += cur.burst; int wait = start - cur.arrival; int tat = wait + cur.burst;
-        rows.push_back({cur.pid, wait, tat});
-        rep.gantt.push_back({cur.pid, start, time});
+// "1,2,4" or ranges "1-8" (mixable: "1-4,8,16"). False on anything else.
+static bool parseIntList(const char* s, std::vector<int>& out) {
+    out.clear();
+    while (*s) {
+        char* end;
+        long a = std::strtol(s, &end, 10);
+        if (end == s) return false;
+        long b = a;
+        if (*end == '-') {
+            s = end + 1;
+            b = std::strtol(s, &end, 10);
+            if (end == s || b < a) return false;
+        }
+        for (long v = a; v <= b; v++) out.push_back((int)v);
+        if (*end == ',') end++;
+        else if (*end) return false;
+        s = end;
     }
-    rep.rows = rows; finalizeReport(p, rep.rows, rep, time); return rep;
+    return !out.empty();
 }
 
-ScheduleReport runRoundRobin(const std::vector<Process>& procs, int quantum){
-    std::vector<Process> p = procs; ScheduleReport rep; rep.algorithm = "RoundRobin";
-    std::sort(p.begin(), p.end(), [](auto&a, auto&b){return a.arrival<b.arrival;});
-    std::queue<Process> q; int time=0, i=0; std::map<int,int> remaining;
-    for (auto &pr: p) remaining[pr.pid]=pr.burst;
-    std::map<int,int> firstStart;
-    std::map<int,int> finish;
-    while (i<(int)p.size() || !q.empty()) {
-        while (i<(int)p.size() && p[i].arrival<=time) q.push(p[i++]);
-        if (q.empty()) { time = p[i].arrival; continue; }
-        Process cur = q.front(); q.pop();
-        int run = std::min(quantum, remaining[cur.pid]);
-        int start = time; time += run; remaining[cur.pid]-=run;
-        if (!firstStart.count(cur.pid)) firstStart[cur.pid]=start;
-        rep.gantt.push_back({cur.pid, start, time});
-        while (i<(int)p.size() && p[i].arrival<=time) q.push(p[i++]);
-        if (remaining[cur.pid]>0) { q.push(cur); }
-        else { finish[cur.pid]=time; }
-    }
-    std::vector<ResultRow> rows;
-    for (auto &pr : p) {
-        int tat = finish[pr.pid]-pr.arrival;
-        int waiting = tat - pr.burst;
-        rows.push_back({pr.pid, waiting, tat});
+static int runSweepMode(const std::vector<std::string>& csvs, const SweepSpec& spec, unsigned threads,
+                        const SchedOptions& opt) {
+    std::vector<TracePtr> traces;
+    for (auto& path : csvs) {
+        auto tr = std::make_shared<Trace>();
+        tr->name = path;
+        tr->procs = loadTrace(path);
+        if (tr->procs.empty()) {
+            std::cerr << "No processes loaded from " << path << "\n";
+            return 1;
+        }
+        traces.push_back(std::move(tr));
     }
-    rep.rows = rows; finalizeReport(p, rep.rows, rep, time); return rep;
+    std::vector<SweepJob> jobs = expandSweep(spec, traces.size());
+    std::printf("trace,algorithm,quantum,mlq_cutoff,mlq_quantum,avg_waiting,avg_turnaround,throughput,dispatches,"
+                "cores,migrations\n");
+    std::fflush(stdout);
+    SweepStats st = runSweep(traces, jobs, threads, [](const SweepResult& r){
+        const SweepJob& j = *r.job;
+        bool rr = j.algo == Algorithm::RoundRobin, mlq = j.algo == Algorithm::MultilevelQueue;
+        std::printf("%s,%s,%d,%d,%d,%.4f,%.4f,%.6f,%llu,%d,%llu\n", r.trace->name.c_str(), algorithmName(j.algo),
+                    rr ? j.quantum : 0, mlq ? j.mlqCutoff : 0, mlq ? j.mlqQuantum : 0,
+                    r.report.avgWaiting, r.report.avgTurnaround, r.report.throughput,
+                    (unsigned long long)r.report.dispatches, j.cores, (unsigned long long)r.report.migrations);
+        std::fflush(stdout);
+    }, opt);
+    std::cerr << jobs.size() << " jobs on " << st.threads << " threads, " << st.steals << " stolen\n";
+    return 0;
 }
 
-ScheduleReport runPriority(const std::vector<Process>& procs){
-    std::vector<Process> p = procs; ScheduleReport rep; rep.algorithm = "Priority";
-    std::sort(p.begin(), p.end(), [](auto&a, auto&b){return a.arrival<b.arrival;});
-    auto cmp = [](const Process&a, const Process&b){return a.priority>b.priority;};
-    std::priority_queue<Process, std::vector<Process>, decltype(cmp)> pq(cmp);
-    int time=0, i=0; std::vector<ResultRow> rows;
-    while (i<(int)p.size() || !pq.empty()) {
-        while (i<(int)p.size() && p[i].arrival<=time) pq.push(p[i++]);
-        if (pq.empty()) { time = p[i].arrival; continue; }
-        Process cur = pq.top(); pq.pop();
-        int start=time; time += cur.burst; int wait=start-cur.arrival; int tat=wait+cur.burst;
-        rows.push_back({cur.pid, wait, tat});
-        rep.gantt.push_back({cur.pid, start, time});
-    }
-    rep.rows = rows; finalizeReport(p, rep.rows, rep, time); return rep;
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0 << " [--gantt=full|merged|none] [CPU options] [processes.csv]\n"
+              << "       " << argv0 << " --write-trace=OUT trace.csv   (convert to the binary trace format)\n"
+              << "       " << argv0 << " --stream [CPU options] trace   (replay in bounded memory; summaries only)\n"
+              << "       " << argv0 << " --sweep [--threads=N] [--rr-quanta=LIST] [--mlq-cutoffs=LIST]"
+                 " [--mlq-quanta=LIST] [--cores=LIST] [CPU options] trace.csv...\n"
+              << "CPU options: --cores=K --balance=steal|periodic|none --balance-interval=T --pin\n"
+              << "LIST is comma-separated integers or ranges, e.g. 1-8,16\n";
 }
 
-ScheduleReport runMultilevelQueue(const std::vector<Process>& procs){
-    // Simple 2-queue MLQ: high-priority (priority<=1) Round Robin (q=2), low-priority FCFS; strict priority to high queue.
-    std::vector<Process> p = procs; ScheduleReport rep; rep.algorithm = "MultilevelQueue";
-    std::sort(p.begin(), p.end(), [](auto&a, auto&b){return a.arrival<b.arrival;});
-    std::queue<Process> high, low; int time=0, i=0; std::map<int,int> remaining, finish;
-    for (auto &pr : p) remaining[pr.pid]=pr.burst;
-    while (i<(int)p.size() || !high.empty() || !low.empty()) {
-        while (i<(int)p.size() && p[i].arrival<=time) {
-            if (p[i].priority<=1) high.push(p[i]); else low.push(p[i]);
-            i++;
-        }
-        if (high.empty() && low.empty()) { time=p[i].arrival; continue; }
-        if (!high.empty()) {
-            auto cur = high.front(); high.pop();
-            int run = std::min(2, remaining[cur.pid]);
-            int start=time; time+=run; remaining[cur.pid]-=run; rep.gantt.push_back({cur.pid,start,time});
-            while (i<(int)p.size() && p[i].arrival<=time) { if (p[i].priority<=1) high.push(p[i]); else low.push(p[i]); i++; }
-            if (remaining[cur.pid]>0) high.push(cur); else finish[cur.pid]=time;
-        } else {
-            auto cur = low.front(); low.pop();
-            int start=time; time+=remaining[cur.pid]; rep.gantt.push_back({cur.pid,start,time}); remaining[cur.pid]=0; finish[cur.pid]=time;
+int main(int argc, char** argv) {
+    std::vector<std::string> csvs;
+    SchedOptions opt;
+    SweepSpec spec;
+    bool sweep = false, stream = false;
+    unsigned threads = 0;
+    std::string writeTrace;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool ok = true;
+        if (std::strcmp(a, "--gantt=full") == 0) opt.gantt = GanttMode::Full;
+        else if (std::strcmp(a, "--gantt=merged") == 0) opt.gantt = GanttMode::Merged;
+        else if (std::strcmp(a, "--gantt=none") == 0) opt.gantt = GanttMode::None;
+        else if (std::strcmp(a, "--sweep") == 0) sweep = true;
+        else if (std::strcmp(a, "--stream") == 0) stream = true;
+        else if (std::strncmp(a, "--write-trace=", 14) == 0) writeTrace = a + 14;
+        else if (std::strncmp(a, "--threads=", 10) == 0) threads = (unsigned)std::strtoul(a + 10, nullptr, 10);
+        else if (std::strncmp(a, "--rr-quanta=", 12) == 0) ok = parseIntList(a + 12, spec.rrQuanta);
+        else if (std::strncmp(a, "--mlq-cutoffs=", 14) == 0) ok = parseIntList(a + 14, spec.mlqCutoffs);
+        else if (std::strncmp(a, "--mlq-quanta=", 13) == 0) ok = parseIntList(a + 13, spec.mlqQuanta);
+        else if (std::strncmp(a, "--cores=", 8) == 0) {
+            ok = parseIntList(a + 8, spec.cores);
+            for (int k : spec.cores) ok = ok && k >= 1;
+            if (ok) opt.cores = spec.cores[0];
         }
+        else if (std::strcmp(a, "--balance=steal") == 0) opt.balance = Balance::Steal;
+        else if (std::strcmp(a, "--balance=periodic") == 0) opt.balance = Balance::Periodic;
+        else if (std::strcmp(a, "--balance=none") == 0) opt.balance = Balance::None;
+        else if (std::strncmp(a, "--balance-interval=", 19) == 0) ok = (opt.balanceInterval = std::atoi(a + 19)) > 0;
+        else if (std::strcmp(a, "--pin") == 0) opt.affinity = Affinity::Pinned;
+        else if (a[0] != '-') csvs.push_back(a);
+        else ok = false;
+        if (!ok) { usage(argv[0]); return 2; }
     }
-    std::vector<ResultRow> rows;
-    for (auto &pr : p) { int tat=finish[pr.pid]-pr.arrival; int waiting=tat-pr.burst; rows.push_back({pr.pid,waiting,tat}); }
-    rep.rows=rows; finalizeReport(p, rep.rows, rep, time); return rep;
-}
-
-static std::vector<Process> loadCsv(const std::string& path) {
-    std::vector<Process> out; std::ifstream f(path);
-    if (!f) return out; std::string line; bool header=true;
-    while (std::getline(f,line)) {
-        if (line.empty()) continue; if (header) { header=false; if (line.find("PID")!=std::string::npos) continue; }
-        std::replace(line.begin(), line.end(), ';', ',');
-        std::stringstream ss(line); std::string tok; std::vector<int> vals;
-        while (std::getline(ss,tok,',')) { if (!tok.empty()) vals.push_back(std::stoi(tok)); }
-        if (vals.size()>=4) out.push_back({vals[0],vals[1],vals[2],vals[3]});
+    if (csvs.empty()) csvs.push_back("data/processes.csv");
+    if (!writeTrace.empty()) {
+        if (csvs.size() > 1) { usage(argv[0]); return 2; }
+        auto procs = loadTrace(csvs[0]);
+        if (procs.empty() || !saveBinaryTrace(writeTrace, procs)) {
+            std::cerr << "Cannot convert " << csvs[0] << " to " << writeTrace << "\n";
+            return 1;
+        }
+        std::cerr << "Wrote " << procs.size() << " processes to " << writeTrace << "\n";
+        return 0;
     }
-    return out;
-}
-
-int main(int argc, char** argv) {
-    std::string csv = (argc>1) ? argv[1] : "data/processes.csv";
-    auto procs = loadCsv(csv);
+    if (sweep) return runSweepMode(csvs, spec, threads, opt);
+    if (spec.cores.size() > 1) { usage(argv[0]); return 2; }
+    if (csvs.size() > 1) { usage(argv[0]); return 2; }
+    if (stream) return runStreamMode(csvs[0], opt);
+    const std::string& csv = csvs[0];
+    auto procs = loadTrace(csv);
     if (procs.empty()) {
         std::cerr << "No processes loaded from " << csv << ". Ensure CSV exists with: PID,Arrival,Burst,Priority\n";
         return 1;
     }
     std::vector<ScheduleReport> reps;
-    reps.push_back(runFCFS(procs));
-    reps.push_back(runSJF(procs));
-    reps.push_back(runRoundRobin(procs, 2));
-    reps.push_back(runPriority(procs));
-    reps.push_back(runMultilevelQueue(procs));
+    reps.push_back(runFCFS(procs, opt));
+    reps.push_back(runSJF(procs, opt));
+    reps.push_back(runRoundRobin(procs, 2, opt));
+    reps.push_back(runPriority(procs, opt));
+    reps.push_back(runMultilevelQueue(procs, opt));
+    reps.push_back(runSRTF(procs, opt));
+    reps.push_back(runPreemptivePriority(procs, opt));
+    reps.push_back(runFair(procs, opt));
     std::ofstream ofs("data/reports/scheduler_report.txt", std::ios::app);
     for (auto &r : reps) {
         printReport(r);
@@ -0,0 +1,155 @@
+#define _GNU_SOURCE
+#include "selfstat.h"
+#include "collector.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+_Static_assert(SELF_H_COUNT - SELF_H_SAMPLE >= MAX_COLLECTORS, "one sample histogram per collector");
+
+// One block per recording thread. Only its owner writes, so updates are a relaxed
+// load + store; readers may see a count one behind, never a torn value.
+typedef struct self_block {
+    _Atomic uint64_t hist[SELF_H_COUNT][SELF_BUCKETS];
+    _Atomic uint64_t max[SELF_H_COUNT];
+    _Atomic uint64_t counters[SELF_C_COUNT];
+    const char *name;
+    struct self_block *next;
+} self_block_t;
+
+static _Atomic(self_block_t *) g_blocks;
+static _Thread_local self_block_t *t_block;
+static const char *g_samplers[SELF_H_COUNT - SELF_H_SAMPLE];
+
+uint64_t self_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Blocks are never freed: threads come and go but their figures stay in the totals.
+static self_block_t *block(void) {
+    if (t_block) return t_block;
+    self_block_t *b = calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    b->next = atomic_load(&g_blocks);
+    while (!atomic_compare_exchange_weak(&g_blocks, &b->next, b)) {}
+    return t_block = b;
+}
+
+static inline void bump(_Atomic uint64_t *x, uint64_t by) {
+    atomic_store_explicit(x, atomic_load_explicit(x, memory_order_relaxed) + by, memory_order_relaxed);
+}
+
+void self_thread(const char *name) {
+    self_block_t *b = block();
+    if (b) b->name = name;
+}
+
+void self_name_sampler(int i, const char *name) {
+    if (i >= 0 && i < SELF_H_COUNT - SELF_H_SAMPLE) g_samplers[i] = name;
+}
+
+void self_count(self_counter_t c) {
+    self_block_t *b = block();
+    if (b) bump(&b->counters[c], 1);
+}
+
+static unsigned bucket_of(uint64_t ns) {
+    if (ns < (1u << SELF_SUB_BITS)) return (unsigned)ns;
+    if (ns >> SELF_MAX_BITS) return SELF_BUCKETS - 1;
+    unsigned e = 63u - (unsigned)__builtin_clzll(ns);
+    unsigned sub = (unsigned)(ns >> (e - SELF_SUB_BITS)) & ((1u << SELF_SUB_BITS) - 1);
+    return ((e - SELF_SUB_BITS + 1) << SELF_SUB_BITS) + sub;
+}
+
+// Midpoint of a bucket's range.
+static uint64_t bucket_value(unsigned b) {
+    if (b < (1u << SELF_SUB_BITS)) return b;
+    unsigned e = (b >> SELF_SUB_BITS) + SELF_SUB_BITS - 1;
+    uint64_t width = 1ULL << (e - SELF_SUB_BITS);
+    uint64_t low = ((uint64_t)((b & ((1u << SELF_SUB_BITS) - 1)) + (1u << SELF_SUB_BITS))) << (e - SELF_SUB_BITS);
+    return low + width / 2;
+}
+
+void self_record(self_hist_t h, uint64_t ns) {
+    self_block_t *b = block();
+    if (!b || (unsigned)h >= SELF_H_COUNT) return;
+    bump(&b->hist[h][bucket_of(ns)], 1);
+    if (ns > atomic_load_explicit(&b->max[h], memory_order_relaxed))
+        atomic_store_explicit(&b->max[h], ns, memory_order_relaxed);
+}
+
+void self_snapshot(self_snapshot_t *out) {
+    memset(out, 0, sizeof(*out));
+    for (self_block_t *b = atomic_load(&g_blocks); b; b = b->next) {
+        for (int h = 0; h < SELF_H_COUNT; h++)
+            for (int i = 0; i < SELF_BUCKETS; i++)
+                out->hist[h][i] += atomic_load_explicit(&b->hist[h][i], memory_order_relaxed);
+        for (int c = 0; c < SELF_C_COUNT; c++)
+            out->counters[c] += atomic_load_explicit(&b->counters[c], memory_order_relaxed);
+    }
+}
+
+uint64_t self_quantile(const uint64_t *cur, const uint64_t *prev, double q) {
+    uint64_t total = 0;
+    for (int i = 0; i < SELF_BUCKETS; i++) total += cur[i] - (prev ? prev[i] : 0);
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (double)(total - 1)) + 1, seen = 0;
+    for (int i = 0; i < SELF_BUCKETS; i++) {
+        seen += cur[i] - (prev ? prev[i] : 0);
+        if (seen >= rank) return bucket_value((unsigned)i);
+    }
+    return bucket_value(SELF_BUCKETS - 1);
+}
+
+void self_stat_name(int id, char *buf, size_t cap) {
+    static const char *hists[] = { "push_wait", "queue", "write", "flush" };
+    static const char *counters[] = { "push_blocked", "push_wake", "consumer_park" };
+    if (id >= 0 && id < SELF_H_SAMPLE) snprintf(buf, cap, "%s", hists[id]);
+    else if (id >= SELF_H_SAMPLE && id < SELF_H_COUNT) {
+        const char *n = g_samplers[id - SELF_H_SAMPLE];
+        if (n) snprintf(buf, cap, "sample.%s", n);
+        else snprintf(buf, cap, "sample.%d", id - SELF_H_SAMPLE);
+    } else if (id >= SELF_H_COUNT && id < SELF_COUNTER_ID(SELF_C_COUNT)) snprintf(buf, cap, "%s", counters[id - SELF_H_COUNT]);
+    else snprintf(buf, cap, "self.%d", id);
+}
+
+void self_dump(FILE *f) {
+    static self_snapshot_t snap; // ~40 KiB; dumps come from the main thread only
+    self_snapshot(&snap);
+    char name[48];
+    fprintf(f, "self: counters per thread\n");
+    for (self_block_t *b = atomic_load(&g_blocks); b; b = b->next) {
+        fprintf(f, "  %-8s", b->name ? b->name : "?");
+        for (int c = 0; c < SELF_C_COUNT; c++) {
+            uint64_t v = atomic_load_explicit(&b->counters[c], memory_order_relaxed);
+            if (!v) continue;
+            self_stat_name(SELF_COUNTER_ID(c), name, sizeof(name));
+            fprintf(f, " %s=%llu", name, (unsigned long long)v);
+        }
+        fputc('\n', f);
+    }
+    fprintf(f, "self: latency (us)      count      p50      p90      p99    p99.9      max\n");
+    for (int h = 0; h < SELF_H_COUNT; h++) {
+        uint64_t n = 0, max = 0;
+        for (int i = 0; i < SELF_BUCKETS; i++) n += snap.hist[h][i];
+        if (!n) continue;
+        for (self_block_t *b = atomic_load(&g_blocks); b; b = b->next) {
+            uint64_t m = atomic_load_explicit(&b->max[h], memory_order_relaxed);
+            if (m > max) max = m;
+        }
+        static const double qs[] = { 0.5, 0.9, 0.99, 0.999 };
+        double v[4];
+        for (int i = 0; i < 4; i++) {
+            uint64_t x = self_quantile(snap.hist[h], NULL, qs[i]);
+            v[i] = (x < max ? x : max) / 1e3; // a bucket midpoint can lie above the largest sample
+        }
+        self_stat_name(h, name, sizeof(name));
+        fprintf(f, "  %-18s %9llu %8.1f %8.1f %8.1f %8.1f %8.1f\n", name, (unsigned long long)n,
+                v[0], v[1], v[2], v[3], max / 1e3);
+    }
+    fflush(f);
+}
@@ -0,0 +1,181 @@
+#define _GNU_SOURCE
+#include "shm_metrics.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+_Static_assert((SHM_RING_LEN & (SHM_RING_LEN - 1)) == 0, "SHM_RING_LEN must be a power of two");
+
+#define SEQ_SPINS 64   // pauses while the writer is mid-update
+#define SEQ_SLEEPS 100 // then 100 us sleeps, 10 ms in all, before the reader gives up
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+shm_metrics_t *shm_metrics_create(const char *name) {
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, sizeof(shm_metrics_t)) != 0) { close(fd); return NULL; }
+    void *p = mmap(NULL, sizeof(shm_metrics_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    shm_metrics_t *shm = p;
+    // Invalidate first so readers of a stale region never trust half-initialised state.
+    atomic_store(&shm->gen, 0);
+    shm->magic = 0;
+    memset(shm->kinds, 0, sizeof(shm->kinds));
+    shm->version = SHM_METRICS_VERSION;
+    shm->nkinds = METRIC_KIND_COUNT;
+    shm->ring_len = SHM_RING_LEN;
+    shm->writer_pid = getpid();
+    atomic_store(&shm->updated_ms, 0);
+    atomic_thread_fence(memory_order_release);
+    shm->magic = SHM_METRICS_MAGIC;
+    return shm;
+}
+
+void shm_metrics_publish(shm_metrics_t *shm, const metric_t *m) {
+    if ((unsigned)m->kind >= METRIC_KIND_COUNT) return;
+    shm_kind_t *k = &shm->kinds[m->kind];
+    shm_sample_t s = { .ts_ms = m->ts_ms, .id = m->id, .interval_ms = m->interval_ms, .v1 = m->v1, .v2 = m->v2 };
+
+    uint32_t seq = atomic_load_explicit(&k->latest_seq, memory_order_relaxed);
+    atomic_store_explicit(&k->latest_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    k->latest = s;
+    atomic_store_explicit(&k->latest_seq, seq + 2, memory_order_release);
+
+    uint64_t idx = atomic_load_explicit(&k->head, memory_order_relaxed);
+    shm_slot_t *slot = &k->ring[idx & (SHM_RING_LEN - 1)];
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->s = s;
+    atomic_store_explicit(&slot->seq, idx + 1, memory_order_release);
+    atomic_store_explicit(&k->head, idx + 1, memory_order_release);
+    atomic_store_explicit(&shm->updated_ms, m->ts_ms, memory_order_relaxed);
+}
+
+void shm_metrics_publish_agg(shm_metrics_t *shm, metric_kind_t kind, const agg_summary_t *agg) {
+    if ((unsigned)kind >= METRIC_KIND_COUNT) return;
+    shm_kind_t *k = &shm->kinds[kind];
+    uint32_t seq = atomic_load_explicit(&k->agg_seq, memory_order_relaxed);
+    atomic_store_explicit(&k->agg_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    k->agg = *agg;
+    atomic_store_explicit(&k->agg_seq, seq + 2, memory_order_release);
+}
+
+void shm_metrics_notify(shm_metrics_t *shm) {
+    atomic_fetch_add_explicit(&shm->gen, 1, memory_order_release);
+    syscall(SYS_futex, (uint32_t *)&shm->gen, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+void shm_metrics_destroy(shm_metrics_t *shm, const char *name) {
+    if (!shm) return;
+    shm->magic = 0;
+    munmap(shm, sizeof(*shm));
+    shm_unlink(name);
+}
+
+const shm_metrics_t *shm_metrics_attach(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return NULL;
+    void *p = mmap(NULL, sizeof(shm_metrics_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    const shm_metrics_t *shm = p;
+    if (shm->magic != SHM_METRICS_MAGIC || shm->version != SHM_METRICS_VERSION ||
+        shm->ring_len != SHM_RING_LEN) {
+        munmap(p, sizeof(shm_metrics_t));
+        return NULL;
+    }
+    return shm;
+}
+
+void shm_metrics_detach(const shm_metrics_t *shm) {
+    if (shm) munmap((void *)shm, sizeof(*shm));
+}
+
+// Waits before a seqlock retry. A writer is mid-update for nanoseconds unless it was
+// preempted there; false once it has taken so long that it is presumably gone (a
+// monitor killed inside a publish leaves the count odd for good).
+static bool seq_backoff(unsigned int *tries) {
+    unsigned int t = (*tries)++;
+    if (t < SEQ_SPINS) { cpu_relax(); return true; }
+    if (t >= SEQ_SPINS + SEQ_SLEEPS) return false;
+    nanosleep(&(struct timespec){ .tv_nsec = 100000 }, NULL);
+    return true;
+}
+
+bool shm_metrics_latest(const shm_metrics_t *shm, metric_kind_t kind, shm_sample_t *out) {
+    if ((unsigned)kind >= shm->nkinds || (unsigned)kind >= METRIC_KIND_COUNT) return false;
+    const shm_kind_t *k = &shm->kinds[kind];
+    for (unsigned int tries = 0;;) {
+        uint32_t s1 = atomic_load_explicit(&k->latest_seq, memory_order_acquire);
+        if (s1 == 0) return false; // nothing published yet
+        if (!(s1 & 1)) { // even: no write in progress
+            *out = k->latest;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&k->latest_seq, memory_order_relaxed) == s1) return true;
+        }
+        if (!seq_backoff(&tries)) return false;
+    }
+}
+
+bool shm_metrics_aggregates(const shm_metrics_t *shm, metric_kind_t kind, agg_summary_t *out) {
+    if ((unsigned)kind >= shm->nkinds || (unsigned)kind >= METRIC_KIND_COUNT) return false;
+    const shm_kind_t *k = &shm->kinds[kind];
+    for (unsigned int tries = 0;;) {
+        uint32_t s1 = atomic_load_explicit(&k->agg_seq, memory_order_acquire);
+        if (s1 == 0) return false;
+        if (!(s1 & 1)) {
+            *out = k->agg;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&k->agg_seq, memory_order_relaxed) == s1) return true;
+        }
+        if (!seq_backoff(&tries)) return false;
+    }
+}
+
+size_t shm_metrics_read(const shm_metrics_t *shm, metric_kind_t kind, uint64_t *cursor,
+                        shm_sample_t *out, size_t max) {
+    if ((unsigned)kind >= shm->nkinds || (unsigned)kind >= METRIC_KIND_COUNT) return 0;
+    const shm_kind_t *k = &shm->kinds[kind];
+    uint64_t head = atomic_load_explicit(&k->head, memory_order_acquire);
+    if (*cursor > head) *cursor = head;                           // writer restarted
+    if (head - *cursor > SHM_RING_LEN) *cursor = head - SHM_RING_LEN; // fell behind: skip
+    size_t n = 0;
+    while (*cursor < head && n < max) {
+        const shm_slot_t *slot = &k->ring[*cursor & (SHM_RING_LEN - 1)];
+        uint64_t want = *cursor + 1;
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != want) { (*cursor)++; continue; }
+        shm_sample_t s = slot->s;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) == want) out[n++] = s;
+        (*cursor)++;
+    }
+    return n;
+}
+
+uint32_t shm_metrics_wait(const shm_metrics_t *shm, uint32_t seen, int timeout_ms) {
+    uint32_t cur = atomic_load_explicit(&shm->gen, memory_order_acquire);
+    if (cur != seen) return cur;
+    struct timespec ts, *tp = NULL;
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        tp = &ts;
+    }
+    syscall(SYS_futex, (uint32_t *)&shm->gen, FUTEX_WAIT, seen, tp, NULL, 0);
+    return atomic_load_explicit(&shm->gen, memory_order_acquire);
+}
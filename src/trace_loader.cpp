@@ -0,0 +1,386 @@
+#include "trace_loader.h"
+#include "proc_trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Below this a single thread is faster than starting workers.
+constexpr size_t kMinChunkBytes = 4u << 20;
+
+// Read-only view of a whole file: mmap for regular files, a heap copy otherwise
+// (pipes, /dev/stdin, files that fail to map).
+class FileView {
+public:
+    explicit FileView(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+                map_ = p; data_ = (const char*)p; size_ = (size_t)st.st_size; ok_ = true;
+                close(fd);
+                return;
+            }
+        }
+        char tmp[1 << 16];
+        ssize_t r;
+        while ((r = read(fd, tmp, sizeof(tmp))) > 0) copy_.insert(copy_.end(), tmp, tmp + r);
+        ok_ = r == 0;
+        data_ = copy_.data(); size_ = copy_.size();
+        close(fd);
+    }
+    ~FileView() { if (map_) munmap(map_, size_); }
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    bool ok() const { return ok_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void* map_ = nullptr;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool ok_ = false;
+    std::vector<char> copy_;
+};
+
+// One integer field ending at ',', ';' or the end of the line. Leading blanks and a '+'
+// are accepted; anything after the digits up to the separator is ignored.
+// Returns 1 on a value, 0 on an empty field, -1 on garbage.
+int parseField(const char*& p, const char* end, int& out) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    const char* q = p;
+    if (q < end && *q == '+') q++;
+    int rc = 0;
+    if (q < end && *q != ',' && *q != ';' && *q != '\r') {
+        auto r = std::from_chars(q, end, out);
+        rc = r.ec == std::errc() ? 1 : -1;
+        q = r.ptr;
+    }
+    while (q < end && *q != ',' && *q != ';') q++;
+    p = q < end ? q + 1 : end;
+    return rc;
+}
+
+// One CSV row [b, le) without its newline; false unless it holds four integers.
+bool parseLine(const char* b, const char* le, Process& out) {
+    int v[4], got = 0;
+    const char* p = b;
+    while (p < le && got < 4) {
+        int rc = parseField(p, le, v[got]);
+        if (rc < 0) break;
+        got += rc;
+    }
+    if (got != 4) return false;
+    out = {v[0], v[1], v[2], v[3]};
+    return true;
+}
+
+bool isHeader(const char* b, const char* le) {
+    return std::string_view(b, (size_t)(le - b)).find("PID") != std::string_view::npos;
+}
+
+// Parses [b, e) into out. Every line in the range is data (the header is handled by
+// the caller).
+void parseChunk(const char* b, const char* e, std::vector<Process>& out, size_t& skipped) {
+    // The shortest row is "1,0,1,0\n"; reserved but untouched pages cost nothing.
+    out.reserve((size_t)(e - b) / 8 + 1);
+    while (b < e) {
+        const char* nl = (const char*)std::memchr(b, '\n', (size_t)(e - b));
+        const char* le = nl ? nl : e;
+        if (le > b) {
+            Process pr;
+            if (parseLine(b, le, pr)) out.push_back(pr);
+            else skipped++;
+        }
+        b = nl ? nl + 1 : e;
+    }
+}
+
+// ---- captured traces (proc_trace.h) ----
+
+constexpr size_t kCapturedHeader = 12;
+// Longest block header (two varints) plus the longest record (three).
+constexpr size_t kMaxCapturedStep = 5 * 10;
+
+// 1 = value, 0 = input ends inside it, -1 = longer than any uint64.
+int getVarint(const char*& p, const char* end, std::uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 70; shift += 7) {
+        if (p == end) return 0;
+        std::uint8_t b = (std::uint8_t)*p++;
+        v |= (std::uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return 1;
+    }
+    return -1;
+}
+
+// Decodes the next record at p. `time` and `left` carry the current block between
+// calls; p only moves past whole block headers and records.
+// 1 = record, 0 = input ends inside a header or record, -1 = corrupt.
+int decodeCaptured(const char*& p, const char* end, std::int64_t& time, std::uint64_t& left, Process& out) {
+    std::uint64_t v[3];
+    while (left == 0) {
+        const char* q = p;
+        int a = getVarint(q, end, v[0]), b = a > 0 ? getVarint(q, end, v[1]) : a;
+        if (b <= 0) return b;
+        if (v[0] > (std::uint64_t)(INT_MAX - time)) return -1;
+        time += (std::int64_t)v[0];
+        left = v[1];
+        p = q;
+    }
+    const char* q = p;
+    for (int k = 0; k < 3; k++) {
+        int rc = getVarint(q, end, v[k]);
+        if (rc <= 0) return rc;
+    }
+    if (v[0] > INT_MAX) return -1;
+    std::int64_t nice = (std::int64_t)(v[2] >> 1) ^ -(std::int64_t)(v[2] & 1);
+    out = {(int)v[0], (int)time, (int)std::min<std::uint64_t>(v[1], INT_MAX), (int)nice};
+    left--;
+    p = q;
+    return 1;
+}
+
+std::vector<Process> loadCaptured(const FileView& f, TraceLoadStats& st) {
+    std::vector<Process> out;
+    st.captured = true;
+    st.chunks = 1;
+    if (f.size() < kCapturedHeader) return out;
+    const char* p = f.data() + kCapturedHeader;
+    const char* e = f.data() + f.size();
+    // Records are at least three bytes.
+    out.reserve((size_t)(e - p) / 3);
+    std::int64_t time = 0;
+    std::uint64_t left = 0;
+    Process pr;
+    int rc;
+    while ((rc = decodeCaptured(p, e, time, left, pr)) > 0) out.push_back(pr);
+    st.truncated = p != e;
+    st.rows = out.size();
+    out.shrink_to_fit();
+    return out;
+}
+
+std::vector<Process> loadBinary(const FileView& f, TraceLoadStats& st) {
+    std::vector<Process> out;
+    const size_t hdr = 8 + sizeof(std::uint64_t);
+    static_assert(sizeof(Process) == 4 * sizeof(std::int32_t), "Process must be four packed ints");
+    if (f.size() < hdr) return out;
+    std::uint64_t n;
+    std::memcpy(&n, f.data() + 8, sizeof(n));
+    if (n > (f.size() - hdr) / sizeof(Process)) n = (f.size() - hdr) / sizeof(Process);
+    out.resize((size_t)n);
+    std::memcpy(out.data(), f.data() + hdr, (size_t)n * sizeof(Process));
+    st.rows = out.size();
+    st.chunks = 1;
+    st.binary = true;
+    return out;
+}
+
+std::vector<Process> loadCsv(const FileView& f, unsigned threads, TraceLoadStats& st) {
+    const char* b = f.data();
+    const char* e = b + f.size();
+    // The first non-empty line is a header if it mentions PID.
+    while (b < e && *b == '\n') b++;
+    const char* nl = (const char*)std::memchr(b, '\n', (size_t)(e - b));
+    const char* le = nl ? nl : e;
+    if (isHeader(b, le)) b = nl ? nl + 1 : e;
+
+    size_t bytes = (size_t)(e - b);
+    unsigned chunks = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, bytes / kMinChunkBytes));
+    std::vector<const char*> cut(chunks + 1);
+    cut[0] = b; cut[chunks] = e;
+    for (unsigned k = 1; k < chunks; k++) {
+        const char* c = b + bytes * k / chunks;
+        if (c < cut[k - 1]) c = cut[k - 1];
+        const char* n = (const char*)std::memchr(c, '\n', (size_t)(e - c));
+        cut[k] = n ? n + 1 : e;
+    }
+
+    std::vector<std::vector<Process>> parts(chunks);
+    std::vector<size_t> bad(chunks);
+    if (chunks == 1) {
+        parseChunk(cut[0], cut[1], parts[0], bad[0]);
+    } else {
+        std::vector<std::thread> workers;
+        for (unsigned k = 0; k < chunks; k++)
+            workers.emplace_back([&, k]{ parseChunk(cut[k], cut[k + 1], parts[k], bad[k]); });
+        for (auto& w : workers) w.join();
+    }
+    st.chunks = chunks;
+    if (chunks == 1) {
+        st.rows = parts[0].size();
+        st.skipped = bad[0];
+        parts[0].shrink_to_fit();
+        return std::move(parts[0]);
+    }
+
+    // Ordered merge: chunk k lands at the sum of the sizes before it.
+    std::vector<size_t> at(chunks + 1, 0);
+    for (unsigned k = 0; k < chunks; k++) { at[k + 1] = at[k] + parts[k].size(); st.skipped += bad[k]; }
+    std::vector<Process> out(at[chunks]);
+    std::vector<std::thread> workers;
+    for (unsigned k = 0; k < chunks; k++)
+        workers.emplace_back([&, k]{
+            std::copy(parts[k].begin(), parts[k].end(), out.begin() + (std::ptrdiff_t)at[k]);
+            std::vector<Process>().swap(parts[k]);
+        });
+    for (auto& w : workers) w.join();
+    st.rows = out.size();
+    return out;
+}
+
+} // namespace
+
+std::vector<Process> loadTrace(const std::string& path, unsigned threads, TraceLoadStats* stats) {
+    TraceLoadStats st;
+    std::vector<Process> out;
+    FileView f(path);
+    if (f.ok()) {
+        st.bytes = f.size();
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        if (f.size() >= 8 && std::memcmp(f.data(), TRACE_MAGIC, 8) == 0) out = loadBinary(f, st);
+        else if (f.size() >= 8 && std::memcmp(f.data(), PROC_TRACE_MAGIC, 8) == 0) out = loadCaptured(f, st);
+        else out = loadCsv(f, threads, st);
+    }
+    if (stats) *stats = st;
+    return out;
+}
+
+bool saveBinaryTrace(const std::string& path, const std::vector<Process>& procs) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::uint64_t n = procs.size();
+    bool ok = std::fwrite(TRACE_MAGIC, 1, 8, f) == 8 &&
+              std::fwrite(&n, sizeof(n), 1, f) == 1 &&
+              std::fwrite(procs.data(), sizeof(Process), procs.size(), f) == procs.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+TraceReader::TraceReader(const std::string& path, size_t bufferBytes)
+    : buf_(std::max<size_t>(bufferBytes, 4096)) {
+    fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) { error_ = path + ": " + std::strerror(errno); return; }
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    while (len_ < kCapturedHeader + 8 && fill()) {}
+    const char* d = buf_.data();
+    if (len_ >= 8 && std::memcmp(d, TRACE_MAGIC, 8) == 0) {
+        if (len_ < 16) { fail("short binary trace header"); return; }
+        std::memcpy(&left_, d + 8, sizeof(left_));
+        fmt_ = Format::Binary;
+        pos_ = 16;
+        st_.binary = true;
+    } else if (len_ >= 8 && std::memcmp(d, PROC_TRACE_MAGIC, 8) == 0) {
+        if (len_ < kCapturedHeader) { fail("short captured trace header"); return; }
+        fmt_ = Format::Captured;
+        pos_ = kCapturedHeader;
+        st_.captured = true;
+    }
+    st_.chunks = 1;
+}
+
+TraceReader::~TraceReader() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool TraceReader::fail(const char* what) {
+    if (error_.empty()) error_ = what;
+    return false;
+}
+
+// Moves the unread tail to the front and reads once more; false if nothing was added.
+bool TraceReader::fill() {
+    if (eof_ || fd_ < 0) return false;
+    if (pos_ > 0) {
+        std::memmove(buf_.data(), buf_.data() + pos_, len_ - pos_);
+        len_ -= pos_;
+        pos_ = 0;
+    }
+    if (len_ == buf_.size()) return false;
+    ssize_t r;
+    do r = read(fd_, buf_.data() + len_, buf_.size() - len_); while (r < 0 && errno == EINTR);
+    if (r <= 0) {
+        eof_ = true;
+        if (r < 0) fail(std::strerror(errno));
+        return false;
+    }
+    len_ += (size_t)r;
+    st_.bytes += (size_t)r;
+    return true;
+}
+
+bool TraceReader::nextCsv(Process& out) {
+    for (;;) {
+        const char* b = buf_.data() + pos_;
+        const char* e = buf_.data() + len_;
+        const char* nl = (const char*)std::memchr(b, '\n', (size_t)(e - b));
+        if (!nl && !eof_) {
+            if (!fill() && !eof_) return fail("line longer than the read buffer");
+            continue;
+        }
+        if (!nl && b == e) return false;
+        const char* le = nl ? nl : e;
+        pos_ = (size_t)((nl ? nl + 1 : e) - buf_.data());
+        if (le == b) continue;
+        if (header_) {
+            header_ = false;
+            if (isHeader(b, le)) continue;
+        }
+        if (parseLine(b, le, out)) return true;
+        st_.skipped++;
+    }
+}
+
+bool TraceReader::nextBinary(Process& out) {
+    if (left_ == 0) return false;
+    if (len_ - pos_ < sizeof(Process)) fill();
+    if (len_ - pos_ < sizeof(Process)) { st_.truncated = true; return false; }
+    std::memcpy(&out, buf_.data() + pos_, sizeof(Process));
+    pos_ += sizeof(Process);
+    left_--;
+    return true;
+}
+
+bool TraceReader::nextCaptured(Process& out) {
+    for (;;) {
+        if (len_ - pos_ < kMaxCapturedStep) fill();
+        const char* p = buf_.data() + pos_;
+        int rc = decodeCaptured(p, buf_.data() + len_, time_, left_, out);
+        pos_ = (size_t)(p - buf_.data());
+        if (rc > 0) return true;
+        if (rc < 0) return fail("corrupt captured trace");
+        if (eof_) {
+            st_.truncated = pos_ < len_;
+            return false;
+        }
+    }
+}
+
+bool TraceReader::next(Process& out) {
+    if (fd_ < 0 || !error_.empty()) return false;
+    bool ok = fmt_ == Format::Csv ? nextCsv(out) : fmt_ == Format::Binary ? nextBinary(out) : nextCaptured(out);
+    if (!ok) return false;
+    if (out.arrival < lastArrival_) {
+        error_ = "row " + std::to_string(st_.rows + 1) + ": not sorted by arrival";
+        return false;
+    }
+    lastArrival_ = out.arrival;
+    st_.rows++;
+    return true;
+}
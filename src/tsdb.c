@@ -0,0 +1,515 @@
+#define _GNU_SOURCE
+#include "tsdb.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SEG_HEADER_BYTES 4096
+#define SEG_NAME_FMT "seg-%08u.tsm"
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint64_t capacity;     // records
+    uint64_t index_offset; // bytes from segment start
+    uint64_t data_offset;
+    _Atomic uint64_t count; // committed records, published with release semantics
+    _Atomic uint64_t min_ts;
+    _Atomic uint64_t max_ts;
+} seg_hdr_t;
+
+_Static_assert(sizeof(tsdb_record_t) == 32, "tsdb_record_t must stay 32 bytes");
+
+typedef struct {
+    int fd;
+    uint8_t *map;
+    size_t len;
+    seg_hdr_t *hdr;
+    _Atomic uint64_t *index; // running max ts at the end of each TSDB_INDEX_STRIDE chunk
+    tsdb_record_t *recs;
+} segment_t;
+
+struct tsdb {
+    char dir[256];
+    size_t seg_bytes;
+    unsigned int max_segments;
+    unsigned int seg_no;
+    segment_t seg;
+    uint64_t running_max;
+};
+
+static void seg_unmap(segment_t *s) {
+    if (s->map) munmap(s->map, s->len);
+    if (s->fd >= 0) close(s->fd);
+    s->map = NULL; s->fd = -1;
+}
+
+static int seg_map(segment_t *s, const char *path, bool writable) {
+    s->map = NULL;
+    s->fd = open(path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (s->fd < 0) return -1;
+    struct stat st;
+    if (fstat(s->fd, &st) != 0 || (size_t)st.st_size < SEG_HEADER_BYTES) { seg_unmap(s); return -1; }
+    s->len = (size_t)st.st_size;
+    void *p = mmap(NULL, s->len, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, s->fd, 0);
+    if (p == MAP_FAILED) { s->map = NULL; seg_unmap(s); return -1; }
+    s->map = p;
+    s->hdr = (seg_hdr_t *)s->map;
+    if (s->hdr->magic != TSDB_MAGIC || s->hdr->version != TSDB_VERSION ||
+        s->hdr->record_size != sizeof(tsdb_record_t) ||
+        s->hdr->data_offset + s->hdr->capacity * sizeof(tsdb_record_t) > s->len) {
+        seg_unmap(s);
+        return -1;
+    }
+    s->index = (_Atomic uint64_t *)(s->map + s->hdr->index_offset);
+    s->recs = (tsdb_record_t *)(s->map + s->hdr->data_offset);
+    return 0;
+}
+
+static int seg_create(segment_t *s, const char *path, size_t bytes) {
+    uint64_t capacity = (uint64_t)((double)(bytes - SEG_HEADER_BYTES) /
+                                   (sizeof(tsdb_record_t) + 8.0 / TSDB_INDEX_STRIDE));
+    uint64_t index_bytes = ((capacity + TSDB_INDEX_STRIDE - 1) / TSDB_INDEX_STRIDE) * 8;
+    uint64_t data_offset = SEG_HEADER_BYTES + ((index_bytes + 63) & ~(uint64_t)63);
+    while (capacity > 0 && data_offset + capacity * sizeof(tsdb_record_t) > bytes) capacity--;
+    if (capacity == 0) { errno = EINVAL; return -1; }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    // Preallocate so appends never hit ENOSPC through a page fault.
+    if (posix_fallocate(fd, 0, (off_t)bytes) != 0 && ftruncate(fd, (off_t)bytes) != 0) {
+        close(fd); unlink(path); return -1;
+    }
+    seg_hdr_t h = { .magic = TSDB_MAGIC, .version = TSDB_VERSION, .record_size = sizeof(tsdb_record_t),
+                    .capacity = capacity, .index_offset = SEG_HEADER_BYTES, .data_offset = data_offset };
+    atomic_init(&h.count, 0);
+    atomic_init(&h.min_ts, UINT64_MAX);
+    atomic_init(&h.max_ts, 0);
+    if (pwrite(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) { close(fd); unlink(path); return -1; }
+    close(fd);
+    return seg_map(s, path, true);
+}
+
+// Sorted list of segment numbers in dir; caller frees.
+static int list_segments(const char *dir, unsigned int **out) {
+    *out = NULL;
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+    size_t n = 0, cap = 0;
+    unsigned int *v = NULL;
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        unsigned int no;
+        int len = 0;
+        if (sscanf(e->d_name, "seg-%8u.tsm%n", &no, &len) != 1 || e->d_name[len] != '\0' || len == 0) continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 16;
+            unsigned int *nv = realloc(v, cap * sizeof(*v));
+            if (!nv) { free(v); closedir(d); return -1; }
+            v = nv;
+        }
+        v[n++] = no;
+    }
+    closedir(d);
+    for (size_t i = 1; i < n; i++) { // insertion sort: segment counts are small
+        unsigned int x = v[i]; size_t j = i;
+        while (j > 0 && v[j - 1] > x) { v[j] = v[j - 1]; j--; }
+        v[j] = x;
+    }
+    *out = v;
+    return (int)n;
+}
+
+static void seg_path(char *buf, size_t cap, const char *dir, unsigned int no) {
+    snprintf(buf, cap, "%s/" SEG_NAME_FMT, dir, no);
+}
+
+static void enforce_retention(tsdb_t *db) {
+    if (db->max_segments == TSDB_KEEP_ALL) return; // tsdb_compact's job
+    unsigned int *segs;
+    int n = list_segments(db->dir, &segs);
+    for (int i = 0; i + (int)db->max_segments < n; i++) {
+        char path[320];
+        seg_path(path, sizeof(path), db->dir, segs[i]);
+        unlink(path);
+    }
+    free(segs);
+}
+
+static int rotate(tsdb_t *db) {
+    if (db->seg.map) { msync(db->seg.map, db->seg.len, MS_ASYNC); seg_unmap(&db->seg); }
+    db->seg_no++;
+    char path[320];
+    seg_path(path, sizeof(path), db->dir, db->seg_no);
+    if (seg_create(&db->seg, path, db->seg_bytes) != 0) { perror("tsdb segment"); return -1; }
+    db->running_max = 0;
+    enforce_retention(db);
+    return 0;
+}
+
+tsdb_t *tsdb_open(const char *dir, size_t segment_bytes, unsigned int max_segments) {
+    tsdb_t *db = calloc(1, sizeof(*db));
+    if (!db) return NULL;
+    snprintf(db->dir, sizeof(db->dir), "%s", dir);
+    db->seg_bytes = segment_bytes ? segment_bytes : TSDB_DEFAULT_SEGMENT_BYTES;
+    db->max_segments = max_segments ? max_segments : TSDB_DEFAULT_MAX_SEGMENTS;
+    db->seg.fd = -1;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) { free(db); return NULL; }
+
+    unsigned int *segs;
+    int n = list_segments(dir, &segs);
+    if (n > 0) {
+        // Continue the newest segment if it still has room.
+        char path[320];
+        db->seg_no = segs[n - 1];
+        seg_path(path, sizeof(path), dir, db->seg_no);
+        if (seg_map(&db->seg, path, true) == 0) {
+            db->running_max = atomic_load(&db->seg.hdr->max_ts);
+            if (atomic_load(&db->seg.hdr->count) >= db->seg.hdr->capacity) seg_unmap(&db->seg);
+        }
+    }
+    free(segs);
+    if (!db->seg.map && rotate(db) != 0) { free(db); return NULL; }
+    return db;
+}
+
+int tsdb_append(tsdb_t *db, const metric_t *m) {
+    uint64_t i = atomic_load_explicit(&db->seg.hdr->count, memory_order_relaxed);
+    if (i >= db->seg.hdr->capacity) {
+        if (rotate(db) != 0) return -1;
+        i = 0;
+    }
+    tsdb_record_t *r = &db->seg.recs[i];
+    *r = (tsdb_record_t){ .ts_ms = m->ts_ms, .kind = (uint16_t)m->kind,
+                          .interval_ms = (uint16_t)(m->interval_ms > UINT16_MAX ? UINT16_MAX : m->interval_ms),
+                          .id = m->id, .v1 = m->v1, .v2 = m->v2 };
+    if (m->ts_ms > db->running_max) db->running_max = m->ts_ms;
+    atomic_store_explicit(&db->seg.index[i / TSDB_INDEX_STRIDE], db->running_max, memory_order_relaxed);
+    if (m->ts_ms < atomic_load_explicit(&db->seg.hdr->min_ts, memory_order_relaxed))
+        atomic_store_explicit(&db->seg.hdr->min_ts, m->ts_ms, memory_order_relaxed);
+    atomic_store_explicit(&db->seg.hdr->max_ts, db->running_max, memory_order_relaxed);
+    atomic_store_explicit(&db->seg.hdr->count, i + 1, memory_order_release);
+    return 0;
+}
+
+void tsdb_sync(tsdb_t *db) {
+    if (db->seg.map) msync(db->seg.map, db->seg.len, MS_ASYNC);
+}
+
+void tsdb_close(tsdb_t *db) {
+    if (!db) return;
+    tsdb_sync(db);
+    seg_unmap(&db->seg);
+    free(db);
+}
+
+// ---- Retention tiers ----
+
+typedef struct { const char *name; uint64_t bucket_ms; unsigned int unit_ms; } tier_t;
+static const tier_t tiers[TSDB_TIERS] = { { "", 0, 1 }, { "1m", 60000, 1 }, { "1h", 3600000, 1000 } };
+#define ROLLUP_CHUNK 262144 // metrics sorted and merged at a time
+
+static void tier_dir(char *buf, size_t cap, const char *dir, int tier) {
+    snprintf(buf, cap, tier ? "%s/%s" : "%s", dir, tiers[tier].name);
+}
+
+static int cmp_bucketed(const void *a, const void *b) {
+    const metric_t *x = a, *y = b;
+    if (x->ts_ms != y->ts_ms) return x->ts_ms < y->ts_ms ? -1 : 1;
+    bool ax = x->kind == METRIC_ALERT, ay = y->kind == METRIC_ALERT;
+    if (ax != ay) return ax ? 1 : -1;
+    if (x->kind != y->kind) return x->kind < y->kind ? -1 : 1;
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+// Sorting by (bucket, kind, id) puts each series' samples of a bucket next to each
+// other and keeps the output in time order. A bucket split across two calls just
+// gets two records; their intervals keep the weighting right.
+static int rollup_chunk(tsdb_t *db, const tier_t *t, metric_t *v, size_t n) {
+    for (size_t i = 0; i < n; i++) v[i].ts_ms -= v[i].ts_ms % t->bucket_ms;
+    qsort(v, n, sizeof(*v), cmp_bucketed);
+    for (size_t i = 0, j; i < n; i = j) {
+        if (v[i].kind == METRIC_ALERT) {
+            metric_t m = v[i];
+            m.interval_ms = 0;
+            if (tsdb_append(db, &m) != 0) return -1;
+            j = i + 1;
+            continue;
+        }
+        double w = 0, s1 = 0, s2 = 0;
+        uint64_t covered = 0;
+        bool known = true;
+        for (j = i; j < n && v[j].ts_ms == v[i].ts_ms && v[j].kind == v[i].kind && v[j].id == v[i].id; j++) {
+            double wj = v[j].interval_ms ? v[j].interval_ms : 1.0;
+            w += wj; s1 += v[j].v1 * wj; s2 += v[j].v2 * wj;
+            covered += v[j].interval_ms;
+            known &= v[j].interval_ms != 0;
+        }
+        covered /= t->unit_ms;
+        metric_t m = { .kind = v[i].kind, .id = v[i].id, .v1 = s1 / w, .v2 = s2 / w, .ts_ms = v[i].ts_ms,
+                       .interval_ms = known ? (uint32_t)(covered > UINT16_MAX ? UINT16_MAX : covered) : 0 };
+        if (tsdb_append(db, &m) != 0) return -1;
+    }
+    return 0;
+}
+
+int tsdb_rollup(const char *dir, int tier, const metric_t *ms, size_t n) {
+    if (tier < 1 || tier >= TSDB_TIERS) { errno = EINVAL; return -1; }
+    if (n == 0) return 0;
+    char tdir[320];
+    tier_dir(tdir, sizeof(tdir), dir, tier);
+    size_t cap = n < ROLLUP_CHUNK ? n : ROLLUP_CHUNK;
+    metric_t *v = malloc(cap * sizeof(*v));
+    tsdb_t *db = v ? tsdb_open(tdir, TSDB_TIER_SEGMENT_BYTES, TSDB_KEEP_ALL) : NULL;
+    int rc = db ? 0 : -1;
+    for (size_t off = 0; rc == 0 && off < n; off += cap) {
+        size_t k = n - off < cap ? n - off : cap;
+        memcpy(v, ms + off, k * sizeof(*v));
+        rc = rollup_chunk(db, &tiers[tier], v, k);
+    }
+    tsdb_close(db);
+    free(v);
+    return rc;
+}
+
+int tsdb_tier_mark(const char *dir, int tier, tsdb_mark_t *m) {
+    *m = (tsdb_mark_t){ 0, 0 };
+    if (tier < 0 || tier >= TSDB_TIERS) { errno = EINVAL; return -1; }
+    char tdir[320], path[400];
+    tier_dir(tdir, sizeof(tdir), dir, tier);
+    unsigned int *segs;
+    int n = list_segments(tdir, &segs);
+    if (n <= 0) { free(segs); return n < 0 && errno != ENOENT ? -1 : 0; }
+    m->seg = segs[n - 1];
+    free(segs);
+    segment_t s = { .fd = -1 };
+    seg_path(path, sizeof(path), tdir, m->seg);
+    if (seg_map(&s, path, false) != 0) return -1;
+    m->count = atomic_load_explicit(&s.hdr->count, memory_order_acquire);
+    seg_unmap(&s);
+    return 0;
+}
+
+int tsdb_tier_rewind(const char *dir, int tier, const tsdb_mark_t *m) {
+    if (tier < 0 || tier >= TSDB_TIERS) { errno = EINVAL; return -1; }
+    char tdir[320], path[400];
+    tier_dir(tdir, sizeof(tdir), dir, tier);
+    unsigned int *segs;
+    int n = list_segments(tdir, &segs);
+    if (n < 0) return errno == ENOENT ? 0 : -1;
+    int rc = 0;
+    for (int i = n - 1; i >= 0 && segs[i] > m->seg; i--) { // newest first: a stop leaves a prefix
+        seg_path(path, sizeof(path), tdir, segs[i]);
+        if (unlink(path) != 0 && errno != ENOENT) rc = -1;
+    }
+    free(segs);
+    segment_t s = { .fd = -1 };
+    seg_path(path, sizeof(path), tdir, m->seg);
+    if (rc != 0 || m->seg == 0) return rc;
+    if (seg_map(&s, path, true) != 0) return errno == ENOENT ? 0 : -1;
+    if (m->count < atomic_load_explicit(&s.hdr->count, memory_order_acquire)) {
+        // Index entries of whole chunks never change after the fact, but the bounds
+        // may have moved since the mark: they come from the records that stay.
+        uint64_t lo = UINT64_MAX, hi = 0;
+        for (uint64_t i = 0; i < m->count; i++) {
+            if (s.recs[i].ts_ms < lo) lo = s.recs[i].ts_ms;
+            if (s.recs[i].ts_ms > hi) hi = s.recs[i].ts_ms;
+        }
+        atomic_store(&s.hdr->min_ts, lo);
+        atomic_store(&s.hdr->max_ts, hi);
+        atomic_store_explicit(&s.hdr->count, m->count, memory_order_release);
+        if (msync(s.map, s.len, MS_SYNC) != 0) rc = -1;
+    }
+    seg_unmap(&s);
+    return rc;
+}
+
+// Rolls one segment of tier `from` up into the next tier.
+static int rollup_segment(const char *dir, int from, const char *path) {
+    segment_t s = { .fd = -1 };
+    if (seg_map(&s, path, false) != 0) return -1;
+    uint64_t count = atomic_load_explicit(&s.hdr->count, memory_order_acquire);
+    metric_t *v = malloc((count < ROLLUP_CHUNK ? count : ROLLUP_CHUNK) * sizeof(*v) + 1);
+    int rc = v ? 0 : -1;
+    for (uint64_t off = 0; rc == 0 && off < count; off += ROLLUP_CHUNK) {
+        size_t k = count - off < ROLLUP_CHUNK ? (size_t)(count - off) : ROLLUP_CHUNK;
+        for (size_t i = 0; i < k; i++) {
+            const tsdb_record_t *r = &s.recs[off + i];
+            v[i] = (metric_t){ .kind = (metric_kind_t)r->kind, .id = r->id, .v1 = r->v1, .v2 = r->v2,
+                               .ts_ms = r->ts_ms, .interval_ms = r->interval_ms * tiers[from].unit_ms };
+        }
+        rc = tsdb_rollup(dir, from + 1, v, k);
+    }
+    free(v);
+    seg_unmap(&s);
+    return rc;
+}
+
+int tsdb_compact(const char *dir, unsigned int max_segments) {
+    if (max_segments == 0 || max_segments == TSDB_KEEP_ALL) max_segments = TSDB_DEFAULT_MAX_SEGMENTS;
+    int retired = 0;
+    for (int t = 0; t < TSDB_TIERS; t++) {
+        char tdir[320];
+        tier_dir(tdir, sizeof(tdir), dir, t);
+        unsigned int *segs;
+        int n = list_segments(tdir, &segs);
+        if (n < 0 && t == 0) return -1;
+        unsigned int keep = t == 0 ? max_segments : TSDB_TIER_MAX_SEGMENTS;
+        for (int i = 0; i + (int)keep < n; i++) {
+            char path[400];
+            seg_path(path, sizeof(path), tdir, segs[i]);
+            // A segment that cannot be rolled up stays for the next pass.
+            if (t + 1 < TSDB_TIERS && rollup_segment(dir, t, path) != 0) { perror(path); break; }
+            unlink(path);
+            retired++;
+        }
+        free(segs);
+    }
+    return retired;
+}
+
+// ---- Queries ----
+
+static int scan_segment(const segment_t *s, metric_kind_t kind, uint32_t id, uint64_t t0, uint64_t t1,
+                        tsdb_visit_fn fn, void *arg, bool *stop) {
+    uint64_t count = atomic_load_explicit(&s->hdr->count, memory_order_acquire);
+    if (count == 0) return 0;
+    if (atomic_load(&s->hdr->max_ts) < t0) return 0;
+    // Only chunks that are complete have a final index entry.
+    uint64_t lo = 0, hi = count / TSDB_INDEX_STRIDE;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (atomic_load_explicit(&s->index[mid], memory_order_relaxed) < t0) lo = mid + 1;
+        else hi = mid;
+    }
+    uint64_t limit = t1 > UINT64_MAX - TSDB_REORDER_SLACK_MS ? UINT64_MAX : t1 + TSDB_REORDER_SLACK_MS;
+    for (uint64_t i = lo * TSDB_INDEX_STRIDE; i < count; i++) {
+        const tsdb_record_t *r = &s->recs[i];
+        if (r->ts_ms > limit) { *stop = true; break; }
+        if (r->kind != kind || r->ts_ms < t0 || r->ts_ms > t1) continue;
+        if (id != TSDB_ANY_ID && r->id != id) continue;
+        if (!fn(r, arg)) { *stop = true; break; }
+    }
+    return 0;
+}
+
+static int query_dir(const char *dir, metric_kind_t kind, uint32_t id, uint64_t t0, uint64_t t1,
+                     tsdb_visit_fn fn, void *arg, bool *stop) {
+    unsigned int *segs;
+    int n = list_segments(dir, &segs);
+    if (n < 0) return -1;
+    for (int i = 0; i < n && !*stop; i++) {
+        char path[320];
+        segment_t s = { .fd = -1 };
+        seg_path(path, sizeof(path), dir, segs[i]);
+        if (seg_map(&s, path, false) != 0) continue; // rotated away or not ours
+        scan_segment(&s, kind, id, t0, t1, fn, arg, stop);
+        seg_unmap(&s);
+    }
+    free(segs);
+    return 0;
+}
+
+// Oldest timestamp in a tier, UINT64_MAX if it is empty or missing.
+static uint64_t tier_oldest(const char *dir) {
+    unsigned int *segs;
+    int n = list_segments(dir, &segs);
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < n && oldest == UINT64_MAX; i++) {
+        char path[400];
+        segment_t s = { .fd = -1 };
+        seg_path(path, sizeof(path), dir, segs[i]);
+        if (seg_map(&s, path, false) != 0) continue;
+        if (atomic_load_explicit(&s.hdr->count, memory_order_acquire) > 0) oldest = atomic_load(&s.hdr->min_ts);
+        seg_unmap(&s);
+    }
+    free(segs);
+    return oldest;
+}
+
+// Each tier answers for what is older than everything the finer tiers hold; coarsest
+// first, so records come out in time order. *unit (if given) is set to the tier's
+// interval_ms unit before its records are visited.
+static int query_tiers(const char *dir, metric_kind_t kind, uint32_t id, uint64_t t0, uint64_t t1,
+                       tsdb_visit_fn fn, void *arg, unsigned int *unit) {
+    char tdir[TSDB_TIERS][320];
+    uint64_t upto[TSDB_TIERS];
+    for (int t = 0; t < TSDB_TIERS; t++) {
+        tier_dir(tdir[t], sizeof(tdir[t]), dir, t);
+        upto[t] = t1;
+        if (t > 0) {
+            uint64_t oldest = tier_oldest(tdir[t - 1]);
+            if (oldest != UINT64_MAX && oldest <= upto[t]) upto[t] = oldest ? oldest - 1 : 0;
+            if (upto[t - 1] < upto[t]) upto[t] = upto[t - 1];
+        }
+    }
+    bool stop = false;
+    for (int t = TSDB_TIERS - 1; t > 0 && !stop; t--) {
+        if (upto[t] < t0) continue;
+        if (unit) *unit = tiers[t].unit_ms;
+        query_dir(tdir[t], kind, id, t0, upto[t], fn, arg, &stop);
+    }
+    if (unit) *unit = 1;
+    return stop ? 0 : query_dir(dir, kind, id, t0, t1, fn, arg, &stop);
+}
+
+int tsdb_query(const char *dir, metric_kind_t kind, uint32_t id, uint64_t t0, uint64_t t1,
+               tsdb_visit_fn fn, void *arg) {
+    return query_tiers(dir, kind, id, t0, t1, fn, arg, NULL);
+}
+
+// Samples are weighted by the interval they cover, so adaptive runs (short intervals
+// around spikes, long ones when flat) still give time averages. Records without an
+// interval weigh 1, which is the plain per-sample figure for fixed-interval data.
+typedef struct { double v, w; } weighted_t;
+typedef struct { weighted_t *v; size_t n, cap; bool use_v2; unsigned int unit; } collect_t;
+
+static bool collect(const tsdb_record_t *r, void *arg) {
+    collect_t *c = arg;
+    if (c->n == c->cap) {
+        size_t cap = c->cap ? c->cap * 2 : 1024;
+        weighted_t *nv = realloc(c->v, cap * sizeof(weighted_t));
+        if (!nv) return false;
+        c->v = nv; c->cap = cap;
+    }
+    c->v[c->n++] = (weighted_t){ c->use_v2 ? r->v2 : r->v1, r->interval_ms ? (double)r->interval_ms * c->unit : 1.0 };
+    return true;
+}
+
+static int cmp_weighted(const void *a, const void *b) {
+    double x = ((const weighted_t *)a)->v, y = ((const weighted_t *)b)->v;
+    return (x > y) - (x < y);
+}
+
+int tsdb_stats(const char *dir, metric_kind_t kind, uint32_t id, uint64_t t0, uint64_t t1,
+               bool use_v2, const double *pcts, int npcts, tsdb_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    collect_t c = { .use_v2 = use_v2 };
+    if (query_tiers(dir, kind, id, t0, t1, collect, &c, &c.unit) != 0) return -1;
+    out->count = c.n;
+    if (c.n == 0) { free(c.v); return 0; }
+    qsort(c.v, c.n, sizeof(weighted_t), cmp_weighted);
+    double sum = 0, wsum = 0;
+    for (size_t i = 0; i < c.n; i++) { sum += c.v[i].v * c.v[i].w; wsum += c.v[i].w; }
+    out->min = c.v[0].v;
+    out->max = c.v[c.n - 1].v;
+    out->avg = sum / wsum;
+    for (int i = 0; i < npcts && i < 8; i++) {
+        // Weighted nearest-rank percentile: the first value whose cumulative weight
+        // reaches p% of the total (the plain nearest rank when weights are equal).
+        double rank = pcts[i] / 100.0 * wsum, cum = 0;
+        size_t k = 0;
+        while (k + 1 < c.n && (cum += c.v[k].w) < rank - 1e-9 * wsum) k++;
+        out->pct[i] = c.v[k].v;
+    }
+    free(c.v);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#define _GNU_SOURCE
+#include "metric_format.h"
+#include "dev_stats.h"
+#include "tsdb.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Range queries over the monitor's segment store, e.g.
+//   tsq CPU --from 10:00 --to 10:05 -p 50,95,99
+//   tsq MEM --from -15m
+//   tsq CPU_CORE --id 3 --from -1h --raw
+
+static uint64_t wall_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+// Accepts epoch milliseconds, "now", relative "-90s"/"-5m"/"-2h"/"-1d", or "HH:MM[:SS]" today (local time).
+static int parse_time(const char *s, uint64_t *out) {
+    char *end;
+    if (strcmp(s, "now") == 0) { *out = wall_ms(); return 0; }
+    if (s[0] == '-') {
+        double v = strtod(s + 1, &end);
+        double mul = *end == 's' ? 1e3 : *end == 'm' ? 60e3 : *end == 'h' ? 3600e3 : *end == 'd' ? 86400e3 : -1;
+        if (mul < 0 || end[*end ? 1 : 0] != '\0') return -1;
+        *out = wall_ms() - (uint64_t)(v * mul);
+        return 0;
+    }
+    int h, m, sec = 0, used = 0;
+    if (strchr(s, ':') && (sscanf(s, "%d:%d:%d%n", &h, &m, &sec, &used) == 3 ||
+                           sscanf(s, "%d:%d%n", &h, &m, &used) == 2) && s[used] == '\0') {
+        time_t now = time(NULL);
+        struct tm tm;
+        localtime_r(&now, &tm);
+        tm.tm_hour = h; tm.tm_min = m; tm.tm_sec = sec;
+        *out = (uint64_t)mktime(&tm) * 1000ULL;
+        return 0;
+    }
+    unsigned long long v = strtoull(s, &end, 10);
+    if (*end != '\0') return -1;
+    *out = v;
+    return 0;
+}
+
+static bool print_raw(const tsdb_record_t *r, void *arg) {
+    (void)arg;
+    metric_t m = { .kind = (metric_kind_t)r->kind, .id = r->id, .v1 = r->v1, .v2 = r->v2, .ts_ms = r->ts_ms };
+    char line[METRIC_LINE_MAX];
+    int n = metric_format_csv(line, sizeof(line), &m);
+    if (n > 0) fwrite(line, 1, (size_t)n, stdout);
+    return true;
+}
+
+// N, or MAJOR:MINOR for DISK_DEV.
+static uint32_t parse_id(const char *s) {
+    char *end;
+    unsigned long v = strtoul(s, &end, 10);
+    return *end == ':' ? DEV_KEY(v, strtoul(end + 1, NULL, 10)) : (uint32_t)v;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-d DIR] KIND [--from T] [--to T] [--id N|MAJ:MIN] [--v2] [-p P1,P2,...] [--raw]\n"
+            "  KIND: CPU MEM DISK NET CPU_CORE CPU_CORE_WAIT ALERT PROC_CPU PROC_RSS PROC_IO SELF\n"
+            "        DISK_DEV NET_DEV PSI_CPU PSI_MEM PSI_IO CGROUP_CPU CGROUP_MEM CGROUP_IO\n"
+            "  T:    epoch ms, now, -30s, -5m, -2h, -1d, or HH:MM[:SS] today\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *dir = TSDB_DEFAULT_DIR;
+    int kind = -1;
+    uint64_t t0 = 0, t1 = UINT64_MAX;
+    uint32_t id = TSDB_ANY_ID;
+    bool use_v2 = false, raw = false;
+    double pcts[8] = {50, 95, 99};
+    int npcts = 3;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        bool has_val = i + 1 < argc;
+        if (strcmp(a, "-d") == 0 && has_val) dir = argv[++i];
+        else if (strcmp(a, "--from") == 0 && has_val) { if (parse_time(argv[++i], &t0)) { usage(argv[0]); return 2; } }
+        else if (strcmp(a, "--to") == 0 && has_val) { if (parse_time(argv[++i], &t1)) { usage(argv[0]); return 2; } }
+        else if (strcmp(a, "--id") == 0 && has_val) id = parse_id(argv[++i]);
+        else if (strcmp(a, "--v2") == 0) use_v2 = true;
+        else if (strcmp(a, "--raw") == 0) raw = true;
+        else if (strcmp(a, "-p") == 0 && has_val) {
+            npcts = 0;
+            for (char *tok = strtok(argv[++i], ","); tok && npcts < 8; tok = strtok(NULL, ",")) pcts[npcts++] = atof(tok);
+        } else if (a[0] != '-' && kind < 0) {
+            kind = metric_kind_from_name(a);
+            if (kind < 0) { fprintf(stderr, "unknown metric kind %s\n", a); return 2; }
+        } else { usage(argv[0]); return 2; }
+    }
+    if (kind < 0) { usage(argv[0]); return 2; }
+
+    if (raw) return tsdb_query(dir, (metric_kind_t)kind, id, t0, t1, print_raw, NULL) == 0 ? 0 : 1;
+
+    tsdb_stats_t st;
+    if (tsdb_stats(dir, (metric_kind_t)kind, id, t0, t1, use_v2, pcts, npcts, &st) != 0) {
+        perror(dir);
+        return 1;
+    }
+    printf("kind=%s field=%s count=%llu", metric_kind_name((metric_kind_t)kind), use_v2 ? "v2" : "v1",
+           (unsigned long long)st.count);
+    if (st.count > 0) {
+        printf(" min=%.2f max=%.2f avg=%.2f", st.min, st.max, st.avg);
+        for (int i = 0; i < npcts; i++) printf(" p%g=%.2f", pcts[i], st.pct[i]);
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,108 @@
+#define _GNU_SOURCE
+#include "cgroup_stats.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// make test: cgroup tree upkeep on a real cgroup v2 hierarchy (the first cgroup2
+// mount, or argv[1]). Cgroups are created, populated, emptied and removed under a
+// scratch cgroup, and the tree must track exactly what exists, so churn never fills
+// its slots. Skipped where there is no cgroup2 mount or it cannot be written.
+
+static int failures;
+
+#define CHECK(cond, ...) do { if (!(cond)) { failures++; printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                                             printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+static bool cgroup2_mount(char *out, size_t cap) {
+    FILE *f = fopen("/proc/self/mounts", "r");
+    if (!f) return false;
+    char dev[256], dir[256], type[64];
+    bool found = false;
+    while (!found && fscanf(f, "%255s %255s %63s %*[^\n]", dev, dir, type) == 3)
+        if (strcmp(type, "cgroup2") == 0) found = snprintf(out, cap, "%s", dir) < (int)cap;
+    fclose(f);
+    return found;
+}
+
+// A cgroup is busy for a moment after its last task is reaped.
+static int rmdir_retry(const char *path) {
+    for (int i = 0; i < 100; i++) {
+        if (rmdir(path) == 0) return 0;
+        if (errno != EBUSY) break;
+        usleep(10000);
+    }
+    return -1;
+}
+
+// Puts a child that sleeps until killed into the cgroup at path.
+static pid_t spawn_in(const char *path) {
+    pid_t pid = fork();
+    if (pid == 0) { pause(); _exit(0); }
+    char procs[640];
+    snprintf(procs, sizeof(procs), "%s/cgroup.procs", path);
+    FILE *f = fopen(procs, "w");
+    if (!f || fprintf(f, "%d\n", (int)pid) < 0 || fclose(f) != 0) { kill(pid, SIGKILL); waitpid(pid, NULL, 0); return -1; }
+    return pid;
+}
+
+int main(int argc, char **argv) {
+    char mnt[256], base[512], a[600], b[600];
+    if (argc > 1) snprintf(mnt, sizeof(mnt), "%s", argv[1]);
+    else if (!cgroup2_mount(mnt, sizeof(mnt))) { printf("cgroup: no cgroup2 mount, skipped\n"); return 0; }
+    snprintf(base, sizeof(base), "%s/sysmon-test-%d", mnt, (int)getpid());
+    if (mkdir(base, 0755) != 0) { printf("cgroup: cannot create %s (%s), skipped\n", base, strerror(errno)); return 0; }
+    snprintf(a, sizeof(a), "%s/a", base);
+    snprintf(b, sizeof(b), "%s/b", base);
+
+    cgroup_tree_t *t = cgroup_tree_open(base, 8);
+    CHECK(t, "cgroup_tree_open(%s): %s", base, strerror(errno));
+    if (!t) { rmdir(base); return 1; }
+    cgroup_tree_sample(t, NULL, NULL);
+    CHECK(cgroup_tree_count(t) == 1, "%u cgroups tracked, want 1", cgroup_tree_count(t));
+
+    mkdir(a, 0755);
+    mkdir(b, 0755);
+    cgroup_tree_sample(t, NULL, NULL);
+    CHECK(cgroup_tree_count(t) == 3, "%u cgroups tracked after mkdir, want 3", cgroup_tree_count(t));
+
+    // Populate, kill and remove, as a container runtime does.
+    pid_t pid = spawn_in(a);
+    CHECK(pid > 0, "cannot move a task into %s", a);
+    if (pid > 0) {
+        cgroup_tree_sample(t, NULL, NULL);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        cgroup_tree_sample(t, NULL, NULL);
+    }
+    CHECK(rmdir_retry(a) == 0, "rmdir %s: %s", a, strerror(errno));
+    cgroup_tree_sample(t, NULL, NULL);
+    CHECK(cgroup_tree_count(t) == 2, "%u cgroups tracked after rmdir, want 2", cgroup_tree_count(t));
+
+    // Churn well past max_cgroups: removed cgroups must give their slots back.
+    for (int i = 0; i < 50; i++) {
+        mkdir(a, 0755);
+        cgroup_tree_sample(t, NULL, NULL);
+        rmdir_retry(a);
+        cgroup_tree_sample(t, NULL, NULL);
+    }
+    CHECK(cgroup_tree_count(t) == 2, "%u cgroups tracked after churn, want 2", cgroup_tree_count(t));
+    mkdir(a, 0755);
+    cgroup_tree_sample(t, NULL, NULL);
+    CHECK(cgroup_tree_count(t) == 3, "%u cgroups tracked after churn and mkdir, want 3", cgroup_tree_count(t));
+
+    rmdir_retry(a);
+    rmdir_retry(b);
+    cgroup_tree_sample(t, NULL, NULL);
+    CHECK(cgroup_tree_count(t) == 1, "%u cgroups tracked at the end, want 1", cgroup_tree_count(t));
+    cgroup_tree_close(t);
+    rmdir_retry(base);
+    printf("cgroup: %d failures\n", failures);
+    return failures ? 1 : 0;
+}
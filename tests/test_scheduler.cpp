@@ -0,0 +1,172 @@
+#include "scheduler.h"
+#include "trace_loader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+
+// make test: scheduler correctness.
+//
+// Golden: the five original algorithms (FCFS, SJF, RR q=2, Priority, MLQ) must print
+// exactly what the pre-engine simulator printed for each trace given on the command
+// line; the expected output is tests/golden/NAME.out for NAME.csv.
+//
+// Invariants: SRTF, PreemptivePriority and Fair on the same traces and on generated
+// ones, single-core and on K CPUs. On every CPU slices never overlap, no process runs
+// on two CPUs at once or before it arrives, its slices add up to its burst and its row
+// matches the Gantt chart. No CPU is idle while a process waits that it could run (any
+// waiting process with stealing, its own with --pin).
+
+static int failures;
+
+#define CHECK(cond, ...) do { if (!(cond)) { failures++; std::printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                                              std::printf(__VA_ARGS__); std::printf("\n"); return; } } while (0)
+
+// Same layout as bin/scheduler's printReport.
+static std::string format(const ScheduleReport& r) {
+    std::ostringstream os;
+    os << "Algorithm: " << r.algorithm << "\n";
+    os << "PID\tWaiting\tTurnaround\n";
+    for (auto& row : r.rows) os << row.pid << "\t" << row.waiting << "\t" << row.turnaround << "\n";
+    os << "Avg Waiting: " << r.avgWaiting << ", Avg Turnaround: " << r.avgTurnaround << ", Throughput: " << r.throughput << "\n";
+    if (!r.gantt.empty()) {
+        os << "Gantt: ";
+        for (auto& s : r.gantt) os << "|P" << s.pid << "(" << s.start << "-" << s.end << ")";
+        os << "| end=" << r.gantt.back().end << "\n";
+    }
+    return os.str();
+}
+
+static void checkGolden(const std::string& csv, const std::vector<Process>& procs) {
+    std::string name = csv.substr(csv.find_last_of('/') + 1);
+    std::string path = "tests/golden/" + name.substr(0, name.rfind('.')) + ".out";
+    std::ifstream in(path);
+    CHECK(in, "%s: cannot read", path.c_str());
+    std::stringstream ss;
+    ss << in.rdbuf();
+    std::string want = ss.str();
+    std::string got = format(runFCFS(procs)) + format(runSJF(procs)) + format(runRoundRobin(procs, 2)) +
+                      format(runPriority(procs)) + format(runMultilevelQueue(procs));
+    if (got == want) return;
+    size_t at = std::mismatch(got.begin(), got.end(), want.begin(), want.end()).first - got.begin();
+    size_t line = std::count(got.begin(), got.begin() + at, '\n') + 1;
+    CHECK(false, "%s: output differs from %s at line %zu", csv.c_str(), path.c_str(), line);
+}
+
+// Zero-length slices (zero bursts) sort before a slice starting at the same time.
+static bool byTime(const GanttSlice& a, const GanttSlice& b) {
+    return a.start != b.start ? a.start < b.start : a.end < b.end;
+}
+
+static void checkInvariants(const char* what, const std::vector<Process>& procs, const ScheduleReport& r,
+                            const SchedOptions& opt) {
+    std::map<int, const Process*> byPid;
+    for (auto& p : procs) byPid[p.pid] = &p;
+    std::vector<std::vector<GanttSlice>> cpu;
+    if (opt.cores > 1) for (auto& c : r.cores) cpu.push_back(c.gantt);
+    else cpu.push_back(r.gantt);
+    CHECK((int)cpu.size() == opt.cores, "%s: %zu CPU timelines for %d cores", what, cpu.size(), opt.cores);
+
+    std::map<int, std::vector<GanttSlice>> perPid;
+    for (size_t c = 0; c < cpu.size(); c++) {
+        std::sort(cpu[c].begin(), cpu[c].end(), byTime);
+        for (size_t i = 0; i < cpu[c].size(); i++) {
+            const GanttSlice& s = cpu[c][i];
+            CHECK(byPid.count(s.pid), "%s: CPU%zu runs unknown P%d", what, c, s.pid);
+            CHECK(s.start <= s.end, "%s: CPU%zu P%d runs %d-%d", what, c, s.pid, s.start, s.end);
+            CHECK(s.start >= byPid[s.pid]->arrival, "%s: P%d runs at %d before arriving at %d", what, s.pid, s.start,
+                  byPid[s.pid]->arrival);
+            CHECK(i == 0 || s.start >= cpu[c][i - 1].end, "%s: CPU%zu P%d (%d-%d) overlaps P%d (%d-%d)", what, c, s.pid,
+                  s.start, s.end, cpu[c][i - 1].pid, cpu[c][i - 1].start, cpu[c][i - 1].end);
+            CHECK(opt.affinity == Affinity::Free || (int)c == s.pid % opt.cores, "%s: pinned P%d ran on CPU%zu", what,
+                  s.pid, c);
+            perPid[s.pid].push_back(s);
+        }
+    }
+    std::map<int, int> finish;
+    CHECK(r.rows.size() == procs.size(), "%s: %zu rows for %zu processes", what, r.rows.size(), procs.size());
+    for (auto& row : r.rows) {
+        const Process& p = *byPid[row.pid];
+        auto& v = perPid[row.pid];
+        std::sort(v.begin(), v.end(), byTime);
+        long ran = 0;
+        for (size_t i = 0; i < v.size(); i++) {
+            CHECK(i == 0 || v[i].start >= v[i - 1].end, "%s: P%d runs on two CPUs at %d", what, row.pid, v[i].start);
+            ran += v[i].end - v[i].start;
+        }
+        CHECK(ran == p.burst, "%s: P%d ran %ld of its %d", what, row.pid, ran, p.burst);
+        CHECK(row.waiting == row.turnaround - p.burst, "%s: P%d waiting %d, turnaround %d, burst %d", what, row.pid,
+              row.waiting, row.turnaround, p.burst);
+        finish[row.pid] = p.arrival + row.turnaround;
+        if (p.burst > 0) CHECK(finish[row.pid] == v.back().end, "%s: P%d finishes at %d, last slice ends at %d", what,
+                               row.pid, finish[row.pid], v.back().end);
+    }
+
+    // Between consecutive event times nothing starts, ends or arrives.
+    std::vector<int> times;
+    for (auto& p : procs) times.push_back(p.arrival);
+    for (auto& c : cpu) for (auto& s : c) { times.push_back(s.start); times.push_back(s.end); }
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+    for (size_t k = 0; k + 1 < times.size(); k++) {
+        int t = times[k];
+        std::vector<int> running(cpu.size(), -1);
+        for (size_t c = 0; c < cpu.size(); c++)
+            for (auto& s : cpu[c]) if (s.start <= t && t < s.end) running[c] = s.pid;
+        for (auto& p : procs) {
+            if (p.arrival > t || finish[p.pid] <= t) continue;
+            if (std::find(running.begin(), running.end(), p.pid) != running.end()) continue;
+            for (size_t c = 0; c < cpu.size(); c++) {
+                bool eligible = opt.affinity == Affinity::Free || (int)c == p.pid % opt.cores;
+                CHECK(!eligible || running[c] >= 0, "%s: CPU%zu idle at %d while P%d waits", what, c, t, p.pid);
+            }
+        }
+    }
+}
+
+static void checkPolicies(const std::string& name, const std::vector<Process>& procs) {
+    struct Run { const char* tag; int cores; Affinity aff; };
+    static const Run runs[] = { { "1 CPU", 1, Affinity::Free }, { "2 CPUs", 2, Affinity::Free },
+                                { "4 CPUs", 4, Affinity::Free }, { "3 CPUs pinned", 3, Affinity::Pinned } };
+    for (const Run& run : runs) {
+        SchedOptions opt;
+        opt.cores = run.cores;
+        opt.affinity = run.aff;
+        opt.balance = Balance::Steal;
+        const ScheduleReport reps[] = { runSRTF(procs, opt), runPreemptivePriority(procs, opt), runFair(procs, opt) };
+        for (auto& r : reps) {
+            std::string what = name + " " + r.algorithm + " " + run.tag;
+            checkInvariants(what.c_str(), procs, r, opt);
+        }
+    }
+}
+
+// Ties, zero bursts and bursts of idle time, with pids unique.
+static std::vector<Process> generate(size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> gap(0, 6), burst(0, 15), prio(-5, 10);
+    std::vector<Process> p;
+    int t = 0;
+    for (size_t i = 0; i < n; i++) {
+        t += gap(rng) == 6 ? 40 : gap(rng) / 2;
+        p.push_back({(int)i + 1, t, burst(rng), prio(rng)});
+    }
+    return p;
+}
+
+int main(int argc, char** argv) {
+    int checked = 0;
+    for (int i = 1; i < argc; i++, checked++) {
+        std::vector<Process> procs = loadTrace(argv[i]);
+        if (procs.empty()) { std::printf("FAIL %s: no processes\n", argv[i]); failures++; continue; }
+        checkGolden(argv[i], procs);
+        checkPolicies(argv[i], procs);
+    }
+    for (unsigned seed = 1; seed <= 20; seed++, checked++)
+        checkPolicies("generated #" + std::to_string(seed), generate(150, seed));
+    std::printf("%d traces checked, %d failures\n", checked, failures);
+    return failures ? 1 : 0;
+}